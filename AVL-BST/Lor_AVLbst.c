@@ -10,8 +10,60 @@
 #include <stdio.h>
 
 static void Lor_AVL_traverser_init(Lor_AVL_traverser *, Lor_AVL_bst *restrict);
-static void tree_left_rotate(Lor_AVL_bst_node *);
-static void tree_right_rotate(Lor_AVL_bst_node *);
+static void tree_left_rotate(const Lor_AVL_bst *restrict, Lor_AVL_bst_node *);
+static void tree_right_rotate(const Lor_AVL_bst *restrict, Lor_AVL_bst_node *);
+static Lor_AVL_bst_node *tree_alloc_node(Lor_AVL_bst *restrict);
+static void tree_free_node(Lor_AVL_bst *restrict, Lor_AVL_bst_node *);
+static bool tree_keys_equal(const Lor_AVL_bst *restrict, const void *, const void *);
+static bool tree_is_threaded(const Lor_AVL_bst *restrict);
+static Lor_AVL_bst_node **tree_leaf_threads(Lor_AVL_bst_node *);
+static void tree_link_leafs(Lor_AVL_bst_node *, Lor_AVL_bst_node *);
+static void tree_move_node(Lor_AVL_bst *restrict, Lor_AVL_bst_node *, const Lor_AVL_bst_node *);
+static void *tree_summary(const Lor_AVL_bst *restrict, const Lor_AVL_bst_node *);
+static void tree_fix_size(const Lor_AVL_bst *restrict, Lor_AVL_bst_node *);
+static void tree_fix_summary(const Lor_AVL_bst *restrict, Lor_AVL_bst_node *);
+
+/**********************************************************
+ * Adapters that bind the tree allocator interface  to  the
+ * slab of a Lor_mem_pool.
+ **********************************************************/
+static void *__AVL_pool_alloc(void *ctx, size_t nbytes)
+{
+    return Lor_mem_pool_slab_alloc((Lor_mem_pool *) ctx, nbytes);
+}
+
+static void __AVL_pool_free_node(void *ctx, void *ptr, size_t nbytes)
+{
+    Lor_mem_pool_slab_free((Lor_mem_pool *) ctx, ptr, nbytes);
+}
+
+/**********************************************************
+ * Common part of the Lor_AVL_init* functions,  called once
+ * the node allocator of the tree has been set.
+ **********************************************************/
+static int __AVL_init_tree(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+                           Lor_AVL_free_data freedata)
+{
+    tree->nodealign = 0;
+    tree->nodesize = sizeof(Lor_AVL_bst_node);
+    tree->summaryoffset = sizeof(Lor_AVL_bst_node);
+    tree->aug = (Lor_AVL_augmentation){ .combine = NULL };
+    tree->sizes = false;
+    tree->root = tree_alloc_node(tree);
+    if (!tree->root) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    tree->root->subtrees[0] = NULL;  /* empty tree */
+    tree->root->subtrees[1] = NULL;
+    tree->root->height = 0;
+    tree->root->size = 0;
+
+    tree->compare = compare;
+    tree->nitems = 0;
+    tree->freedata = freedata;
+
+    return LOR_SUCCESS;
+}
 
 Lor_AVL_bst *Lor_AVL_create(void)
 {
@@ -36,13 +88,141 @@ int Lor_AVL_init(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare, Lor_AVL_al
     }
 
     tree->alloc = alloc;
-    tree->root = tree->alloc(sizeof *tree->root);
-    tree->root->subtrees[0] = NULL;  /* empty tree */
-
-    tree->compare = compare;
-    tree->nitems = 0;
     tree->freenode = (freenode) ? freenode : free;
-    tree->freedata = freedata;
+    tree->allocator = (Lor_AVL_allocator){ .alloc = NULL };
+    tree->pool = NULL;
+
+    return __AVL_init_tree(tree, compare, freedata);
+}
+
+int Lor_AVL_init_with_allocator(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+                             const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+    if (!allocator || !allocator->alloc) {
+        return LOR_ALLOC_FN_NOT_PROVIDED_ERR;
+    }
+
+    tree->alloc = NULL;
+    tree->freenode = NULL;
+    tree->allocator = *allocator;
+    tree->pool = NULL;
+
+    return __AVL_init_tree(tree, compare, freedata);
+}
+
+int Lor_AVL_init_with_pool(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+                        Lor_mem_pool *pool, Lor_AVL_free_data freedata)
+{
+    Lor_assert(pool, __func__, "argument pool must be non-NULL");
+
+    const Lor_AVL_allocator allocator = {
+        .alloc = __AVL_pool_alloc,
+        .freenode = __AVL_pool_free_node,
+        .ctx = pool,
+    };
+    int ret = Lor_AVL_init_with_allocator(tree, compare, &allocator, freedata);
+    if (ret == LOR_SUCCESS) {
+        tree->pool = pool;
+    }
+    return ret;
+}
+
+int Lor_AVL_set_node_alignment(Lor_AVL_bst *restrict tree, size_t align)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->pool) {
+        return LOR_NOT_POOL_BACKED_ERR;
+    }
+    if (align && !LOR_MEM_POOL_VALID_ALIGNMENT(align)) {
+        return LOR_INVALID_ALIGNMENT_ERR;
+    }
+
+    tree->nodealign = align;
+    /* The root node is allocated at initialization, move it if needed.
+     * Rotations never change the address of the root */
+    if (align && ((uintptr_t) tree->root & (align - 1))) {
+        Lor_AVL_bst_node *root = tree_alloc_node(tree);
+        if (!root) {
+            return LOR_ALLOC_FAIL_ERR;
+        }
+        tree_move_node(tree, root, tree->root);
+        tree_free_node(tree, tree->root);
+        tree->root = root;
+    }
+    return LOR_SUCCESS;
+}
+
+/**********************************************************
+ * Change the size of the nodes of an empty tree,  whose
+ * root is the only node to reallocate.
+ **********************************************************/
+static int __AVL_resize_nodes(Lor_AVL_bst *restrict tree, size_t summaryoffset, size_t summarysize)
+{
+    size_t nodesize = summaryoffset + summarysize;
+    if (tree->root->subtrees[0]) {
+        return LOR_TREE_NOT_EMPTY_ERR;
+    }
+
+    Lor_AVL_bst_node *oldroot = tree->root;
+    size_t oldsize = tree->nodesize;
+    tree->nodesize = nodesize;
+    Lor_AVL_bst_node *root = tree_alloc_node(tree);
+    tree->nodesize = oldsize;
+    if (!root) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    memset(root, 0, nodesize);
+    tree_free_node(tree, oldroot);
+    tree->nodesize = nodesize;
+    tree->summaryoffset = summaryoffset;
+    tree->root = root;
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_set_leaf_threads(Lor_AVL_bst *restrict tree, bool enable)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+
+    size_t summaryoffset = (enable) ? sizeof(Lor_AVL_threaded_node) : sizeof(Lor_AVL_bst_node);
+    if (summaryoffset == tree->summaryoffset) {
+        return LOR_SUCCESS;
+    }
+    return __AVL_resize_nodes(tree, summaryoffset, tree->nodesize - tree->summaryoffset);
+}
+
+int Lor_AVL_set_augmentation(Lor_AVL_bst *restrict tree, const Lor_AVL_augmentation *aug)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+    Lor_assert(!aug || (aug->size && aug->summarize && aug->combine && aug->identity), __func__,
+               "the size, functions and identity of argument aug must be set");
+
+    int ret = __AVL_resize_nodes(tree, tree->summaryoffset, (aug) ? aug->size : 0);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    tree->aug = (aug) ? *aug : (Lor_AVL_augmentation){ .combine = NULL };
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_set_subtree_sizes(Lor_AVL_bst *restrict tree, bool enable)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+
+    if (tree->root->subtrees[0]) {
+        return LOR_TREE_NOT_EMPTY_ERR;
+    }
+    tree->sizes = enable;
 
     return LOR_SUCCESS;
 }
@@ -63,8 +243,8 @@ int Lor_AVL_clear(Lor_AVL_bst *restrict tree)
         if (!p->subtrees[0]->subtrees[1]) { /* left of p is a leaf */
             q = p->subtrees[1];
             if (tree->freedata) tree->freedata(p->subtrees[0]->subtrees[0]);
-            tree->freenode(p->subtrees[0]);
-            tree->freenode(p);
+            tree_free_node(tree, p->subtrees[0]);
+            tree_free_node(tree, p);
         }
         else {
             q = p->subtrees[0];
@@ -74,7 +254,27 @@ int Lor_AVL_clear(Lor_AVL_bst *restrict tree)
     }
     /* free last leaf node */
     if (tree->freedata) tree->freedata(p->subtrees[0]);
-    tree->freenode(p);
+    tree_free_node(tree, p);
+
+    *tree = (Lor_AVL_bst){ .root = NULL, .nitems = 0 };
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_discard(Lor_AVL_bst *restrict tree, bool freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->root) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    if (!tree->pool) {
+        return LOR_NOT_POOL_BACKED_ERR;
+    }
+
+    if (freedata && tree->freedata && tree->root->subtrees[0]) {
+        Lor_AVL_traverse_lr(tree, tree->freedata);
+    }
+    Lor_mem_pool_discard(tree->pool, false);
 
     *tree = (Lor_AVL_bst){ .root = NULL, .nitems = 0 };
     return LOR_SUCCESS;
@@ -114,201 +314,862 @@ Lor_AVL_bst_node *Lor_AVL_find(Lor_AVL_bst *restrict tree, const void *key)
             tmpnode = tmpnode->subtrees[1];
         }
     }
-    return (!tree->compare(tmpnode->key, key)) ? tmpnode : NULL;
+    return (tree_keys_equal(tree, tmpnode->key, key)) ? tmpnode : NULL;
 }
 
-Lor_AVL_bst_node *Lor_AVL_interval_find(Lor_AVL_bst *restrict tree, const void *a, const void *b)
+size_t Lor_AVL_find_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+                          Lor_AVL_bst_node *out[])
 {
     Lor_assert(tree, __func__, "argument tree must be non-NULL");
-    Lor_assert(a && b, __func__, "arguments a and b must be non-NULL");
+    Lor_assert(!n || (keys && out), __func__, "arguments keys and out must be non-NULL");
 
-    Lor_AVL_bst_node *list = NULL;
-    Lor_AVL_bst_node **stack = malloc(2 * tree->nitems * sizeof(*stack));
-    if (!stack) {
-        LOR_PERROR("malloc failed", __func__);
-        return NULL;
+    if (!tree->root->subtrees[0]) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = NULL;
+        }
+        return 0;
     }
-    size_t top = 0;
-
-    stack[top++] = tree->root;
-    while (top) {
-        Lor_AVL_bst_node *tmpnode = stack[--top];
-        if (!tmpnode->subtrees[1]) { /* if leaf, test for interval */
-            if (tree->compare(tmpnode->key, a) >= 0 && tree->compare(tmpnode->key, b) < 0) {
-                Lor_AVL_bst_node *newnode = tree->alloc(sizeof *newnode);
-                newnode->key = tmpnode->key;
-                newnode->subtrees[0] = tmpnode->subtrees[0];
-                newnode->subtrees[1] = list;
-                list = newnode;
+
+    size_t nfound = 0;
+    for (size_t first = 0; first < n; first += LOR_AVL_FIND_BATCH_GROUP) {
+        size_t ngroup = (n - first < LOR_AVL_FIND_BATCH_GROUP) ? n - first : LOR_AVL_FIND_BATCH_GROUP;
+        const void *const *gkeys = keys + first;
+        Lor_AVL_bst_node **gnodes = out + first;  /* current node of each search */
+
+        for (size_t i = 0; i < ngroup; i++) {
+            Lor_assert(gkeys[i], __func__, "the keys must be non-NULL");
+            gnodes[i] = tree->root;
+        }
+        /* One level down for each search in turn: a node prefetched is
+         * only read on the next round, after the rest of the group */
+        size_t nmoved;
+        do {
+            nmoved = 0;
+            for (size_t i = 0; i < ngroup; i++) {
+                Lor_AVL_bst_node *node = gnodes[i];
+                if (!node->subtrees[1]) { /* this search reached its leaf */
+                    continue;
+                }
+                node = node->subtrees[tree->compare(node->key, gkeys[i]) <= 0];
+                LOR_AVL_PREFETCH(node);
+                gnodes[i] = node;
+                nmoved++;
+            }
+        } while (nmoved);
+        for (size_t i = 0; i < ngroup; i++) {
+            if (tree_keys_equal(tree, gnodes[i]->key, gkeys[i])) {
+                nfound++;
+            }
+            else {
+                gnodes[i] = NULL;
             }
         }
-        /* Else, search for interval */
-        else if (tree->compare(tmpnode->key, b) >= 0) {
-            stack[top++] = tmpnode->subtrees[0];
+    }
+    return nfound;
+}
+
+int Lor_AVL_rank(Lor_AVL_bst *restrict tree, const void *key, size_t *rank)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+    Lor_assert(rank, __func__, "argument rank must be non-NULL");
+
+    if (!tree->sizes) {
+        return LOR_NO_SUBTREE_SIZES_ERR;
+    }
+    *rank = 0;
+    if (!tree->root->subtrees[0]) {
+        return LOR_SUCCESS;
+    }
+
+    Lor_AVL_bst_node *tmpnode = tree->root;
+    while (tmpnode->subtrees[1]) {
+        if (tree->compare(tmpnode->key, key) > 0) {
+            tmpnode = tmpnode->subtrees[0];
+        }
+        else { /* the whole left subtree is smaller than key */
+            *rank += tmpnode->subtrees[0]->size;
+            tmpnode = tmpnode->subtrees[1];
         }
-        else if (tree->compare(tmpnode->key, a) <= 0) {
-            stack[top++] = tmpnode->subtrees[1];
+    }
+    *rank += (tree->compare(tmpnode->key, key) < 0);
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_select(Lor_AVL_bst *restrict tree, size_t i, Lor_AVL_bst_node **leaf)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(leaf, __func__, "argument leaf must be non-NULL");
+
+    if (!tree->sizes) {
+        return LOR_NO_SUBTREE_SIZES_ERR;
+    }
+    *leaf = NULL;
+    if (i >= tree->nitems) {
+        return LOR_SUCCESS;
+    }
+
+    Lor_AVL_bst_node *tmpnode = tree->root;
+    while (tmpnode->subtrees[1]) {
+        size_t leftsize = tmpnode->subtrees[0]->size;
+        if (i < leftsize) {
+            tmpnode = tmpnode->subtrees[0];
         }
         else {
-            stack[top++] = tmpnode->subtrees[0];
-            stack[top++] = tmpnode->subtrees[1];
+            i -= leftsize;
+            tmpnode = tmpnode->subtrees[1];
         }
     }
-    return list;
+    *leaf = tmpnode;
+    return LOR_SUCCESS;
 }
 
-inline void *Lor_AVL_get_data_from_node(Lor_AVL_bst_node *node)
+int Lor_AVL_count_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, size_t *count)
 {
-    Lor_assert(node, __func__, "argument node must be non-NULL");
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(a && b, __func__, "arguments a and b must be non-NULL");
+    Lor_assert(count, __func__, "argument count must be non-NULL");
 
-    if (node->subtrees[1]) { /* not a leaf node */
+    if (!tree->sizes) {
+        return LOR_NO_SUBTREE_SIZES_ERR;
+    }
+    *count = 0;
+    if (tree->compare(a, b) >= 0) {
+        return LOR_SUCCESS;
+    }
+    size_t ra, rb;
+    Lor_AVL_rank(tree, a, &ra);
+    Lor_AVL_rank(tree, b, &rb);
+    *count = rb - ra;
+    return LOR_SUCCESS;
+}
+
+/**********************************************************
+ * Descend from node to a leaf, always  taking  the  side
+ * subtree, and pushing the internal nodes on the stack  of
+ * the cursor.
+ **********************************************************/
+static Lor_AVL_bst_node *__AVL_cursor_descend(Lor_AVL_cursor *cur, Lor_AVL_bst_node *node, int side)
+{
+    while (node->subtrees[1]) {
+        Lor_assert(cur->height < LOR_AVL_BST_MAX_HEIGHT, __func__, "cursor stack overflow");
+        cur->stack[cur->height++] = node;
+        node = node->subtrees[side];
+    }
+    return cur->leaf = node;
+}
+
+/* Search for key from node down, node being on the cursor path at
+ * cur->height */
+static Lor_AVL_bst_node *__AVL_cursor_seek_from(Lor_AVL_cursor *cur, Lor_AVL_bst_node *node,
+                                                const void *key)
+{
+    Lor_AVL_bst_node *tmpnode = node;
+    while (tmpnode->subtrees[1]) {
+        Lor_assert(cur->height < LOR_AVL_BST_MAX_HEIGHT, __func__, "cursor stack overflow");
+        cur->stack[cur->height++] = tmpnode;
+        tmpnode = tmpnode->subtrees[cur->tree->compare(tmpnode->key, key) <= 0];
+    }
+    return cur->leaf = tmpnode;
+}
+
+/**********************************************************
+ * Position the cursor on the leaf where a search for  key
+ * ends, as in Lor_AVL_find.
+ **********************************************************/
+static Lor_AVL_bst_node *__AVL_cursor_seek(Lor_AVL_cursor *cur, const void *key)
+{
+    cur->height = 0;
+    cur->leaf = NULL;
+    if (!cur->tree->root->subtrees[0]) { /* empty tree */
         return NULL;
     }
-    return (void *) node->subtrees[0];
+    return __AVL_cursor_seek_from(cur, cur->tree->root, key);
 }
 
-void Lor_AVL_process_node_list(Lor_AVL_bst_node *nodelst, Lor_AVL_map mapfn)
+/**********************************************************
+ * Move the cursor to the neighbour leaf on the dir  side
+ * (1: next, 0: previous): climb up to the first  ancestor
+ * entered from the other side, then descend its dir subtree.
+ **********************************************************/
+static Lor_AVL_bst_node *__AVL_cursor_step(Lor_AVL_cursor *cur, int dir)
 {
-    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
-    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+    if (!cur->leaf) {
+        return NULL;
+    }
 
-    for (Lor_AVL_bst_node *p = nodelst; p; p = p->subtrees[1]) {
-        mapfn(p->subtrees[0]);
+    Lor_AVL_bst_node *child = cur->leaf;
+    while (cur->height) {
+        Lor_AVL_bst_node *parent = cur->stack[cur->height - 1];
+        if (parent->subtrees[!dir] == child) {
+            return __AVL_cursor_descend(cur, parent->subtrees[dir], !dir);
+        }
+        child = parent;
+        cur->height--;
     }
+    return cur->leaf = NULL;
 }
 
-void Lor_AVL_clear_node_list(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *nodelst)
+void Lor_AVL_cursor_init(Lor_AVL_cursor *cur, Lor_AVL_bst *restrict tree)
 {
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
     Lor_assert(tree, __func__, "argument tree must be non-NULL");
-    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
 
-    Lor_AVL_bst_node *q = NULL;
-    for (Lor_AVL_bst_node *p = nodelst; p; p = q) {
-        q = p->subtrees[1];
-        tree->freenode(p);
+    cur->tree = tree;
+    cur->leaf = NULL;
+    cur->height = 0;
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_first(Lor_AVL_cursor *cur)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+
+    cur->height = 0;
+    if (!cur->tree->root->subtrees[0]) {
+        return cur->leaf = NULL;
     }
+    return __AVL_cursor_descend(cur, cur->tree->root, 0);
 }
 
-int Lor_AVL_insert(Lor_AVL_bst *restrict tree, void *key, void *data)
+Lor_AVL_bst_node *Lor_AVL_cursor_last(Lor_AVL_cursor *cur)
 {
-    Lor_assert(tree, __func__, "argument tree must be non-NULL");
-    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
-    Lor_assert(key && data, __func__, "arguments key and data must be non-NULL");
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
 
-    if (!tree->root->subtrees[0]) {  /* empty tree */
-        tree->root->subtrees[0] = (Lor_AVL_bst_node *) data;
-        tree->root->subtrees[1] = NULL;
-        tree->root->key = key;
-        tree->root->height = 0;
-        tree->nitems++;
+    cur->height = 0;
+    if (!cur->tree->root->subtrees[0]) {
+        return cur->leaf = NULL;
     }
-    else {
-        Lor_AVL_traverser trav;
-        Lor_AVL_traverser_init(&trav, tree);
+    return __AVL_cursor_descend(cur, cur->tree->root, 1);
+}
 
-        while (trav.current->subtrees[1] && trav.height <= LOR_AVL_BST_MAX_HEIGHT) {
-            trav.stack[trav.height++] = trav.current;  /* for rebalancing */
-            if (tree->compare(key, trav.current->key) < 0) {
-                trav.current = trav.current->subtrees[0];
-            }
-            else {
-                trav.current = trav.current->subtrees[1];
-            }
-        }
-        if (trav.height > LOR_AVL_BST_MAX_HEIGHT){
-            return LOR_MAX_HEIGHT_ERR;
-        }
-        /* Found a candidate leaf */
-        if (!tree->compare(trav.current->key, key)) { /* permit only distinct keys */
-#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
-            return LOR_DISTINCT_KEY_ERR;
-#else  /* Updates the data if try same key insertion */
-            void *tmpdata = (void *) trav.current->subtrees[0];
-            trav.current->subtrees[0] = (Lor_AVL_bst_node *) data;
-            if (tree->freedata) tree->freedata(tmpdata);
-            return LOR_SUCCESS;
-#endif
-        }
+Lor_AVL_bst_node *Lor_AVL_cursor_lower_bound(Lor_AVL_cursor *cur, const void *key)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    Lor_AVL_bst_node *leaf = __AVL_cursor_seek(cur, key);
+    if (leaf && cur->tree->compare(leaf->key, key) < 0) {
+        return __AVL_cursor_step(cur, 1);
+    }
+    return leaf;
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_upper_bound(Lor_AVL_cursor *cur, const void *key)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
 
-        Lor_AVL_bst_node *oldleaf = tree->alloc(sizeof *oldleaf);
-        oldleaf->key = trav.current->key;
-        oldleaf->subtrees[0] = trav.current->subtrees[0];
-        oldleaf->subtrees[1] = NULL;
-        oldleaf->height = 0;
+    Lor_AVL_bst_node *leaf = __AVL_cursor_seek(cur, key);
+    if (leaf && cur->tree->compare(leaf->key, key) <= 0) {
+        return __AVL_cursor_step(cur, 1);
+    }
+    return leaf;
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_floor(Lor_AVL_cursor *cur, const void *key)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    Lor_AVL_bst_node *leaf = __AVL_cursor_seek(cur, key);
+    if (leaf && cur->tree->compare(leaf->key, key) > 0) {
+        return __AVL_cursor_step(cur, 0);
+    }
+    return leaf;
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_ceiling(Lor_AVL_cursor *cur, const void *key)
+{
+    return Lor_AVL_cursor_lower_bound(cur, key);
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_next(Lor_AVL_cursor *cur)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+
+    return __AVL_cursor_step(cur, 1);
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_prev(Lor_AVL_cursor *cur)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
 
-        Lor_AVL_bst_node *newleaf = tree->alloc(sizeof *newleaf);
-        newleaf->key = key;
-        newleaf->subtrees[0] = (Lor_AVL_bst_node *) data;
-        newleaf->subtrees[1] = NULL;
-        newleaf->height = 0;
+    return __AVL_cursor_step(cur, 0);
+}
 
-        if (tree->compare(trav.current->key, key) < 0) {
-            trav.current->subtrees[0] = oldleaf;
-            trav.current->subtrees[1] = newleaf;
-            trav.current->key = key;
+/**********************************************************
+ * Combine into acc the summaries of the items of  the
+ * subtree node in [a, b[, a or b NULL for no limit.  Once
+ * the searches of a and b part, each side follows a single
+ * path and takes whole subtrees, so this is O(log n).
+ **********************************************************/
+static void __AVL_aggregate(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node,
+                            const void *a, const void *b, void *acc)
+{
+    for (;;) {
+        if (!a && !b) {
+            tree->aug.combine(acc, acc, tree_summary(tree, node));
+            return;
         }
-        else {
-            trav.current->subtrees[0] = newleaf;
-            trav.current->subtrees[1] = oldleaf;
+        if (!node->subtrees[1]) { /* if leaf, test for interval */
+            if ((!a || tree->compare(node->key, a) >= 0) && (!b || tree->compare(node->key, b) < 0)) {
+                tree->aug.combine(acc, acc, tree_summary(tree, node));
+            }
+            return;
+        }
+        if (b && tree->compare(node->key, b) >= 0) {
+            node = node->subtrees[0];
+        }
+        else if (a && tree->compare(node->key, a) <= 0) {
+            node = node->subtrees[1];
+        }
+        else { /* the searches of a and b part here */
+            __AVL_aggregate(tree, node->subtrees[0], a, NULL, acc);
+            node = node->subtrees[1];
+            a = NULL;
         }
+    }
+}
 
-        trav.current->height = 1;
-        ++tree->nitems;
-        /* Rebalance */
-        while (trav.height) {
-            trav.current = trav.stack[--trav.height];
-            int32_t oldheight = trav.current->height;
+void Lor_AVL_range_aggregate(Lor_AVL_bst *restrict tree, const void *a, const void *b, void *result)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(result, __func__, "argument result must be non-NULL");
+    Lor_assert(tree->aug.combine, __func__, "tree must have an augmentation");
 
-            if (trav.current->subtrees[0]->height - trav.current->subtrees[1]->height == 2) {
-                /* Left-left unbalanced */
-                if (trav.current->subtrees[0]->subtrees[0]->height - trav.current->subtrees[1]->height == 1) {
-                    tree_right_rotate(trav.current);
-                    trav.current->subtrees[1]->height = trav.current->subtrees[1]->subtrees[0]->height + 1;
-                    trav.current->height = trav.current->subtrees[1]->height + 1;
-                }
-                /* Left-right unbalanced */
-                else {
-                    tree_left_rotate(trav.current->subtrees[0]);
-                    tree_right_rotate(trav.current);
-                    int32_t tmpheight = trav.current->subtrees[0]->subtrees[0]->height;
-                    trav.current->subtrees[0]->height = tmpheight + 1;
-                    trav.current->subtrees[1]->height = tmpheight + 1;
-                    trav.current->height = tmpheight + 2;
-                }
+    memcpy(result, tree->aug.identity, tree->aug.size);
+    if (!tree->root->subtrees[0]) { /* empty tree */
+        return;
+    }
+    if (a && b && tree->compare(a, b) >= 0) {
+        return;
+    }
+    __AVL_aggregate(tree, tree->root, a, b, result);
+}
+
+Lor_AVL_bst_node *Lor_AVL_interval_find(Lor_AVL_bst *restrict tree, const void *a, const void *b)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(a && b, __func__, "arguments a and b must be non-NULL");
+
+    Lor_AVL_bst_node *list = NULL;
+    Lor_AVL_bst_node **tail = &list;
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+
+    for (Lor_AVL_bst_node *leaf = Lor_AVL_cursor_lower_bound(&cur, a);
+         leaf && tree->compare(leaf->key, b) < 0; leaf = Lor_AVL_cursor_next(&cur)) {
+        Lor_AVL_bst_node *newnode = tree_alloc_node(tree);
+        if (!newnode) {
+            if (list) {
+                Lor_AVL_clear_node_list(tree, list);
             }
-            else if (trav.current->subtrees[0]->height - trav.current->subtrees[1]->height == -2) {
-                /* Right-right unbalanced */
-                if (trav.current->subtrees[1]->subtrees[1]->height - trav.current->subtrees[0]->height == 1) {
-                    tree_left_rotate(trav.current);
-                    trav.current->subtrees[0]->height = trav.current->subtrees[0]->subtrees[1]->height + 1;
-                    trav.current->height = trav.current->subtrees[0]->height + 1;
-                }
-                /* Right-left unbalanced */
-                else {
-                    tree_right_rotate(trav.current->subtrees[1]);
-                    tree_left_rotate(trav.current);
-                    int32_t tmpheight = trav.current->subtrees[1]->subtrees[1]->height;
-                    trav.current->subtrees[0]->height = tmpheight + 1;
-                    trav.current->subtrees[1]->height = tmpheight + 1;
-                    trav.current->height = tmpheight + 2;
-                }
+            return NULL;
+        }
+        newnode->key = leaf->key;
+        newnode->subtrees[0] = leaf->subtrees[0];
+        newnode->subtrees[1] = NULL;
+        *tail = newnode;
+        tail = &newnode->subtrees[1];
+    }
+    return list;
+}
+
+void *Lor_AVL_get_key_from_node(Lor_AVL_bst_node *node)
+{
+    Lor_assert(node, __func__, "argument node must be non-NULL");
+
+    if (node->subtrees[1]) { /* not a leaf node */
+        return NULL;
+    }
+    return node->key;
+}
+
+Lor_AVL_bst_node *Lor_AVL_successor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(leaf && !leaf->subtrees[1], __func__, "argument leaf must be a leaf node");
+
+    if (tree_is_threaded(tree)) {
+        return tree_leaf_threads(leaf)[1];
+    }
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+    return Lor_AVL_cursor_upper_bound(&cur, leaf->key);
+}
+
+Lor_AVL_bst_node *Lor_AVL_predecessor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(leaf && !leaf->subtrees[1], __func__, "argument leaf must be a leaf node");
+
+    if (tree_is_threaded(tree)) {
+        return tree_leaf_threads(leaf)[0];
+    }
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+    if (!Lor_AVL_cursor_lower_bound(&cur, leaf->key)) {
+        return NULL;
+    }
+    return Lor_AVL_cursor_prev(&cur);
+}
+
+inline void *Lor_AVL_get_data_from_node(Lor_AVL_bst_node *node)
+{
+    Lor_assert(node, __func__, "argument node must be non-NULL");
+
+    if (node->subtrees[1]) { /* not a leaf node */
+        return NULL;
+    }
+    return (void *) node->subtrees[0];
+}
+
+void Lor_AVL_process_node_list(Lor_AVL_bst_node *nodelst, Lor_AVL_map mapfn)
+{
+    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    for (Lor_AVL_bst_node *p = nodelst; p; p = p->subtrees[1]) {
+        mapfn(p->subtrees[0]);
+    }
+}
+
+void Lor_AVL_clear_node_list(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *nodelst)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
+
+    Lor_AVL_bst_node *q = NULL;
+    for (Lor_AVL_bst_node *p = nodelst; p; p = q) {
+        q = p->subtrees[1];
+        tree_free_node(tree, p);
+    }
+}
+
+/**********************************************************
+ * Insert key at the leaf 'current' found by a search  for
+ * it, with the 'height' nodes above it in 'stack', and
+ * rebalance.  The nodes keep their place, but the path
+ * below stack[*rotated] may have been rotated; *rotated
+ * is 'height' if there was no rotation.
+ **********************************************************/
+static int __AVL_insert_at(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node **stack, size_t height,
+                           Lor_AVL_bst_node *current, void *key, void *data, size_t *rotated)
+{
+    *rotated = height;
+    /* Found a candidate leaf */
+    if (tree_keys_equal(tree, current->key, key)) { /* permit only distinct keys */
+#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
+        return LOR_DISTINCT_KEY_ERR;
+#else  /* Updates the data if try same key insertion */
+        void *tmpdata = (void *) current->subtrees[0];
+        current->subtrees[0] = (Lor_AVL_bst_node *) data;
+        if (tree->freedata) tree->freedata(tmpdata);
+        tree_fix_summary(tree, current);
+        while (height) {
+            tree_fix_summary(tree, stack[--height]);
+        }
+        return LOR_SUCCESS;
+#endif
+    }
+    if (tree->nitems == UINT32_MAX) { /* the subtree sizes would overflow */
+        return LOR_MAX_ITEMS_ERR;
+    }
+
+    Lor_AVL_bst_node *oldleaf = tree_alloc_node(tree);
+    if (!oldleaf) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    Lor_AVL_bst_node *newleaf = tree_alloc_node(tree);
+    if (!newleaf) {
+        tree_free_node(tree, oldleaf);
+        return LOR_ALLOC_FAIL_ERR;
+    }
+
+    oldleaf->key = current->key;
+    oldleaf->subtrees[0] = current->subtrees[0];
+    oldleaf->subtrees[1] = NULL;
+    oldleaf->height = 0;
+    oldleaf->size = 1;
+
+    newleaf->key = key;
+    newleaf->subtrees[0] = (Lor_AVL_bst_node *) data;
+    newleaf->subtrees[1] = NULL;
+    newleaf->height = 0;
+    newleaf->size = 1;
+
+    if (tree->compare(current->key, key) < 0) {
+        current->subtrees[0] = oldleaf;
+        current->subtrees[1] = newleaf;
+        current->key = key;
+    }
+    else {
+        current->subtrees[0] = newleaf;
+        current->subtrees[1] = oldleaf;
+    }
+    if (tree_is_threaded(tree)) { /* the two leafs replace the old one */
+        Lor_AVL_bst_node **threads = tree_leaf_threads(current);
+        Lor_AVL_bst_node *next = threads[1];
+        tree_link_leafs(threads[0], current->subtrees[0]);
+        tree_link_leafs(current->subtrees[0], current->subtrees[1]);
+        tree_link_leafs(current->subtrees[1], next);
+    }
+
+    current->height = 1;
+    current->size = 2;
+    tree_fix_summary(tree, oldleaf);
+    tree_fix_summary(tree, newleaf);
+    tree_fix_summary(tree, current);
+    ++tree->nitems;
+    /* Every subtree on the path gained a leaf; the rotations below
+     * recompute the sizes and summaries of the nodes they move.  Only
+     * trees with sizes or summaries pay for this walk of the whole path:
+     * without them the rebalance stops at the first node whose height
+     * did not change. */
+    if (tree->sizes || tree->aug.combine) {
+        for (size_t i = height; i--; ) {
+            if (tree->sizes) stack[i]->size++;
+            tree_fix_summary(tree, stack[i]);
+        }
+    }
+    /* Rebalance */
+    while (height) {
+        current = stack[--height];
+        int32_t oldheight = current->height;
+
+        if (current->subtrees[0]->height - current->subtrees[1]->height == 2) {
+            *rotated = height;
+            /* Left-left unbalanced */
+            if (current->subtrees[0]->subtrees[0]->height - current->subtrees[1]->height == 1) {
+                tree_right_rotate(tree, current);
+                current->subtrees[1]->height = current->subtrees[1]->subtrees[0]->height + 1;
+                current->height = current->subtrees[1]->height + 1;
             }
-            else { /* update height even if there was no rotation */
-                if (trav.current->subtrees[0]->height > trav.current->subtrees[1]->height) {
-                    trav.current->height = 1 + trav.current->subtrees[0]->height;
-                }
-                else {
-                    trav.current->height = 1 + trav.current->subtrees[1]->height;
-                }
+            /* Left-right unbalanced */
+            else {
+                tree_left_rotate(tree, current->subtrees[0]);
+                tree_right_rotate(tree, current);
+                int32_t tmpheight = current->subtrees[0]->subtrees[0]->height;
+                current->subtrees[0]->height = tmpheight + 1;
+                current->subtrees[1]->height = tmpheight + 1;
+                current->height = tmpheight + 2;
             }
-            if (trav.current->height == oldheight)
+        }
+        else if (current->subtrees[0]->height - current->subtrees[1]->height == -2) {
+            *rotated = height;
+            /* Right-right unbalanced */
+            if (current->subtrees[1]->subtrees[1]->height - current->subtrees[0]->height == 1) {
+                tree_left_rotate(tree, current);
+                current->subtrees[0]->height = current->subtrees[0]->subtrees[1]->height + 1;
+                current->height = current->subtrees[0]->height + 1;
+            }
+            /* Right-left unbalanced */
+            else {
+                tree_right_rotate(tree, current->subtrees[1]);
+                tree_left_rotate(tree, current);
+                int32_t tmpheight = current->subtrees[1]->subtrees[1]->height;
+                current->subtrees[0]->height = tmpheight + 1;
+                current->subtrees[1]->height = tmpheight + 1;
+                current->height = tmpheight + 2;
+            }
+        }
+        else { /* update height even if there was no rotation */
+            if (current->subtrees[0]->height > current->subtrees[1]->height) {
+                current->height = 1 + current->subtrees[0]->height;
+            }
+            else {
+                current->height = 1 + current->subtrees[1]->height;
+            }
+        }
+        if (current->height == oldheight)
+            break;
+    }
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_insert(Lor_AVL_bst *restrict tree, void *key, void *data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+    Lor_assert(key && data, __func__, "arguments key and data must be non-NULL");
+
+    if (!tree->root->subtrees[0]) {  /* empty tree */
+        tree->root->subtrees[0] = (Lor_AVL_bst_node *) data;
+        tree->root->subtrees[1] = NULL;
+        tree->root->key = key;
+        tree->root->height = 0;
+        tree->root->size = 1;
+        if (tree_is_threaded(tree)) {
+            tree_link_leafs(NULL, tree->root);
+            tree_link_leafs(tree->root, NULL);
+        }
+        tree_fix_summary(tree, tree->root);
+        tree->nitems++;
+    }
+    else {
+        Lor_AVL_traverser trav;
+        Lor_AVL_traverser_init(&trav, tree);
+
+        while (trav.current->subtrees[1] && trav.height <= LOR_AVL_BST_MAX_HEIGHT) {
+            trav.stack[trav.height++] = trav.current;  /* for rebalancing */
+            if (tree->compare(key, trav.current->key) < 0) {
+                trav.current = trav.current->subtrees[0];
+            }
+            else {
+                trav.current = trav.current->subtrees[1];
+            }
+        }
+        if (trav.height > LOR_AVL_BST_MAX_HEIGHT){
+            return LOR_MAX_HEIGHT_ERR;
+        }
+        size_t rotated;
+        return __AVL_insert_at(tree, trav.stack, trav.height, trav.current, key, data, &rotated);
+    }
+
+    return LOR_SUCCESS;
+}
+
+/**********************************************************
+ * Position the cursor on the leaf where a search for  key
+ * ends, starting from where the cursor is: go up the path
+ * only to the deepest node whose subtree spans key,  and
+ * down from there.  Keys close to the previous one  cost
+ * O(1) amortized key comparisons, any other key no  more
+ * than a search from the root.  The walk up still visits
+ * every node of the stack when no ancestor bounds key, as
+ * past the greatest key, but compares keys only at  the
+ * ancestors whose separator lies between the leaf and key.
+ **********************************************************/
+static Lor_AVL_bst_node *__AVL_cursor_finger(Lor_AVL_cursor *cur, const void *key)
+{
+    if (!cur->leaf) {
+        return __AVL_cursor_seek(cur, key);
+    }
+    int32_t cmp = cur->tree->compare(key, cur->leaf->key);
+    if (!cmp) {
+        return cur->leaf;
+    }
+
+    /* Past the leaf on side 1 (0), key is below the lower (upper)  limits
+     * of all the subtrees of the path: only the separators of the parents
+     * entered by their subtree 0 (1) limit it */
+    int side = (cmp > 0);
+    size_t pos = cur->height;
+    Lor_AVL_bst_node *child = cur->leaf;
+    for (size_t i = cur->height; i--; child = cur->stack[i]) {
+        Lor_AVL_bst_node *parent = cur->stack[i];
+        if (parent->subtrees[!side] == child) {
+            if ((cur->tree->compare(key, parent->key) >= 0) != side) {
                 break;
+            }
+            pos = i;
+        }
+    }
+
+    Lor_AVL_bst_node *node = (pos == cur->height) ? cur->leaf : cur->stack[pos];
+    cur->height = pos;
+    return __AVL_cursor_seek_from(cur, node, key);
+}
+
+Lor_AVL_bst_node *Lor_AVL_cursor_find(Lor_AVL_cursor *cur, const void *key)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    Lor_AVL_bst_node *leaf = __AVL_cursor_finger(cur, key);
+    return (leaf && tree_keys_equal(cur->tree, leaf->key, key)) ? leaf : NULL;
+}
+
+int Lor_AVL_cursor_insert(Lor_AVL_cursor *cur, void *key, void *data)
+{
+    Lor_assert(cur, __func__, "argument cur must be non-NULL");
+    Lor_assert(key && data, __func__, "arguments key and data must be non-NULL");
+
+    Lor_AVL_bst *tree = cur->tree;
+    if (!tree->root->subtrees[0]) {  /* empty tree */
+        int ret = Lor_AVL_insert(tree, key, data);
+        cur->height = 0;
+        cur->leaf = tree->root;
+        return ret;
+    }
+
+    Lor_AVL_bst_node *leaf = __AVL_cursor_finger(cur, key);
+    size_t height = cur->height;
+    if (height >= LOR_AVL_BST_MAX_HEIGHT) {  /* no room for the new leaf */
+        return LOR_MAX_HEIGHT_ERR;
+    }
+    size_t rotated;
+    int ret = __AVL_insert_at(tree, cur->stack, height, leaf, key, data, &rotated);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    /* The path is right down to the first rotated node, find the leaf of
+     * key again from there */
+    Lor_AVL_bst_node *node = (rotated == height) ? leaf : cur->stack[rotated];
+    cur->height = rotated;
+    __AVL_cursor_seek_from(cur, node, key);
+    return LOR_SUCCESS;
+}
+
+size_t Lor_AVL_find_sorted_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+                                 Lor_AVL_bst_node *out[])
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(!n || (keys && out), __func__, "arguments keys and out must be non-NULL");
+
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+
+    size_t nfound = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = Lor_AVL_cursor_find(&cur, keys[i]);
+        nfound += (out[i] != NULL);
+    }
+    return nfound;
+}
+
+/* Source of the items of Lor_AVL_build_* */
+typedef struct {
+    Lor_AVL_next_item next;
+    void *ctx;
+    void *lastkey;               /* NULL before the first item */
+    Lor_AVL_bst_node *lastleaf;  /* to thread the leafs, NULL before the first item */
+} AVL_build_source;
+
+typedef struct {
+    void *const *keys;
+    void *const *data;
+    size_t i;
+} AVL_build_arrays;
+
+static bool __AVL_next_from_arrays(void *ctx, void **key, void **data)
+{
+    AVL_build_arrays *arrays = ctx;
+    *key = arrays->keys[arrays->i];
+    *data = arrays->data[arrays->i++];
+    return true;
+}
+
+/* Free the nodes of a subtree, but not the data */
+static void __AVL_free_subtree(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    if (node->subtrees[1]) {
+        __AVL_free_subtree(tree, node->subtrees[0]);
+        __AVL_free_subtree(tree, node->subtrees[1]);
+    }
+    tree_free_node(tree, node);
+}
+
+/**********************************************************
+ * Fill 'node' with a balanced subtree of the next n items
+ * of 'src', and store its smallest key in *minkey.  The
+ * left subtree takes the larger half, so the heights of
+ * the subtrees differ by at most one.  On error,  nothing
+ * allocated below 'node' is left.
+ **********************************************************/
+static int __AVL_build(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node, size_t n,
+                       AVL_build_source *src, void **minkey)
+{
+    if (n == 1) {
+        void *key, *data;
+        if (!src->next(src->ctx, &key, &data)) {
+            return LOR_SRC_EMPTY_WARN;
         }
+        Lor_assert(key && data, __func__, "the keys and data must be non-NULL");
+        if (src->lastkey && tree->compare(src->lastkey, key) >= 0) {
+            return LOR_UNSORTED_KEYS_ERR;
+        }
+        src->lastkey = key;
+
+        node->height = 0;
+        node->size = 1;
+        node->key = key;
+        node->subtrees[0] = (Lor_AVL_bst_node *) data;
+        node->subtrees[1] = NULL;
+        if (tree_is_threaded(tree)) {
+            tree_link_leafs(src->lastleaf, node);
+            tree_link_leafs(node, NULL);
+        }
+        src->lastleaf = node;
+        tree_fix_summary(tree, node);
+        *minkey = key;
+        return LOR_SUCCESS;
+    }
+
+    Lor_AVL_bst_node *left = tree_alloc_node(tree);
+    if (!left) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    int ret = __AVL_build(tree, left, n - n / 2, src, minkey);
+    if (ret != LOR_SUCCESS) {
+        tree_free_node(tree, left);
+        return ret;
+    }
+
+    Lor_AVL_bst_node *right = tree_alloc_node(tree);
+    if (!right) {
+        __AVL_free_subtree(tree, left);
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    void *rightmin;
+    ret = __AVL_build(tree, right, n / 2, src, &rightmin);
+    if (ret != LOR_SUCCESS) {
+        tree_free_node(tree, right);
+        __AVL_free_subtree(tree, left);
+        return ret;
     }
 
+    node->height = 1 + ((left->height > right->height) ? left->height : right->height);
+    node->key = rightmin;
+    node->subtrees[0] = left;
+    node->subtrees[1] = right;
+    tree_fix_size(tree, node);
+    tree_fix_summary(tree, node);
     return LOR_SUCCESS;
 }
 
+int Lor_AVL_build_from_iter(Lor_AVL_bst *restrict tree, Lor_AVL_next_item next, void *ctx, size_t n)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+    Lor_assert(next, __func__, "argument next must be non-NULL");
+
+    if (tree->root->subtrees[0]) {
+        return LOR_TREE_NOT_EMPTY_ERR;
+    }
+    if (!n) {
+        return LOR_SUCCESS;
+    }
+    if (n > UINT32_MAX) {  /* the subtree sizes would overflow */
+        return LOR_MAX_ITEMS_ERR;
+    }
+    /* A perfectly balanced leaf tree of n items has height ceil(log2(n)) */
+    size_t height = 0;
+    while (height < LOR_AVL_BST_MAX_HEIGHT + 1 && ((size_t) 1 << height) < n) {
+        height++;
+    }
+    if (height > LOR_AVL_BST_MAX_HEIGHT) {
+        return LOR_MAX_HEIGHT_ERR;
+    }
+
+    AVL_build_source src = { .next = next, .ctx = ctx, .lastkey = NULL, .lastleaf = NULL };
+    void *minkey;
+    int ret = __AVL_build(tree, tree->root, n, &src, &minkey);
+    if (ret == LOR_SUCCESS) {
+        tree->nitems = n;
+    }
+    return ret;
+}
+
+int Lor_AVL_build_sorted(Lor_AVL_bst *restrict tree, void *const keys[], void *const data[], size_t n)
+{
+    Lor_assert(!n || (keys && data), __func__, "arguments keys and data must be non-NULL");
+
+    AVL_build_arrays arrays = { .keys = keys, .data = data, .i = 0 };
+    return Lor_AVL_build_from_iter(tree, __AVL_next_from_arrays, &arrays, n);
+}
+
 int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data)
 {
     Lor_assert(tree, __func__, "argument tree must be non-NULL");
@@ -320,9 +1181,10 @@ int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data)
         return LOR_EMPTY_TREE_ERR;
     }
     else if (!tree->root->subtrees[1]) { // only one element in tree
-        if (!tree->compare(tree->root->key, key)) {
+        if (tree_keys_equal(tree, tree->root->key, key)) {
             *data = (void *) tree->root->subtrees[0];
             tree->root->subtrees[0] = NULL;
+            tree->root->size = 0;
             --tree->nitems;
         }
         else {
@@ -351,19 +1213,26 @@ int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data)
             }
         }
 
-        if (tree->compare(trav.current->key, key)) {
+        if (!tree_keys_equal(tree, trav.current->key, key)) {
             *data = NULL;
             return LOR_DELETE_NON_EXISTENT_KEY_ERR;
         }
         trav.height--; /* remove parentnode from stack */
-        parentnode->key = otherchild->key;
-        parentnode->height = otherchild->height;
-        parentnode->subtrees[0] = otherchild->subtrees[0];
-        parentnode->subtrees[1] = otherchild->subtrees[1];
+        if (tree_is_threaded(tree)) {
+            Lor_AVL_bst_node **threads = tree_leaf_threads(trav.current);
+            tree_link_leafs(threads[0], threads[1]);
+        }
+        tree_move_node(tree, parentnode, otherchild);
         *data = (void *) trav.current->subtrees[0];
-        tree->freenode(otherchild);
-        tree->freenode(trav.current);
+        tree_free_node(tree, otherchild);
+        tree_free_node(tree, trav.current);
         --tree->nitems;
+        if (tree->sizes || tree->aug.combine) {
+            for (size_t i = trav.height; i--; ) {
+                if (tree->sizes) trav.stack[i]->size--;
+                tree_fix_summary(tree, trav.stack[i]);
+            }
+        }
         /* Rebalance */
         while (trav.height) {
             trav.current = trav.stack[--trav.height];
@@ -372,14 +1241,14 @@ int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data)
             if (trav.current->subtrees[0]->height - trav.current->subtrees[1]->height == 2) {
                 /* Left-left unbalanced */
                 if (trav.current->subtrees[0]->subtrees[0]->height - trav.current->subtrees[1]->height == 1) {
-                    tree_right_rotate(trav.current);
+                    tree_right_rotate(tree, trav.current);
                     trav.current->subtrees[1]->height = trav.current->subtrees[1]->subtrees[0]->height + 1;
                     trav.current->height = trav.current->subtrees[1]->height + 1;
                 }
                 /* Left-right unbalanced */
                 else {
-                    tree_left_rotate(trav.current->subtrees[0]);
-                    tree_right_rotate(trav.current);
+                    tree_left_rotate(tree, trav.current->subtrees[0]);
+                    tree_right_rotate(tree, trav.current);
                     int32_t tmpheight = trav.current->subtrees[0]->subtrees[0]->height;
                     trav.current->subtrees[0]->height = tmpheight + 1;
                     trav.current->subtrees[1]->height = tmpheight + 1;
@@ -389,14 +1258,14 @@ int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data)
             else if (trav.current->subtrees[0]->height - trav.current->subtrees[1]->height == -2) {
                 /* Right-right unbalanced */
                 if (trav.current->subtrees[1]->subtrees[1]->height - trav.current->subtrees[0]->height == 1) {
-                    tree_left_rotate(trav.current);
+                    tree_left_rotate(tree, trav.current);
                     trav.current->subtrees[0]->height = trav.current->subtrees[0]->subtrees[1]->height + 1;
                     trav.current->height = trav.current->subtrees[0]->height + 1;
                 }
                 /* Right-left unbalanced */
                 else {
-                    tree_right_rotate(trav.current->subtrees[1]);
-                    tree_left_rotate(trav.current);
+                    tree_right_rotate(tree, trav.current->subtrees[1]);
+                    tree_left_rotate(tree, trav.current);
                     int32_t tmpheight = trav.current->subtrees[1]->subtrees[1]->height;
                     trav.current->subtrees[0]->height = tmpheight + 1;
                     trav.current->subtrees[1]->height = tmpheight + 1;
@@ -428,6 +1297,17 @@ int Lor_AVL_traverse_lr(Lor_AVL_bst *restrict tree, Lor_AVL_map mapfn)
         return LOR_EMPTY_TREE_ERR;
     }
 
+    if (tree_is_threaded(tree)) { /* follow the list of leafs */
+        Lor_AVL_bst_node *p = tree->root;
+        while (p->subtrees[1]) {
+            p = p->subtrees[0];
+        }
+        for (; p; p = tree_leaf_threads(p)[1]) {
+            mapfn(p->subtrees[0]);
+        }
+        return LOR_SUCCESS;
+    }
+
     Lor_AVL_traverser trav;
     Lor_AVL_traverser_init(&trav, tree);
 
@@ -435,8 +1315,9 @@ int Lor_AVL_traverse_lr(Lor_AVL_bst *restrict tree, Lor_AVL_map mapfn)
     while (itemsmapped && trav.height <= LOR_AVL_BST_MAX_HEIGHT) {
         if (!trav.current->subtrees[1]) { /* if it's a leaf */
             mapfn(trav.current->subtrees[0]); /* map over data */
-            itemsmapped--;
-            trav.current = trav.stack[--trav.height]->subtrees[1];
+            if (--itemsmapped) {
+                trav.current = trav.stack[--trav.height]->subtrees[1];
+            }
         }
         else {
             trav.stack[trav.height++] = trav.current;
@@ -452,4 +1333,637 @@ int Lor_AVL_traverse_lr(Lor_AVL_bst *restrict tree, Lor_AVL_map mapfn)
     }
 }
 
+/*========== Join, split and set operations ===========*/
+
+/**********************************************************
+ * State of a join/split/set operation.  The nodes released
+ * during the operation are kept in 'cache' (linked through
+ * subtrees[0]) and reused by the joins, so that, with  the
+ * few nodes allocated up front, the operation never has to
+ * allocate once it started to relink the trees.
+ **********************************************************/
+typedef struct {
+    Lor_AVL_bst *tree;           /* the tree receiving the result */
+    Lor_AVL_bst_node *cache;
+    size_t nfreed;               /* items of 'tree' released */
+    Lor_AVL_bst_node *lastleaf;  /* last leaf threaded by a union */
+} AVL_set_op;
+
+/* Nodes taken up front: one per root moved out of a tree, one per join
+ * that may need a fresh node */
+#define AVL_SET_OP_SPARE_NODES 3
+
+static int __AVL_set_op_begin(AVL_set_op *op, Lor_AVL_bst *tree)
+{
+    *op = (AVL_set_op){ .tree = tree, .cache = NULL, .nfreed = 0, .lastleaf = NULL };
+    for (size_t i = 0; i < AVL_SET_OP_SPARE_NODES; i++) {
+        Lor_AVL_bst_node *node = tree_alloc_node(tree);
+        if (!node) {
+            while (op->cache) {
+                node = op->cache;
+                op->cache = node->subtrees[0];
+                tree_free_node(tree, node);
+            }
+            return LOR_ALLOC_FAIL_ERR;
+        }
+        node->subtrees[0] = op->cache;
+        op->cache = node;
+    }
+    return LOR_SUCCESS;
+}
+
+static void __AVL_set_op_end(AVL_set_op *op)
+{
+    while (op->cache) {
+        Lor_AVL_bst_node *node = op->cache;
+        op->cache = node->subtrees[0];
+        tree_free_node(op->tree, node);
+    }
+}
+
+static inline void __AVL_cache_put(AVL_set_op *op, Lor_AVL_bst_node *node)
+{
+    node->subtrees[0] = op->cache;
+    op->cache = node;
+}
+
+static inline Lor_AVL_bst_node *__AVL_cache_get(AVL_set_op *op)
+{
+    Lor_AVL_bst_node *node = op->cache;
+    Lor_assert(node, __func__, "the node cache of a set operation must not run out");
+    op->cache = node->subtrees[0];
+    return node;
+}
+
+/* Move the nodes of 'tree' out of its root, which is left empty.  Returns
+ * the moved subtree, NULL if the tree is empty. */
+static Lor_AVL_bst_node *__AVL_take_root(AVL_set_op *op, Lor_AVL_bst *restrict tree)
+{
+    if (!tree->root->subtrees[0]) {
+        return NULL;
+    }
+    Lor_AVL_bst_node *node = __AVL_cache_get(op);
+    tree_move_node(op->tree, node, tree->root);
+    *tree->root = (Lor_AVL_bst_node){ .height = 0, .subtrees = { NULL, NULL } };
+    return node;
+}
+
+/* Make 'node' the content of the root of 'tree' */
+static void __AVL_put_root(AVL_set_op *op, Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    if (!node) {
+        *tree->root = (Lor_AVL_bst_node){ .height = 0, .subtrees = { NULL, NULL } };
+        return;
+    }
+    tree_move_node(op->tree, tree->root, node);
+    __AVL_cache_put(op, node);
+}
+
+static inline bool __AVL_is_leaf(const Lor_AVL_bst_node *node)
+{
+    return !node->subtrees[1];
+}
+
+static inline void __AVL_fix_node(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    int32_t lh = node->subtrees[0]->height;
+    int32_t rh = node->subtrees[1]->height;
+    node->height = 1 + ((lh > rh) ? lh : rh);
+    tree_fix_size(tree, node);
+    tree_fix_summary(tree, node);
+}
+
+/* Rotations that relink the nodes, unlike tree_left_rotate/tree_right_rotate
+ * which keep the subtree root in place: dir 0 rotates left, 1 rotates
+ * right.  Returns the new root of the subtree. */
+static Lor_AVL_bst_node *__AVL_rotate(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node, int dir)
+{
+    Lor_AVL_bst_node *up = node->subtrees[!dir];
+
+    node->subtrees[!dir] = up->subtrees[dir];
+    up->subtrees[dir] = node;
+    __AVL_fix_node(tree, node);
+    __AVL_fix_node(tree, up);
+    return up;
+}
+
+/* Restore the balance of an internal node whose subtrees differ in height
+ * by at most two.  Returns the new root of the subtree. */
+static Lor_AVL_bst_node *__AVL_rebalance(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    Lor_AVL_bst_node *left = node->subtrees[0];
+    Lor_AVL_bst_node *right = node->subtrees[1];
+    int32_t balance = left->height - right->height;
+
+    if (balance > 1) {
+        if (left->subtrees[0]->height < left->subtrees[1]->height) {
+            node->subtrees[0] = __AVL_rotate(tree, left, 0);  /* Left-right unbalanced */
+        }
+        return __AVL_rotate(tree, node, 1);
+    }
+    else if (balance < -1) {
+        if (right->subtrees[1]->height < right->subtrees[0]->height) {
+            node->subtrees[1] = __AVL_rotate(tree, right, 1);  /* Right-left unbalanced */
+        }
+        return __AVL_rotate(tree, node, 0);
+    }
+    __AVL_fix_node(tree, node);
+    return node;
+}
+
+static Lor_AVL_bst_node *__AVL_leftmost(Lor_AVL_bst_node *node)
+{
+    while (!__AVL_is_leaf(node)) {
+        node = node->subtrees[0];
+    }
+    return node;
+}
+
+static Lor_AVL_bst_node *__AVL_rightmost(Lor_AVL_bst_node *node)
+{
+    while (!__AVL_is_leaf(node)) {
+        node = node->subtrees[1];
+    }
+    return node;
+}
+
+/**********************************************************
+ * Join the subtrees 'left' and 'right', all keys of  left
+ * being smaller than 'key' and those of right not smaller,
+ * using 'node' as the new internal node.  The shorter tree
+ * is hung at the height of the other  on  its  facing
+ * spine, and the path back up is rebalanced.
+ **********************************************************/
+static Lor_AVL_bst_node *__AVL_join_node(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *left,
+                                         Lor_AVL_bst_node *right, Lor_AVL_bst_node *node, void *key)
+{
+    if (left->height > right->height + 1) {
+        left->subtrees[1] = __AVL_join_node(tree, left->subtrees[1], right, node, key);
+        return __AVL_rebalance(tree, left);
+    }
+    if (right->height > left->height + 1) {
+        right->subtrees[0] = __AVL_join_node(tree, left, right->subtrees[0], node, key);
+        return __AVL_rebalance(tree, right);
+    }
+    node->key = key;
+    node->subtrees[0] = left;
+    node->subtrees[1] = right;
+    __AVL_fix_node(tree, node);
+    return node;
+}
+
+/* Join two subtrees, either of them possibly empty */
+static Lor_AVL_bst_node *__AVL_join2(AVL_set_op *op, Lor_AVL_bst_node *left, Lor_AVL_bst_node *right)
+{
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    return __AVL_join_node(op->tree, left, right, __AVL_cache_get(op), __AVL_leftmost(right)->key);
+}
+
+/**********************************************************
+ * Split the subtree 'node' in the keys smaller than  'key'
+ * (*lt) and the others (*ge).  The internal nodes on the
+ * path are reused to join the pieces back, so this does
+ * not allocate.
+ **********************************************************/
+static void __AVL_split(AVL_set_op *op, Lor_AVL_bst_node *node, const void *key,
+                        Lor_AVL_bst_node **lt, Lor_AVL_bst_node **ge)
+{
+    if (__AVL_is_leaf(node)) {
+        if (op->tree->compare(node->key, key) < 0) {
+            *lt = node;
+            *ge = NULL;
+        }
+        else {
+            *lt = NULL;
+            *ge = node;
+        }
+        return;
+    }
+
+    Lor_AVL_bst_node *left = node->subtrees[0];
+    Lor_AVL_bst_node *right = node->subtrees[1];
+    Lor_AVL_bst_node *part;
+    if (op->tree->compare(key, node->key) < 0) {
+        __AVL_split(op, left, key, lt, &part);
+        if (part) {
+            *ge = __AVL_join_node(op->tree, part, right, node, node->key);
+        }
+        else {
+            *ge = right;
+            __AVL_cache_put(op, node);
+        }
+    }
+    else {
+        __AVL_split(op, right, key, &part, ge);
+        if (part) {
+            *lt = __AVL_join_node(op->tree, left, part, node, node->key);
+        }
+        else {
+            *lt = left;
+            __AVL_cache_put(op, node);
+        }
+    }
+}
+
+/* Remove the leftmost leaf of a subtree into *leaf.  Returns the rest. */
+static Lor_AVL_bst_node *__AVL_pop_min(AVL_set_op *op, Lor_AVL_bst_node *node, Lor_AVL_bst_node **leaf)
+{
+    if (__AVL_is_leaf(node)) {
+        *leaf = node;
+        return NULL;
+    }
+    Lor_AVL_bst_node *left = __AVL_pop_min(op, node->subtrees[0], leaf);
+    if (!left) {
+        Lor_AVL_bst_node *right = node->subtrees[1];
+        __AVL_cache_put(op, node);
+        return right;
+    }
+    node->subtrees[0] = left;
+    return __AVL_rebalance(op->tree, node);
+}
+
+/* Split a subtree in the keys smaller than 'key', the leaf of 'key' (NULL
+ * if absent) and the keys greater than 'key' */
+static void __AVL_split3(AVL_set_op *op, Lor_AVL_bst_node *node, const void *key, Lor_AVL_bst_node **lt,
+                         Lor_AVL_bst_node **found, Lor_AVL_bst_node **gt)
+{
+    __AVL_split(op, node, key, lt, gt);
+    *found = NULL;
+    if (*gt && tree_keys_equal(op->tree, __AVL_leftmost(*gt)->key, key)) {
+        *gt = __AVL_pop_min(op, *gt, found);
+    }
+}
+
+/* Release the items of a subtree of op->tree */
+static void __AVL_free_subtree_items(AVL_set_op *op, Lor_AVL_bst_node *node)
+{
+    if (!node) {
+        return;
+    }
+    if (__AVL_is_leaf(node)) {
+        if (op->tree->freedata) op->tree->freedata(node->subtrees[0]);
+        if (tree_is_threaded(op->tree)) {
+            Lor_AVL_bst_node **threads = tree_leaf_threads(node);
+            tree_link_leafs(threads[0], threads[1]);
+        }
+        op->nfreed++;
+    }
+    else {
+        __AVL_free_subtree_items(op, node->subtrees[0]);
+        __AVL_free_subtree_items(op, node->subtrees[1]);
+    }
+    __AVL_cache_put(op, node);
+}
+
+/**********************************************************
+ * Thread the leafs 'first' to 'last' of b, already linked
+ * among themselves, before the leaf 'next' of a, or after
+ * the last leaf of the union if 'next' is NULL.  The leafs
+ * of b are threaded in increasing order, so the leaf before
+ * 'next' is the one to follow.
+ **********************************************************/
+static void __AVL_union_link(AVL_set_op *op, Lor_AVL_bst_node *first, Lor_AVL_bst_node *last,
+                             Lor_AVL_bst_node *next)
+{
+    tree_link_leafs((next) ? tree_leaf_threads(next)[0] : op->lastleaf, first);
+    tree_link_leafs(last, next);
+    if (!next) {
+        op->lastleaf = last;
+    }
+}
+
+/* Union of a (kept on equal keys) and b, whose nodes are moved.  The data of
+ * the leafs of b dropped for an equal key are released with 'freedata'.  On
+ * threaded trees 'next' is the leaf of t1 that follows the keys of a and b. */
+static Lor_AVL_bst_node *__AVL_union(AVL_set_op *op, Lor_AVL_bst_node *a, Lor_AVL_bst_node *b,
+                                     Lor_AVL_bst_node *next, Lor_AVL_free_data freedata, size_t *ndups)
+{
+    bool threaded = tree_is_threaded(op->tree);
+    if (!a) {
+        if (threaded && b) {
+            __AVL_union_link(op, __AVL_leftmost(b), __AVL_rightmost(b), next);
+        }
+        return b;
+    }
+    if (!b) {
+        return a;
+    }
+
+    Lor_AVL_bst_node *lt, *ge;
+    if (__AVL_is_leaf(b)) {
+        Lor_AVL_bst_node *found;
+        __AVL_split3(op, a, b->key, &lt, &found, &ge);
+        if (found) {
+            if (freedata) freedata(b->subtrees[0]);
+            __AVL_cache_put(op, b);
+            ++*ndups;
+        }
+        else {
+            if (threaded) {
+                __AVL_union_link(op, b, b, (ge) ? __AVL_leftmost(ge) : next);
+            }
+            found = b;
+        }
+        return __AVL_join2(op, __AVL_join2(op, lt, found), ge);
+    }
+
+    Lor_AVL_bst_node *bleft = b->subtrees[0];
+    Lor_AVL_bst_node *bright = b->subtrees[1];
+    void *key = b->key;
+    __AVL_cache_put(op, b);
+    __AVL_split(op, a, key, &lt, &ge);
+    Lor_AVL_bst_node *ltnext = (threaded && ge) ? __AVL_leftmost(ge) : next;
+    lt = __AVL_union(op, lt, bleft, ltnext, freedata, ndups);
+    ge = __AVL_union(op, ge, bright, next, freedata, ndups);
+    return __AVL_join2(op, lt, ge);
+}
+
+/* Items of a whose keys are (keep true) or are not (keep false) in b, which
+ * is only read */
+static Lor_AVL_bst_node *__AVL_filter(AVL_set_op *op, Lor_AVL_bst_node *a, const Lor_AVL_bst_node *b,
+                                      bool keep)
+{
+    if (!a) {
+        return NULL;
+    }
+    if (!b) {
+        if (keep) {
+            __AVL_free_subtree_items(op, a);
+            return NULL;
+        }
+        return a;
+    }
+
+    Lor_AVL_bst_node *lt, *ge;
+    if (__AVL_is_leaf(b)) {
+        Lor_AVL_bst_node *found;
+        __AVL_split3(op, a, b->key, &lt, &found, &ge);
+        if (keep) {
+            __AVL_free_subtree_items(op, lt);
+            __AVL_free_subtree_items(op, ge);
+            return found;
+        }
+        __AVL_free_subtree_items(op, found);
+        return __AVL_join2(op, lt, ge);
+    }
+
+    __AVL_split(op, a, b->key, &lt, &ge);
+    lt = __AVL_filter(op, lt, b->subtrees[0], keep);
+    ge = __AVL_filter(op, ge, b->subtrees[1], keep);
+    return __AVL_join2(op, lt, ge);
+}
+
+/* Pop the next leaf of a preorder walk, NULL once the walk is over */
+static Lor_AVL_bst_node *__AVL_next_leaf(Lor_AVL_bst_node **stack, size_t *top)
+{
+    while (*top) {
+        Lor_AVL_bst_node *node = stack[--*top];
+        if (__AVL_is_leaf(node)) {
+            return node;
+        }
+        stack[(*top)++] = node->subtrees[1];
+        stack[(*top)++] = node->subtrees[0];
+    }
+    return NULL;
+}
+
+/* Number of leafs of 'a', 'a' and 'b' holding 'total' leafs, for trees
+ * without sizes.  The two trees are walked in lockstep, so this takes
+ * O(min(|a|, |b|)). */
+static size_t __AVL_count_split(Lor_AVL_bst_node *a, Lor_AVL_bst_node *b, size_t total)
+{
+    Lor_AVL_bst_node *stacka[LOR_AVL_BST_MAX_HEIGHT + 2], *stackb[LOR_AVL_BST_MAX_HEIGHT + 2];
+    size_t topa = 0, topb = 0, na = 0, nb = 0;
+
+    if (a) stacka[topa++] = a;
+    if (b) stackb[topb++] = b;
+    for (;;) {
+        if (!__AVL_next_leaf(stacka, &topa)) {
+            return na;
+        }
+        na++;
+        if (!__AVL_next_leaf(stackb, &topb)) {
+            return total - nb;
+        }
+        nb++;
+    }
+}
+
+/* Trees whose nodes can be moved from one to the other */
+static bool __AVL_same_allocator(const Lor_AVL_bst *t1, const Lor_AVL_bst *t2)
+{
+    return t1->alloc == t2->alloc && t1->freenode == t2->freenode
+        && t1->allocator.alloc == t2->allocator.alloc && t1->allocator.freenode == t2->allocator.freenode
+        && t1->allocator.ctx == t2->allocator.ctx && t1->pool == t2->pool
+        && t1->nodealign == t2->nodealign && t1->nodesize == t2->nodesize
+        && t1->summaryoffset == t2->summaryoffset && t1->aug.summarize == t2->aug.summarize
+        && t1->aug.combine == t2->aug.combine && t1->sizes == t2->sizes;
+}
+
+static void __AVL_check_set_op_args(const Lor_AVL_bst *t1, const Lor_AVL_bst *t2, const char *func)
+{
+    Lor_assert(t1 && t2, func, "arguments t1 and t2 must be non-NULL");
+    Lor_assert(t1 != t2, func, "arguments t1 and t2 must be different trees");
+    Lor_assert(t1->root && t2->root, func, "roots of t1 and t2 must be non-NULL");
+}
+
+int Lor_AVL_join(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2)
+{
+    __AVL_check_set_op_args(t1, t2, __func__);
+
+    if (t1->compare != t2->compare || !__AVL_same_allocator(t1, t2)) {
+        return LOR_INCOMPATIBLE_TREES_ERR;
+    }
+    if (!t2->root->subtrees[0]) {
+        return LOR_SUCCESS;
+    }
+    if (t1->nitems + t2->nitems > UINT32_MAX) {
+        return LOR_MAX_ITEMS_ERR;
+    }
+    if (t1->root->subtrees[0]
+        && t1->compare(__AVL_rightmost(t1->root)->key, __AVL_leftmost(t2->root)->key) >= 0) {
+        return LOR_UNSORTED_KEYS_ERR;
+    }
+
+    AVL_set_op op;
+    int ret = __AVL_set_op_begin(&op, t1);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    if (tree_is_threaded(t1) && t1->root->subtrees[0]) {
+        tree_link_leafs(__AVL_rightmost(t1->root), __AVL_leftmost(t2->root));
+    }
+    Lor_AVL_bst_node *a = __AVL_take_root(&op, t1);
+    Lor_AVL_bst_node *b = __AVL_take_root(&op, t2);
+    __AVL_put_root(&op, t1, __AVL_join2(&op, a, b));
+    __AVL_set_op_end(&op);
+
+    t1->nitems += t2->nitems;
+    t2->nitems = 0;
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_split(Lor_AVL_bst *restrict tree, const void *key, Lor_AVL_bst *restrict ge)
+{
+    __AVL_check_set_op_args(tree, ge, __func__);
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    if (tree->compare != ge->compare || !__AVL_same_allocator(tree, ge)) {
+        return LOR_INCOMPATIBLE_TREES_ERR;
+    }
+    if (ge->root->subtrees[0]) {
+        return LOR_TREE_NOT_EMPTY_ERR;
+    }
+    if (!tree->root->subtrees[0]) {
+        return LOR_SUCCESS;
+    }
+
+    AVL_set_op op;
+    int ret = __AVL_set_op_begin(&op, tree);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    Lor_AVL_bst_node *lt, *right;
+    __AVL_split(&op, __AVL_take_root(&op, tree), key, &lt, &right);
+    size_t nlt = (!lt) ? 0 : (tree->sizes) ? lt->size : __AVL_count_split(lt, right, tree->nitems);
+    __AVL_put_root(&op, tree, lt);
+    __AVL_put_root(&op, ge, right);
+    __AVL_set_op_end(&op);
+    if (tree_is_threaded(tree) && tree->root->subtrees[0]) {
+        Lor_AVL_bst_node *last = __AVL_rightmost(tree->root);
+        if (tree_leaf_threads(last)[1]) {
+            tree_leaf_threads(tree_leaf_threads(last)[1])[0] = NULL;
+            tree_leaf_threads(last)[1] = NULL;
+        }
+    }
+
+    ge->nitems = tree->nitems - nlt;
+    tree->nitems = nlt;
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_union(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2)
+{
+    __AVL_check_set_op_args(t1, t2, __func__);
+
+    if (t1->compare != t2->compare || !__AVL_same_allocator(t1, t2)) {
+        return LOR_INCOMPATIBLE_TREES_ERR;
+    }
+    if (t1->nitems + t2->nitems > UINT32_MAX) {
+        return LOR_MAX_ITEMS_ERR;
+    }
+
+    AVL_set_op op;
+    int ret = __AVL_set_op_begin(&op, t1);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    size_t ndups = 0;
+    Lor_AVL_bst_node *a = __AVL_take_root(&op, t1);
+    Lor_AVL_bst_node *b = __AVL_take_root(&op, t2);
+    if (tree_is_threaded(t1) && a) {
+        op.lastleaf = __AVL_rightmost(a);
+    }
+    __AVL_put_root(&op, t1, __AVL_union(&op, a, b, NULL, t2->freedata, &ndups));
+    __AVL_set_op_end(&op);
+
+    t1->nitems += t2->nitems - ndups;
+    t2->nitems = 0;
+    return LOR_SUCCESS;
+}
+
+/* Common part of Lor_AVL_intersection and Lor_AVL_difference */
+static int __AVL_filter_tree(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2, bool keep)
+{
+    if (t1->compare != t2->compare) {
+        return LOR_INCOMPATIBLE_TREES_ERR;
+    }
+
+    AVL_set_op op;
+    int ret = __AVL_set_op_begin(&op, t1);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    const Lor_AVL_bst_node *b = (t2->root->subtrees[0]) ? t2->root : NULL;
+    __AVL_put_root(&op, t1, __AVL_filter(&op, __AVL_take_root(&op, t1), b, keep));
+    __AVL_set_op_end(&op);
+
+    t1->nitems -= op.nfreed;
+    return LOR_SUCCESS;
+}
+
+int Lor_AVL_intersection(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2)
+{
+    __AVL_check_set_op_args(t1, t2, __func__);
+
+    return __AVL_filter_tree(t1, t2, true);
+}
+
+int Lor_AVL_difference(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2)
+{
+    __AVL_check_set_op_args(t1, t2, __func__);
+
+    return __AVL_filter_tree(t1, t2, false);
+}
+
+/* Hand the data of a subtree, in key order, to mapfn and free its nodes.
+ * Returns the number of items released. */
+static size_t __AVL_release_subtree(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node, Lor_AVL_map mapfn)
+{
+    size_t n = 1;
+    if (__AVL_is_leaf(node)) {
+        if (mapfn) mapfn(node->subtrees[0]);
+    }
+    else {
+        n = __AVL_release_subtree(tree, node->subtrees[0], mapfn)
+          + __AVL_release_subtree(tree, node->subtrees[1], mapfn);
+    }
+    tree_free_node(tree, node);
+    return n;
+}
+
+int Lor_AVL_delete_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, Lor_AVL_map mapfn)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(tree->root, __func__, "root of tree must be non-NULL");
+
+    if (!tree->root->subtrees[0]) { /* empty tree */
+        return LOR_SUCCESS;
+    }
+    if (a && b && tree->compare(a, b) >= 0) {
+        return LOR_SUCCESS;
+    }
+
+    AVL_set_op op;
+    int ret = __AVL_set_op_begin(&op, tree);
+    if (ret != LOR_SUCCESS) {
+        return ret;
+    }
+    /* Cut the range out with two splits, and join what is left around it */
+    Lor_AVL_bst_node *lt = NULL, *range = __AVL_take_root(&op, tree), *ge = NULL;
+    if (a) {
+        __AVL_split(&op, range, a, &lt, &range);
+    }
+    if (b && range) {
+        __AVL_split(&op, range, b, &range, &ge);
+    }
+    __AVL_put_root(&op, tree, __AVL_join2(&op, lt, ge));
+    __AVL_set_op_end(&op);
+    if (!range) {
+        return LOR_SUCCESS;
+    }
+
+    if (tree_is_threaded(tree)) {
+        tree_link_leafs(tree_leaf_threads(__AVL_leftmost(range))[0],
+                        tree_leaf_threads(__AVL_rightmost(range))[1]);
+    }
+    tree->nitems -= __AVL_release_subtree(tree, range, (mapfn) ? mapfn : tree->freedata);
+    return LOR_SUCCESS;
+}
+
 /* End Of File */
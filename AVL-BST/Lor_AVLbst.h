@@ -41,6 +41,39 @@
  *         - LOR_ALLOC_FN_NOT_PROVIDED_ERR if  allocation  function  has  not
  *           been provided
  *
+ * int Lor_AVL_init_with_allocator(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+ *              const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata);
+ *     Same as Lor_AVL_init, but the tree nodes are  allocated  through
+ *     an allocator object that carries its own context pointer,  so
+ *     every tree can be bound to a different arena without globals.
+ *     Parameters:
+ *         - tree      -> an AVL tree created by AVL_create
+ *         - compare   -> a comparison function for keys
+ *         - allocator -> the allocator object (copied into the tree).  Its
+ *                        freenode may be NULL if the nodes are  reclaimed
+ *                        all at once by the owner of ctx
+ *         - freedata  -> a free function for deallocation of data
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_COMPARE_FN_NOT_PROVIDED_ERR if compare function has not been
+ *           provided
+ *         - LOR_ALLOC_FN_NOT_PROVIDED_ERR if allocator->alloc has  not  been
+ *           provided
+ *         - LOR_ALLOC_FAIL_ERR if the root node could not be allocated
+ *
+ * int Lor_AVL_init_with_pool(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+ *              Lor_mem_pool *pool, Lor_AVL_free_data freedata);
+ *     Same as Lor_AVL_init, but binds the tree to pool: all tree nodes
+ *     are allocated from the slab free lists of pool and released  to
+ *     them, so insert/delete churn does not grow the pool.
+ *     Parameters:
+ *         - tree     -> an AVL tree created by AVL_create
+ *         - compare  -> a comparison function for keys
+ *         - pool     -> an initialized Lor_mem_pool
+ *         - freedata -> a free function for deallocation of data
+ *     Returns:
+ *         - same as Lor_AVL_init_with_allocator
+ *
  * int Lor_AVL_destroy(Lor_AVL_bst **restrict tree);
  *     This function destroys a Lor_AVL_bst allocated by AVL_create.
  *     Parameters:
@@ -59,6 +92,90 @@
  *         - LOR_FREE_NULLPTR_WARN if the root of the tree is NULL
  *         - LOR_EMPTY_TREE_ERR if the tree is already empty
  *
+ * int Lor_AVL_discard(Lor_AVL_bst *restrict tree, bool freedata);
+ *     This function empties a tree bound to a  pool  (see  Lor_AVL_init_with_pool)
+ *     by discarding the whole pool at once, instead of releasing the nodes
+ *     one by one as Lor_AVL_clear does.  The pool must be  dedicated  to
+ *     tree: every other allocation from it is discarded as well.
+ *     Parameters:
+ *         - tree     -> the tree to be emptied
+ *         - freedata -> if true, tree->freedata is still called for  each
+ *                       item (this walks the tree)
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_FREE_NULLPTR_WARN if the root of the tree is NULL
+ *         - LOR_NOT_POOL_BACKED_ERR if the tree is not bound to a pool
+ *
+ * int Lor_AVL_set_node_alignment(Lor_AVL_bst *restrict tree, size_t align);
+ *     This function makes a tree bound to a pool allocate its nodes  at
+ *     addresses multiple of align.  A node never straddles two cache
+ *     lines, so each level of Lor_AVL_find touches a single line, when
+ *     align is not smaller than the node size and the node size is at most
+ *     64 bytes: an align of 32 or 64 for the plain nodes of 32 bytes,  64
+ *     for the nodes of 48 bytes of a tree with threaded leafs.  Node
+ *     summaries (see Lor_AVL_set_augmentation) add their size to these.
+ *     Nodes allocated before the call keep their address, except the root.
+ *     Parameters:
+ *         - tree  -> the tree, initialized by Lor_AVL_init_with_pool
+ *         - align -> a power of two not larger than LOR_MEM_POOL_MAX_ALIGNMENT,
+ *                    or 0 to go back to the default pool alignment
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_NOT_POOL_BACKED_ERR if the tree is not bound to a pool
+ *         - LOR_INVALID_ALIGNMENT_ERR if align is not a valid alignment
+ *         - LOR_ALLOC_FAIL_ERR if the root could not be moved
+ *
+ * int Lor_AVL_set_leaf_threads(Lor_AVL_bst *restrict tree, bool enable);
+ *     This function makes each leaf of an empty tree keep  links  to  the
+ *     previous and next leafs, kept up to date by all the functions  that
+ *     change the tree.  Lor_AVL_successor and Lor_AVL_predecessor are then
+ *     O(1), and Lor_AVL_traverse_lr follows the links.  Every node takes
+ *     two more pointers.
+ *     Parameters:
+ *         - tree   -> the tree, empty
+ *         - enable -> true to thread the leafs, false to go back to plain leafs
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_TREE_NOT_EMPTY_ERR if the tree has items
+ *         - LOR_ALLOC_FAIL_ERR if the root could not be reallocated
+ *
+ * int Lor_AVL_set_augmentation(Lor_AVL_bst *restrict tree, const Lor_AVL_augmentation *aug);
+ *     This function makes an empty tree keep on each node a  summary  of
+ *     its subtree, updated by all the functions that change the tree, for
+ *     Lor_AVL_range_aggregate.  Each node takes aug->size more bytes.
+ *     Parameters:
+ *         - tree -> the tree, empty
+ *         - aug  -> the summary and its functions, copied, or NULL to  drop
+ *                   the summaries
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_TREE_NOT_EMPTY_ERR if the tree has items
+ *         - LOR_ALLOC_FAIL_ERR if the root could not be reallocated
+ *
+ * int Lor_AVL_set_subtree_sizes(Lor_AVL_bst *restrict tree, bool enable);
+ *     This function makes each node of an empty tree keep the number of
+ *     leafs of its subtree, updated by all the functions that change the
+ *     tree, for Lor_AVL_rank, Lor_AVL_select and Lor_AVL_count_range, and
+ *     for Lor_AVL_split to count the items it moves in O(1).  The sizes
+ *     take no memory, but insert and delete then update every node of
+ *     the path, O(log n), instead of only the rebalanced ones.
+ *     Parameters:
+ *         - tree   -> the tree, empty
+ *         - enable -> true to keep the sizes, false to drop them
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_TREE_NOT_EMPTY_ERR if the tree has items
+ *
+ * void Lor_AVL_range_aggregate(Lor_AVL_bst *restrict tree, const void *a, const void *b, void *result);
+ *     This function combines, in O(log n), the summaries of the items of
+ *     the key interval [a, b[, in increasing key order.
+ *     Parameters:
+ *         - tree   -> a tree with an augmentation
+ *         - a      -> lower limit of interval, NULL for no limit
+ *         - b      -> upper limit of interval, NULL for no limit
+ *         - result -> where to store the summary, of aug->size bytes;  the
+ *                     identity if there is no key in [a, b[
+ *
  * Lor_AVL_bst_node *Lor_AVL_find(Lor_AVL_bst *restrict tree, const void *key);
  *     This function searches for key in tree.
  *     Parameters:
@@ -68,6 +185,60 @@
  *         - NULL if key is not on tree
  *         - Lor_AVL_bst_node *node, the leaf node with that key
  *
+ * size_t Lor_AVL_find_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+ *                           Lor_AVL_bst_node *out[]);
+ *     This function searches for n keys.  The searches go down the  tree
+ *     in groups of LOR_AVL_FIND_BATCH_GROUP, one level at a time for each
+ *     search of the group in turn, and the node each of them goes to next
+ *     is prefetched.  The cache misses of the group then overlap, instead
+ *     of being paid one after the other as by n calls to Lor_AVL_find.
+ *     Parameters:
+ *         - tree -> the AVL tree to be searched
+ *         - keys -> the n keys to be searched, in any order
+ *         - n    -> the number of keys
+ *         - out  -> where to store, for each key, its leaf node or NULL  if
+ *                   it is not on tree, as Lor_AVL_find would return
+ *     Returns:
+ *         - the number of keys found
+ *
+ * size_t Lor_AVL_find_sorted_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+ *                                  Lor_AVL_bst_node *out[]);
+ *     This function searches for n keys, as Lor_AVL_find_batch, each search
+ *     starting from where the previous one ended, as Lor_AVL_cursor_find:
+ *     for sorted keys, the part of the path they share is not gone  over
+ *     again.  Keys in any order give the same results, but no faster than
+ *     Lor_AVL_find.
+ *     Returns:
+ *         - the number of keys found
+ *
+ * int Lor_AVL_rank(Lor_AVL_bst *restrict tree, const void *key, size_t *rank);
+ *     This function counts the keys of tree smaller than key, in O(log n),
+ *     from the subtree sizes (see Lor_AVL_set_subtree_sizes).
+ *     Parameters:
+ *         - tree -> a tree keeping subtree sizes
+ *         - key  -> the key
+ *         - rank -> where to store the number of keys smaller than key
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_NO_SUBTREE_SIZES_ERR if the tree does not keep subtree sizes
+ *
+ * int Lor_AVL_select(Lor_AVL_bst *restrict tree, size_t i, Lor_AVL_bst_node **leaf);
+ *     This function searches for the i-th smallest key (from 0), in O(log n),
+ *     from the subtree sizes.
+ *     Parameters:
+ *         - leaf -> where to store the leaf node of that key, or NULL if  i
+ *                   is not smaller than the number of items
+ *     Returns:
+ *         - same as Lor_AVL_rank
+ *
+ * int Lor_AVL_count_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, size_t *count);
+ *     This function counts the keys in the interval [a, b[, in O(log n)
+ *     and without allocating, unlike Lor_AVL_interval_find.
+ *     Parameters:
+ *         - count -> where to store the number of keys k with a <= k < b
+ *     Returns:
+ *         - same as Lor_AVL_rank
+ *
  * Lor_AVL_bst_node *Lor_AVL_interval_find(Lor_AVL_bst *restrict tree, const void *a, const void *b);
  *     This function searches for a key interval [a, b[
  *     Parameters:
@@ -77,8 +248,9 @@
  *     Returns:
  *         - NULL if the interval does not exist in the tree's keys or if the operation cannot be done
  *         - Lor_AVL_bst_node *list, a list of AVL tree nodes with  the  interval
- *           [a, b[. If one of the limits is out of range in the tree's  keys,
- *           it returns [a, <max key on tree>] or [<min key on tree>, b[.
+ *           [a, b[, in increasing key order. If one of the limits is out  of
+ *           range in the tree's keys, it returns [a, <max key on tree>]  or
+ *           [<min key on tree>, b[.
  *
  * void *Lor_AVL_get_data_from_node(Lor_AVL_bst_node *node);
  *     This function gets the data from a leaf node.
@@ -88,6 +260,71 @@
  *         - NULL, if node is not a leaf
  *         - void *data, a void pointer to the data in *node
  *
+ * void *Lor_AVL_get_key_from_node(Lor_AVL_bst_node *node);
+ *     This function gets the key of a leaf node.
+ *     Returns:
+ *         - NULL, if node is not a leaf
+ *         - void *key, the key of *node
+ *
+ * void Lor_AVL_cursor_init(Lor_AVL_cursor *cur, Lor_AVL_bst *restrict tree);
+ *     This function sets a cursor on tree, not positioned.  A cursor  is
+ *     invalidated by any change to the tree, but Lor_AVL_cursor_insert  on
+ *     the cursor itself.
+ *
+ * Lor_AVL_bst_node *Lor_AVL_successor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf);
+ * Lor_AVL_bst_node *Lor_AVL_predecessor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf);
+ *     These functions get the leaf of the next (previous) key after the
+ *     leaf of tree, as returned by Lor_AVL_find.  O(1) if the leafs of tree
+ *     are threaded, O(log n) otherwise.
+ *     Returns:
+ *         - the next (previous) leaf
+ *         - NULL if leaf holds the greatest (smallest) key
+ *
+ * Lor_AVL_bst_node *Lor_AVL_cursor_first(Lor_AVL_cursor *cur);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_last(Lor_AVL_cursor *cur);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_lower_bound(Lor_AVL_cursor *cur, const void *key);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_upper_bound(Lor_AVL_cursor *cur, const void *key);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_floor(Lor_AVL_cursor *cur, const void *key);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_ceiling(Lor_AVL_cursor *cur, const void *key);
+ *     These functions position the cursor, in O(log n), on the leaf of:
+ *     the smallest key; the greatest key; the first key not smaller than
+ *     key (lower_bound, same as ceiling); the first key greater than key
+ *     (upper_bound); the last key not greater than key (floor).
+ *     Returns:
+ *         - the leaf node the cursor is on
+ *         - NULL if there is no such key (the cursor is not positioned)
+ *
+ * Lor_AVL_bst_node *Lor_AVL_cursor_next(Lor_AVL_cursor *cur);
+ * Lor_AVL_bst_node *Lor_AVL_cursor_prev(Lor_AVL_cursor *cur);
+ *     These functions move the cursor to the next (previous) key,  in
+ *     O(1) amortized, without allocating.
+ *     Returns:
+ *         - the leaf node the cursor is on
+ *         - NULL past the end (the cursor is not positioned anymore)
+ *
+ * Lor_AVL_bst_node *Lor_AVL_cursor_find(Lor_AVL_cursor *cur, const void *key);
+ *     This function searches for key from the position of the cursor  (a
+ *     finger search): it goes up only as far as the subtree that spans key
+ *     and down from there, so that a key close to the last one costs O(1)
+ *     amortized key comparisons.  Going up may still take O(log n) steps
+ *     without comparisons, e.g. for a key past the greatest one.  A cursor
+ *     not positioned searches from the root.
+ *     Returns:
+ *         - NULL if key is not on tree, the cursor being left on  the  leaf
+ *           where the search ended
+ *         - Lor_AVL_bst_node *leaf, the leaf of key, where the cursor is
+ *
+ * int Lor_AVL_cursor_insert(Lor_AVL_cursor *cur, void *key, void *data);
+ *     This function inserts key as Lor_AVL_insert, finding its  leaf  as
+ *     Lor_AVL_cursor_find, and leaves the cursor on the leaf of key.  With
+ *     sorted or nearly sorted keys the search and the rebalance  of  each
+ *     insertion cost O(1) amortized key comparisons and rotations; a tree
+ *     keeping subtree sizes or summaries (Lor_AVL_set_subtree_sizes and
+ *     Lor_AVL_set_augmentation) still updates the whole path, in O(log n).
+ *     This is the only change to the tree that keeps the cursor valid.
+ *     Returns:
+ *         - the return values of Lor_AVL_insert
+ *
  * void Lor_AVL_process_node_list(Lor_AVL_bst_node *nodelst, Lor_AVL_map mapfn);
  *     Function that processes the node list created by AVL_interval_find.
  *     Parameters:
@@ -115,7 +352,38 @@
  *         - LOR_SUCCESS, if successfull
  *         - LOR_MAX_HEIGHT_ERR, if the tree reaches the  maximum  permitted
  *           height
+ *         - LOR_MAX_ITEMS_ERR, if the tree already holds UINT32_MAX items
  *         - LOR_DISTINCT_KEY_ERR (if AVL_ONLY_DISTINCT_KEYS is defined)
+ *         - LOR_ALLOC_FAIL_ERR, if a node could not be allocated; the tree
+ *           is left unchanged
+ *
+ * int Lor_AVL_build_sorted(Lor_AVL_bst *restrict tree, void *const keys[],
+ *              void *const data[], size_t n);
+ *     Function that fills an empty tree with n items in strictly increasing
+ *     order of their keys, in O(n): the  nodes  are  allocated  in  one
+ *     pass, depth first, and linked into a perfectly balanced tree  with
+ *     no comparisons besides the check of the order.
+ *     Parameters:
+ *         - tree -> an empty AVL tree
+ *         - keys -> the keys, sorted by tree->compare
+ *         - data -> the data of each key
+ *         - n    -> the number of items
+ *     Returns:
+ *         - LOR_SUCCESS, if successfull
+ *         - LOR_TREE_NOT_EMPTY_ERR, if the tree is not empty
+ *         - LOR_UNSORTED_KEYS_ERR, if the keys are not strictly increasing
+ *         - LOR_MAX_HEIGHT_ERR, if n items do not fit the maximum height
+ *         - LOR_MAX_ITEMS_ERR, if n is greater than UINT32_MAX
+ *         - LOR_ALLOC_FAIL_ERR, if a node could not be allocated
+ *       On error the tree is left empty, and no data is freed.
+ *
+ * int Lor_AVL_build_from_iter(Lor_AVL_bst *restrict tree, Lor_AVL_next_item next,
+ *              void *ctx, size_t n);
+ *     Same as Lor_AVL_build_sorted, taking the n items from calls of
+ *     next(ctx, &key, &data), which returns false once exhausted.
+ *     Returns:
+ *         - same as Lor_AVL_build_sorted
+ *         - LOR_SRC_EMPTY_WARN, if next ran out before n items
  *
  * int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data);
  *     Function that deletes the data with the given key in the tree.
@@ -129,6 +397,71 @@
  *         - LOR_DELETE_NON_EXISTENT_KEY_ERR, if the given key does not exist
  *           in the tree
  *
+ * int Lor_AVL_join(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2);
+ *     Function that moves the items of t2 into t1, all the keys  of  t1
+ *     being smaller than those of t2, in O(log n).  In a leaf tree the
+ *     separating key is the smallest key of t2, so none is passed.
+ *     Parameters:
+ *         - t1 -> the tree receiving the items
+ *         - t2 -> the tree of the greater keys, left empty
+ *     Returns:
+ *         - LOR_SUCCESS, if successfull
+ *         - LOR_INCOMPATIBLE_TREES_ERR, if the trees do not share compare
+ *           and node allocator, or do not both keep subtree sizes
+ *         - LOR_UNSORTED_KEYS_ERR, if a key of t1 is not smaller than the
+ *           keys of t2
+ *         - LOR_MAX_ITEMS_ERR, if t1 and t2 hold more than UINT32_MAX items
+ *         - LOR_ALLOC_FAIL_ERR
+ *
+ * int Lor_AVL_split(Lor_AVL_bst *restrict tree, const void *key, Lor_AVL_bst *restrict ge);
+ *     Function that moves the items of tree with keys not smaller than
+ *     key into the empty tree ge, in O(log n) if the trees keep subtree
+ *     sizes, plus the recount of the items, in O(min(|tree|, |ge|)), if
+ *     they do not.
+ *     Returns:
+ *         - LOR_SUCCESS, if successfull
+ *         - LOR_INCOMPATIBLE_TREES_ERR, as in Lor_AVL_join
+ *         - LOR_TREE_NOT_EMPTY_ERR, if ge is not empty
+ *         - LOR_ALLOC_FAIL_ERR
+ *
+ * int Lor_AVL_union(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2);
+ * int Lor_AVL_intersection(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2);
+ * int Lor_AVL_difference(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2);
+ *     Functions that leave in t1 the union, intersection or  difference
+ *     of the keys of t1 and t2, in O(m log(n/m + 1)) for trees of m <= n
+ *     items: the trees are recursively split by the keys of t2 and their
+ *     pieces joined back.
+ *     Lor_AVL_union moves the nodes of t2 into t1, leaving t2 empty; for
+ *     equal keys the item of t1 is kept and the data of t2 is freed with
+ *     t2's freedata.  Lor_AVL_intersection and Lor_AVL_difference only
+ *     read t2, and free the data of the items removed from t1 with t1's
+ *     freedata.
+ *     Returns:
+ *         - LOR_SUCCESS, if successfull
+ *         - LOR_INCOMPATIBLE_TREES_ERR, if the trees do not share compare,
+ *           or (Lor_AVL_union) node allocator
+ *         - LOR_MAX_ITEMS_ERR, if (Lor_AVL_union) t1 and t2 hold more  than
+ *           UINT32_MAX items
+ *         - LOR_ALLOC_FAIL_ERR
+ *       The few nodes the operations may need are allocated before the
+ *       trees are touched, so on error they are left unchanged.
+ *
+ * int Lor_AVL_delete_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, Lor_AVL_map mapfn);
+ *     This function removes the items of the key interval [a, b[ at once:
+ *     the interval is cut out of the tree by two splits and the rest  is
+ *     joined back, in O(log n + k) for k items removed.
+ *     Parameters:
+ *         - tree  -> the AVL tree
+ *         - a     -> lower limit of interval, NULL for no limit
+ *         - b     -> upper limit of interval, NULL for no limit
+ *         - mapfn -> called on the data of each item removed, in increasing
+ *                    key order; if NULL, the data is released with the
+ *                    freedata function of the tree, if any
+ *     Returns:
+ *         - LOR_SUCCESS if successfull, even if no key is in [a, b[
+ *         - LOR_ALLOC_FAIL_ERR if the few nodes needed up front could not be
+ *           allocated; the tree is left unchanged
+ *
  * int Lor_AVL_traverse_lr(Lor_AVL_bst *restrict tree, Lor_AVL_map mapfn);
  *     Function the traverses the tree applying mapfn function over data.
  *     Parameters:
@@ -146,9 +479,20 @@
 
 /*#define LOR_AVL_ONLY_DISTINCT_KEYS */
 
+#include <Lor_mem_pool.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
+#ifndef LOR_AVL_BST_MAX_HEIGHT
+#define LOR_AVL_BST_MAX_HEIGHT 32
+#endif
+
+/* Number of searches Lor_AVL_find_batch walks in lockstep */
+#ifndef LOR_AVL_FIND_BATCH_GROUP
+#define LOR_AVL_FIND_BATCH_GROUP 16
+#endif
+
 typedef struct _Lor_AVL_bst_node Lor_AVL_bst_node;
 typedef struct _Lor_AVL_bst Lor_AVL_bst;
 
@@ -157,19 +501,89 @@ typedef void *(*Lor_AVL_alloc)(size_t nbytes);
 typedef void (*Lor_AVL_free_node)(void *ptr);
 typedef void (*Lor_AVL_free_data)(void *ptr);
 typedef void (*Lor_AVL_map)(void *ptr);
+typedef void *(*Lor_AVL_ctx_alloc)(void *ctx, size_t nbytes);
+typedef void (*Lor_AVL_ctx_free_node)(void *ctx, void *ptr, size_t nbytes);
+typedef bool (*Lor_AVL_next_item)(void *ctx, void **key, void **data);
+typedef void (*Lor_AVL_summarize)(void *summary, const void *key, const void *data);
+typedef void (*Lor_AVL_combine)(void *summary, const void *left, const void *right);
+
+typedef struct {
+    Lor_AVL_ctx_alloc alloc;
+    Lor_AVL_ctx_free_node freenode;
+    void *ctx;                       /* passed back to alloc and freenode */
+} Lor_AVL_allocator;
+
+/* Summary kept on every node of a tree, a monoid over the items of the
+ * subtree: combine must be associative, with identity as neutral element */
+typedef struct {
+    size_t size;                 /* bytes of a summary */
+    Lor_AVL_summarize summarize; /* summary of a single item */
+    Lor_AVL_combine combine;     /* summary may be the same as left or right */
+    const void *identity;        /* summary of no items */
+} Lor_AVL_augmentation;
+
+/* Position on a leaf of a tree, for in order walks.  Meant to live on the
+ * stack of the caller: it is not allocated, nor has to be released. */
+typedef struct {
+    Lor_AVL_bst *tree;
+    Lor_AVL_bst_node *leaf;                          /* NULL if not positioned */
+    size_t height;                                   /* number of nodes in stack */
+    Lor_AVL_bst_node *stack[LOR_AVL_BST_MAX_HEIGHT]; /* internal nodes above leaf */
+} Lor_AVL_cursor;
 
 extern Lor_AVL_bst *Lor_AVL_create(void);
 extern int Lor_AVL_init(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare, Lor_AVL_alloc alloc,
                      Lor_AVL_free_node freenode, Lor_AVL_free_data freedata);
+extern int Lor_AVL_init_with_allocator(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+                                    const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata);
+extern int Lor_AVL_init_with_pool(Lor_AVL_bst *restrict tree, Lor_AVL_compare compare,
+                               Lor_mem_pool *pool, Lor_AVL_free_data freedata);
 extern int Lor_AVL_destroy(Lor_AVL_bst **restrict tree);
 extern int Lor_AVL_clear(Lor_AVL_bst *restrict tree);
+extern int Lor_AVL_discard(Lor_AVL_bst *restrict tree, bool freedata);
+extern int Lor_AVL_set_node_alignment(Lor_AVL_bst *restrict tree, size_t align);
+extern int Lor_AVL_set_leaf_threads(Lor_AVL_bst *restrict tree, bool enable);
+extern int Lor_AVL_set_augmentation(Lor_AVL_bst *restrict tree, const Lor_AVL_augmentation *aug);
+extern int Lor_AVL_set_subtree_sizes(Lor_AVL_bst *restrict tree, bool enable);
+extern void Lor_AVL_range_aggregate(Lor_AVL_bst *restrict tree, const void *a, const void *b, void *result);
 extern Lor_AVL_bst_node *Lor_AVL_find(Lor_AVL_bst *restrict tree, const void *key);
+extern size_t Lor_AVL_find_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+                                 Lor_AVL_bst_node *out[]);
+extern size_t Lor_AVL_find_sorted_batch(Lor_AVL_bst *restrict tree, const void *const keys[], size_t n,
+                                        Lor_AVL_bst_node *out[]);
+extern int Lor_AVL_rank(Lor_AVL_bst *restrict tree, const void *key, size_t *rank);
+extern int Lor_AVL_select(Lor_AVL_bst *restrict tree, size_t i, Lor_AVL_bst_node **leaf);
+extern int Lor_AVL_count_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, size_t *count);
 extern Lor_AVL_bst_node *Lor_AVL_interval_find(Lor_AVL_bst *restrict tree, const void *a, const void *b);
 extern void *Lor_AVL_get_data_from_node(Lor_AVL_bst_node *node);
+extern void *Lor_AVL_get_key_from_node(Lor_AVL_bst_node *node);
+extern Lor_AVL_bst_node *Lor_AVL_successor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf);
+extern Lor_AVL_bst_node *Lor_AVL_predecessor(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *leaf);
+extern void Lor_AVL_cursor_init(Lor_AVL_cursor *cur, Lor_AVL_bst *restrict tree);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_first(Lor_AVL_cursor *cur);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_last(Lor_AVL_cursor *cur);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_lower_bound(Lor_AVL_cursor *cur, const void *key);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_upper_bound(Lor_AVL_cursor *cur, const void *key);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_floor(Lor_AVL_cursor *cur, const void *key);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_ceiling(Lor_AVL_cursor *cur, const void *key);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_next(Lor_AVL_cursor *cur);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_prev(Lor_AVL_cursor *cur);
+extern Lor_AVL_bst_node *Lor_AVL_cursor_find(Lor_AVL_cursor *cur, const void *key);
+extern int Lor_AVL_cursor_insert(Lor_AVL_cursor *cur, void *key, void *data);
 extern void Lor_AVL_process_node_list(Lor_AVL_bst_node *nodelst, Lor_AVL_map mapfn);
 extern void Lor_AVL_clear_node_list(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *nodelst);
 extern int Lor_AVL_insert(Lor_AVL_bst *restrict tree, void *key, void *data);
+extern int Lor_AVL_build_sorted(Lor_AVL_bst *restrict tree, void *const keys[],
+                                void *const data[], size_t n);
+extern int Lor_AVL_build_from_iter(Lor_AVL_bst *restrict tree, Lor_AVL_next_item next,
+                                   void *ctx, size_t n);
 extern int Lor_AVL_delete(Lor_AVL_bst *restrict tree, void *key, void **data);
+extern int Lor_AVL_join(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2);
+extern int Lor_AVL_split(Lor_AVL_bst *restrict tree, const void *key, Lor_AVL_bst *restrict ge);
+extern int Lor_AVL_union(Lor_AVL_bst *restrict t1, Lor_AVL_bst *restrict t2);
+extern int Lor_AVL_intersection(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2);
+extern int Lor_AVL_difference(Lor_AVL_bst *restrict t1, const Lor_AVL_bst *restrict t2);
+extern int Lor_AVL_delete_range(Lor_AVL_bst *restrict tree, const void *a, const void *b, Lor_AVL_map mapfn);
 extern int Lor_AVL_traverse_lr(Lor_AVL_bst *restrict tree, Lor_AVL_map mapfn);
 
 #endif
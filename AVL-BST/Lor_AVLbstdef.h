@@ -10,13 +10,20 @@
 #include "Lor_AVLbst.h"
 #include <Lor_BSTs.h>
 #include <Lor_assert.h>
+#include <string.h>
 
-#ifndef LOR_AVL_BST_MAX_HEIGHT
-#define LOR_AVL_BST_MAX_HEIGHT 32
+#ifndef LOR_AVL_PREFETCH
+/* Hint the load of a node that will be read a bit later */
+#if defined(__GNUC__)
+#  define LOR_AVL_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#  define LOR_AVL_PREFETCH(addr) ((void) (addr))
+#endif
 #endif
 
 struct _Lor_AVL_bst_node {
     int32_t height;
+    uint32_t size;                          /* number of leafs of the subtree            */
     void *key;
     struct _Lor_AVL_bst_node *subtrees[2];  /* [0] for  left,  [1]  for  right subtree   */
 };                                          /* In this  tree  model,  the  pointer  to   */
@@ -29,8 +36,22 @@ struct _Lor_AVL_bst {
     Lor_AVL_alloc alloc;
     Lor_AVL_free_node freenode;
     Lor_AVL_free_data freedata;
+    Lor_AVL_allocator allocator;  /* used instead of alloc/freenode if allocator.alloc is set */
+    Lor_mem_pool *pool;           /* non-NULL if the tree is bound to a memory pool */
+    size_t nodealign;             /* alignment of the nodes taken from pool, 0 for the default */
+    size_t nodesize;              /* summaryoffset + aug.size */
+    size_t summaryoffset;         /* sizeof(Lor_AVL_threaded_node) if the leafs are threaded */
+    Lor_AVL_augmentation aug;     /* aug.combine is NULL if there are no summaries */
+    bool sizes;                   /* true if the nodes keep the number of leafs below them */
 };
 
+/* Node of a tree with leaf threads.  Any node may become a leaf, so all of
+ * them are allocated with the room for the links to the neighbour leafs. */
+typedef struct {
+    Lor_AVL_bst_node node;
+    Lor_AVL_bst_node *threads[2];           /* [0] for previous, [1] for next leaf */
+} Lor_AVL_threaded_node;
+
 typedef struct {
     size_t height;                                   /* number of nodes in avl_stack */
     const Lor_AVL_bst *tree;                         /* the tree being traversed */
@@ -48,7 +69,97 @@ static inline void Lor_AVL_traverser_init(Lor_AVL_traverser *trav, Lor_AVL_bst *
                           };
 }
 
-static inline void tree_left_rotate(Lor_AVL_bst_node *node)
+static inline Lor_AVL_bst_node *tree_alloc_node(Lor_AVL_bst *restrict tree)
+{
+    if (tree->nodealign) {
+        return Lor_mem_pool_slab_aligned_alloc(tree->pool, tree->nodesize, tree->nodealign);
+    }
+    if (tree->allocator.alloc) {
+        return tree->allocator.alloc(tree->allocator.ctx, tree->nodesize);
+    }
+    return tree->alloc(tree->nodesize);
+}
+
+static inline void tree_free_node(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    if (tree->allocator.alloc) {
+        if (tree->allocator.freenode) {
+            tree->allocator.freenode(tree->allocator.ctx, node, tree->nodesize);
+        }
+    }
+    else {
+        tree->freenode(node);
+    }
+}
+
+static inline bool tree_is_threaded(const Lor_AVL_bst *restrict tree)
+{
+    return tree->summaryoffset == sizeof(Lor_AVL_threaded_node);
+}
+
+/* The summary follows the node, and its threads if any */
+static inline void *tree_summary(const Lor_AVL_bst *restrict tree, const Lor_AVL_bst_node *node)
+{
+    return (char *) node + tree->summaryoffset;
+}
+
+/* Compute again the number of leafs below the internal node */
+static inline void tree_fix_size(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    if (tree->sizes) {
+        node->size = node->subtrees[0]->size + node->subtrees[1]->size;
+    }
+}
+
+/* Compute again the summary of node from its item or its subtrees */
+static inline void tree_fix_summary(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
+{
+    if (!tree->aug.combine) {
+        return;
+    }
+    if (!node->subtrees[1]) {
+        tree->aug.summarize(tree_summary(tree, node), node->key, node->subtrees[0]);
+    }
+    else {
+        tree->aug.combine(tree_summary(tree, node), tree_summary(tree, node->subtrees[0]),
+                          tree_summary(tree, node->subtrees[1]));
+    }
+}
+
+static inline Lor_AVL_bst_node **tree_leaf_threads(Lor_AVL_bst_node *leaf)
+{
+    return ((Lor_AVL_threaded_node *) leaf)->threads;
+}
+
+/* Make next the leaf following prev, either of them possibly NULL */
+static inline void tree_link_leafs(Lor_AVL_bst_node *prev, Lor_AVL_bst_node *next)
+{
+    if (prev) tree_leaf_threads(prev)[1] = next;
+    if (next) tree_leaf_threads(next)[0] = prev;
+}
+
+/* Copy the node src over dst.  A threaded leaf keeps its place in the list
+ * of leafs: its neighbours are relinked to dst. */
+static inline void tree_move_node(Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *dst,
+                                  const Lor_AVL_bst_node *src)
+{
+    memcpy(dst, src, tree->nodesize);
+    if (tree_is_threaded(tree) && !dst->subtrees[1] && dst->subtrees[0]) {
+        Lor_AVL_bst_node **threads = tree_leaf_threads(dst);
+        tree_link_leafs(threads[0], dst);
+        tree_link_leafs(dst, threads[1]);
+    }
+}
+
+/* Equality test of the leaf lookups.  Keys interned with a
+ * Lor_mem_pool_strtab are equal iff they are the same pointer, which
+ * saves the call to compare on every hit. */
+static inline bool tree_keys_equal(const Lor_AVL_bst *restrict tree, const void *key1, const void *key2)
+{
+    return key1 == key2 || !tree->compare(key1, key2);
+}
+
+static inline void tree_left_rotate(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
 {
     void *tmpkey = node->key;
     Lor_AVL_bst_node *tmpnode = node->subtrees[0];
@@ -59,9 +170,11 @@ static inline void tree_left_rotate(Lor_AVL_bst_node *node)
     node->subtrees[0]->subtrees[1] = node->subtrees[0]->subtrees[0];
     node->subtrees[0]->subtrees[0] = tmpnode;
     node->subtrees[0]->key = tmpkey;
+    tree_fix_size(tree, node->subtrees[0]);
+    tree_fix_summary(tree, node->subtrees[0]);
 }
 
-static inline void tree_right_rotate(Lor_AVL_bst_node *node)
+static inline void tree_right_rotate(const Lor_AVL_bst *restrict tree, Lor_AVL_bst_node *node)
 {
     void *tmpkey = node->key;
     Lor_AVL_bst_node *tmpnode = node->subtrees[1];
@@ -72,6 +185,8 @@ static inline void tree_right_rotate(Lor_AVL_bst_node *node)
     node->subtrees[1]->subtrees[0] = node->subtrees[1]->subtrees[1];
     node->subtrees[1]->subtrees[1] = tmpnode;
     node->subtrees[1]->key = tmpkey;
+    tree_fix_size(tree, node->subtrees[1]);
+    tree_fix_summary(tree, node->subtrees[1]);
 }
 
 #endif
@@ -0,0 +1,323 @@
+/* C file:
+ *         AVLcbst.c
+ * Implementation for compact AVL binary search tree
+ */
+#include "Lor_AVLcbstdef.h"
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+static uint32_t treec_child(const Lor_AVLc_bst *restrict, uint32_t, int);
+static void treec_set_child(Lor_AVLc_bst *restrict, uint32_t, int, uint32_t);
+static int32_t treec_height(const Lor_AVLc_bst *restrict, uint32_t);
+static void treec_set_height(Lor_AVLc_bst *restrict, uint32_t, int32_t);
+static void treec_update_height(Lor_AVLc_bst *restrict, uint32_t);
+static uint32_t treec_rotate(Lor_AVLc_bst *restrict, uint32_t, int);
+static uint32_t treec_rebalance(Lor_AVLc_bst *restrict, uint32_t);
+
+#define AVLC_INITIAL_CAPACITY 64
+
+_Static_assert(sizeof(Lor_AVLc_node) == 16, "a compact node must take 16 bytes");
+
+/**********************************************************
+ * Grow the node and data arrays to 'capacity' entries.
+ **********************************************************/
+static int __AVLc_grow(Lor_AVLc_bst *restrict tree, uint32_t capacity)
+{
+    Lor_AVLc_node *nodes = realloc(tree->nodes, capacity * sizeof *nodes);
+    if (!nodes) {
+        LOR_PERROR("realloc failed", __func__);
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    tree->nodes = nodes;
+
+    void **data = realloc(tree->data, capacity * sizeof *data);
+    if (!data) {
+        LOR_PERROR("realloc failed", __func__);
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    tree->data = data;
+    tree->capacity = capacity;
+
+    return LOR_SUCCESS;
+}
+
+/**********************************************************
+ * Take a node from the free list, or from the end of the
+ * node array, growing it by doubling.  Returns 0 if the
+ * arrays could not be grown.
+ **********************************************************/
+static uint32_t __AVLc_alloc_node(Lor_AVLc_bst *restrict tree, uint64_t key, void *data)
+{
+    uint32_t i = tree->freelist;
+    if (i) {
+        tree->freelist = AVLC_NODE(tree, i)->links[0];
+    }
+    else {
+        if (tree->nnodes == tree->capacity) {
+            if (tree->capacity > LOR_AVLC_MAX_ITEMS) {
+                return 0;
+            }
+            uint32_t capacity = (tree->capacity) ? 2 * tree->capacity : AVLC_INITIAL_CAPACITY;
+            if (capacity > LOR_AVLC_MAX_ITEMS + 1) {
+                capacity = LOR_AVLC_MAX_ITEMS + 1;
+            }
+            if (__AVLc_grow(tree, capacity) != LOR_SUCCESS) {
+                return 0;
+            }
+        }
+        i = tree->nnodes++;
+    }
+
+    *AVLC_NODE(tree, i) = (Lor_AVLc_node){ .key = key };
+    treec_set_height(tree, i, 1);
+    tree->data[i] = data;
+    return i;
+}
+
+static void __AVLc_free_node(Lor_AVLc_bst *restrict tree, uint32_t i)
+{
+    AVLC_NODE(tree, i)->links[0] = tree->freelist;
+    tree->data[i] = NULL;
+    tree->freelist = i;
+}
+
+/* Attach 'child' where path[top] linked down, or as the root if top is 0 */
+static inline void __AVLc_relink(Lor_AVLc_bst *restrict tree, const uint32_t *path, const int *dirs,
+                                 size_t top, uint32_t child)
+{
+    if (top) {
+        treec_set_child(tree, path[top - 1], dirs[top - 1], child);
+    }
+    else {
+        tree->root = child;
+    }
+}
+
+/* Rebalance the nodes of path[0..top), up to the first subtree whose height
+ * did not change */
+static void __AVLc_rebalance_path(Lor_AVLc_bst *restrict tree, const uint32_t *path, const int *dirs,
+                                  size_t top)
+{
+    while (top) {
+        uint32_t i = path[--top];
+        int32_t oldheight = treec_height(tree, i);
+        i = treec_rebalance(tree, i);
+        __AVLc_relink(tree, path, dirs, top, i);
+        if (treec_height(tree, i) == oldheight) {
+            break;
+        }
+    }
+}
+
+Lor_AVLc_bst *Lor_AVLc_create(void)
+{
+    Lor_AVLc_bst *tree = malloc(sizeof *tree);
+    if (!tree) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    return tree;
+}
+
+int Lor_AVLc_init(Lor_AVLc_bst *restrict tree, Lor_AVL_free_data freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    *tree = (Lor_AVLc_bst){ .nitems = 0,
+                            .root = 0,
+                            .nnodes = 1,  /* node 0 is the null link */
+                            .capacity = 0,
+                            .freelist = 0,
+                            .nodes = NULL,
+                            .data = NULL,
+                            .freedata = freedata,
+                          };
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLc_reserve(Lor_AVLc_bst *restrict tree, size_t nitems)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (nitems > LOR_AVLC_MAX_ITEMS) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    if (nitems + 1 <= tree->capacity) {
+        return LOR_SUCCESS;
+    }
+    return __AVLc_grow(tree, (uint32_t) nitems + 1);
+}
+
+int Lor_AVLc_destroy(Lor_AVLc_bst **restrict tree)
+{
+    if (!(*tree)) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    if ((*tree)->root) {
+        return LOR_DESTROY_ROOT_NON_NULL;
+    }
+    free((*tree)->nodes);
+    free((*tree)->data);
+    free(*tree);
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLc_clear(Lor_AVLc_bst *restrict tree)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->root) {
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    /* The nodes in the free list have NULL data, so a sweep of the array
+     * reaches every item */
+    if (tree->freedata) {
+        for (uint32_t i = 1; i < tree->nnodes; i++) {
+            if (tree->data[i]) tree->freedata(tree->data[i]);
+        }
+    }
+
+    tree->root = 0;
+    tree->nnodes = 1;
+    tree->freelist = 0;
+    tree->nitems = 0;
+    return LOR_SUCCESS;
+}
+
+void *Lor_AVLc_find(const Lor_AVLc_bst *restrict tree, uint64_t key)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    uint32_t i = tree->root;
+    while (i) {
+        const Lor_AVLc_node *node = AVLC_NODE(tree, i);
+        if (key == node->key) {
+            return tree->data[i];
+        }
+        i = node->links[key > node->key] & AVLC_INDEX_MASK;
+    }
+    return NULL;
+}
+
+int Lor_AVLc_insert(Lor_AVLc_bst *restrict tree, uint64_t key, void *data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(data, __func__, "argument data must be non-NULL");
+
+    uint32_t path[LOR_AVLC_BST_MAX_HEIGHT];  /* nodes on the path, for rebalancing */
+    int dirs[LOR_AVLC_BST_MAX_HEIGHT];
+    size_t height = 0;
+
+    uint32_t i = tree->root;
+    while (i) {
+        uint64_t nodekey = AVLC_NODE(tree, i)->key;
+        if (key == nodekey) { /* permit only distinct keys */
+#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
+            return LOR_DISTINCT_KEY_ERR;
+#else  /* Updates the data if try same key insertion */
+            void *tmpdata = tree->data[i];
+            tree->data[i] = data;
+            if (tree->freedata) tree->freedata(tmpdata);
+            return LOR_SUCCESS;
+#endif
+        }
+        if (height == LOR_AVLC_BST_MAX_HEIGHT) {
+            return LOR_MAX_HEIGHT_ERR;
+        }
+        path[height] = i;
+        dirs[height] = key > nodekey;
+        i = treec_child(tree, i, dirs[height++]);
+    }
+
+    uint32_t newnode = __AVLc_alloc_node(tree, key, data);
+    if (!newnode) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    __AVLc_relink(tree, path, dirs, height, newnode);
+    ++tree->nitems;
+
+    __AVLc_rebalance_path(tree, path, dirs, height);
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLc_delete(Lor_AVLc_bst *restrict tree, uint64_t key, void **data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->root) {
+        *data = NULL;
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    uint32_t path[LOR_AVLC_BST_MAX_HEIGHT];  /* nodes on the path, for rebalancing */
+    int dirs[LOR_AVLC_BST_MAX_HEIGHT];
+    size_t height = 0;
+
+    uint32_t i = tree->root;
+    while (i && key != AVLC_NODE(tree, i)->key) {
+        path[height] = i;
+        dirs[height] = key > AVLC_NODE(tree, i)->key;
+        i = treec_child(tree, i, dirs[height++]);
+    }
+    if (!i) {
+        *data = NULL;
+        return LOR_DELETE_NON_EXISTENT_KEY_ERR;
+    }
+
+    *data = tree->data[i];
+    if (treec_child(tree, i, 0) && treec_child(tree, i, 1)) {
+        /* Move the successor in place of the node, and remove it instead */
+        uint32_t node = i;
+        path[height] = i;
+        dirs[height++] = 1;
+        i = treec_child(tree, i, 1);
+        while (treec_child(tree, i, 0)) {
+            path[height] = i;
+            dirs[height++] = 0;
+            i = treec_child(tree, i, 0);
+        }
+        AVLC_NODE(tree, node)->key = AVLC_NODE(tree, i)->key;
+        tree->data[node] = tree->data[i];
+    }
+    uint32_t left = treec_child(tree, i, 0);
+    __AVLc_relink(tree, path, dirs, height, (left) ? left : treec_child(tree, i, 1));
+    __AVLc_free_node(tree, i);
+    --tree->nitems;
+
+    __AVLc_rebalance_path(tree, path, dirs, height);
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLc_traverse_lr(const Lor_AVLc_bst *restrict tree, Lor_AVL_map mapfn)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    if (!tree->root) { /* empty tree */
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    uint32_t stack[LOR_AVLC_BST_MAX_HEIGHT];
+    size_t top = 0;
+    uint32_t i = tree->root;
+    while (i || top) {
+        while (i) {
+            if (top == LOR_AVLC_BST_MAX_HEIGHT) {
+                return LOR_MAX_HEIGHT_ERR;
+            }
+            stack[top++] = i;
+            i = treec_child(tree, i, 0);
+        }
+        i = stack[--top];
+        mapfn(tree->data[i]); /* map over data */
+        i = treec_child(tree, i, 1);
+    }
+    return LOR_SUCCESS;
+}
+
+/* End Of File */
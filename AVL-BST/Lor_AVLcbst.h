@@ -0,0 +1,79 @@
+/* C Header file:
+ *               Lor_AVLcbst.h
+ *
+ * Interface for compact AVL binary search tree.
+ *
+ * A node-oriented AVL tree (see Lor_AVLnbst.h) whose keys are 64 bit
+ * unsigned integers stored inline in the nodes.  The nodes live in one
+ * array owned by the tree and link their subtrees by 28 bit indices, with
+ * the height packed in the remaining bits, so a node takes 16 bytes and
+ * four of them share a cache line.  The data pointers are kept in a
+ * parallel array that Lor_AVLc_find reads only once the key is found.
+ *
+ * Signed keys keep their order if their sign bit is flipped, e.g.
+ * (uint64_t) key ^ (UINT64_C(1) << 63).
+ *
+ * Public functions:
+ *
+ * Lor_AVLc_bst *Lor_AVLc_create(void);
+ *     This functions returns a new Lor_AVLc_bst on the heap.
+ *
+ * int Lor_AVLc_init(Lor_AVLc_bst *restrict tree, Lor_AVL_free_data freedata);
+ *     This function initializes an empty tree.  No memory is allocated
+ *     until the first insertion (or Lor_AVLc_reserve).
+ *     Returns:
+ *         - LOR_SUCCESS
+ *
+ * int Lor_AVLc_reserve(Lor_AVLc_bst *restrict tree, size_t nitems);
+ *     This function grows the node array to hold nitems items.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_ALLOC_FAIL_ERR if the arrays could not be grown, or if
+ *           nitems is larger than LOR_AVLC_MAX_ITEMS
+ *
+ * int Lor_AVLc_destroy(Lor_AVLc_bst **restrict tree);
+ *     This function releases the arrays of an empty tree and the tree.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_FREE_NULLPTR_WARN if *tree is a NULL pointer
+ *         - LOR_DESTROY_ROOT_NON_NULL if the tree is not empty
+ *
+ * int Lor_AVLc_clear(Lor_AVLc_bst *restrict tree);
+ *     This function empties the tree, keeping its arrays for reuse.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_EMPTY_TREE_ERR if the tree is already empty
+ *
+ * void *Lor_AVLc_find(const Lor_AVLc_bst *restrict tree, uint64_t key);
+ *     Returns:
+ *         - the data of key
+ *         - NULL if key is not on tree
+ *
+ * int Lor_AVLc_insert(Lor_AVLc_bst *restrict tree, uint64_t key, void *data);
+ * int Lor_AVLc_delete(Lor_AVLc_bst *restrict tree, uint64_t key, void **data);
+ * int Lor_AVLc_traverse_lr(const Lor_AVLc_bst *restrict tree, Lor_AVL_map mapfn);
+ *     Same as their Lor_AVL_ counterparts.  Lor_AVLc_insert also returns
+ *     LOR_ALLOC_FAIL_ERR if the node array could not be grown.
+ **************************************************************************/
+#ifndef LOR_AVL_CBST_H
+#define LOR_AVL_CBST_H 1
+
+#include <Lor_AVLbst.h>
+#include <stdint.h>
+
+/* Largest number of items of a compact tree: node 0 is reserved */
+#define LOR_AVLC_MAX_ITEMS ((UINT32_C(1) << 28) - 2)
+
+typedef struct _Lor_AVLc_bst Lor_AVLc_bst;
+
+extern Lor_AVLc_bst *Lor_AVLc_create(void);
+extern int Lor_AVLc_init(Lor_AVLc_bst *restrict tree, Lor_AVL_free_data freedata);
+extern int Lor_AVLc_reserve(Lor_AVLc_bst *restrict tree, size_t nitems);
+extern int Lor_AVLc_destroy(Lor_AVLc_bst **restrict tree);
+extern int Lor_AVLc_clear(Lor_AVLc_bst *restrict tree);
+extern void *Lor_AVLc_find(const Lor_AVLc_bst *restrict tree, uint64_t key);
+extern int Lor_AVLc_insert(Lor_AVLc_bst *restrict tree, uint64_t key, void *data);
+extern int Lor_AVLc_delete(Lor_AVLc_bst *restrict tree, uint64_t key, void **data);
+extern int Lor_AVLc_traverse_lr(const Lor_AVLc_bst *restrict tree, Lor_AVL_map mapfn);
+
+#endif
@@ -0,0 +1,117 @@
+/* C Header file:
+ *               Lor_AVLcbstdef.h
+ * Type definitions for compact AVL binary search tree
+ * NOTE: This header file is for exclusive use of the implementation
+ * and should not be exposed.
+ */
+#ifndef LOR_AVL_CBST_DEF_H
+#define LOR_AVL_CBST_DEF_H 1
+
+#include "Lor_AVLcbst.h"
+#include <Lor_BSTs.h>
+#include <Lor_assert.h>
+
+/* 28 bit indices bound the tree to fewer than 2^28 nodes, well within 48
+ * levels (see Lor_AVLnbstdef.h) */
+#ifndef LOR_AVLC_BST_MAX_HEIGHT
+#define LOR_AVLC_BST_MAX_HEIGHT 48
+#endif
+
+/* Each link holds a 28 bit node index in its low bits, and a nibble of the
+ * height of the node in its high bits: the low nibble in links[0], the
+ * high one in links[1].  Index 0 is the null link. */
+#define AVLC_INDEX_BITS 28
+#define AVLC_INDEX_MASK ((UINT32_C(1) << AVLC_INDEX_BITS) - 1)
+
+typedef struct Lor_AVLc_node {
+    uint64_t key;
+    uint32_t links[2];  /* [0] for left, [1] for right subtree */
+} Lor_AVLc_node;
+
+struct _Lor_AVLc_bst {
+    size_t nitems;          /* number of items */
+    uint32_t root;          /* index of the root node, 0 if the tree is empty */
+    uint32_t nnodes;        /* nodes in use or in the free list, node 0 included */
+    uint32_t capacity;      /* length of the arrays */
+    uint32_t freelist;      /* released nodes, linked through links[0] */
+    Lor_AVLc_node *nodes;
+    void **data;            /* data of each node */
+    Lor_AVL_free_data freedata;
+};
+
+#define AVLC_NODE(tree, i) (&(tree)->nodes[i])
+
+/*========== Inline functions ===========*/
+
+static inline uint32_t treec_child(const Lor_AVLc_bst *restrict tree, uint32_t i, int dir)
+{
+    return AVLC_NODE(tree, i)->links[dir] & AVLC_INDEX_MASK;
+}
+
+static inline void treec_set_child(Lor_AVLc_bst *restrict tree, uint32_t i, int dir, uint32_t child)
+{
+    uint32_t *link = &AVLC_NODE(tree, i)->links[dir];
+    *link = (*link & ~AVLC_INDEX_MASK) | child;
+}
+
+static inline int32_t treec_height(const Lor_AVLc_bst *restrict tree, uint32_t i)
+{
+    if (!i) {
+        return 0;
+    }
+    const Lor_AVLc_node *node = AVLC_NODE(tree, i);
+    return (int32_t) ((node->links[0] >> AVLC_INDEX_BITS) | ((node->links[1] >> AVLC_INDEX_BITS) << 4));
+}
+
+static inline void treec_set_height(Lor_AVLc_bst *restrict tree, uint32_t i, int32_t height)
+{
+    Lor_AVLc_node *node = AVLC_NODE(tree, i);
+    node->links[0] = (node->links[0] & AVLC_INDEX_MASK) | ((uint32_t) (height & 0xF) << AVLC_INDEX_BITS);
+    node->links[1] = (node->links[1] & AVLC_INDEX_MASK) | ((uint32_t) (height >> 4) << AVLC_INDEX_BITS);
+}
+
+static inline void treec_update_height(Lor_AVLc_bst *restrict tree, uint32_t i)
+{
+    int32_t lh = treec_height(tree, treec_child(tree, i, 0));
+    int32_t rh = treec_height(tree, treec_child(tree, i, 1));
+    treec_set_height(tree, i, 1 + ((lh > rh) ? lh : rh));
+}
+
+/* Rotate the subtree at i; dir 0 rotates left, 1 rotates right.  Returns
+ * the new root of the subtree. */
+static inline uint32_t treec_rotate(Lor_AVLc_bst *restrict tree, uint32_t i, int dir)
+{
+    uint32_t up = treec_child(tree, i, !dir);
+
+    treec_set_child(tree, i, !dir, treec_child(tree, up, dir));
+    treec_set_child(tree, up, dir, i);
+    treec_update_height(tree, i);
+    treec_update_height(tree, up);
+    return up;
+}
+
+/* Restore the balance of the subtree at i after one of its subtrees changed
+ * height by one.  Returns the new root of the subtree. */
+static inline uint32_t treec_rebalance(Lor_AVLc_bst *restrict tree, uint32_t i)
+{
+    uint32_t left = treec_child(tree, i, 0);
+    uint32_t right = treec_child(tree, i, 1);
+    int32_t balance = treec_height(tree, left) - treec_height(tree, right);
+
+    if (balance == 2) {
+        if (treec_height(tree, treec_child(tree, left, 0)) < treec_height(tree, treec_child(tree, left, 1))) {
+            treec_set_child(tree, i, 0, treec_rotate(tree, left, 0));  /* Left-right unbalanced */
+        }
+        return treec_rotate(tree, i, 1);
+    }
+    else if (balance == -2) {
+        if (treec_height(tree, treec_child(tree, right, 1)) < treec_height(tree, treec_child(tree, right, 0))) {
+            treec_set_child(tree, i, 1, treec_rotate(tree, right, 1));  /* Right-left unbalanced */
+        }
+        return treec_rotate(tree, i, 0);
+    }
+    treec_update_height(tree, i);
+    return i;
+}
+
+#endif
@@ -0,0 +1,13 @@
+/* C file:
+ *         AVLgen.c
+ * Type-specialized AVL binary search trees provided by the library
+ */
+#include "Lor_AVLgen.h"
+#include <errno.h>
+#include <stdio.h>
+
+LOR_AVL_IMPL(Lor_AVLu64, uint64_t, LOR_AVL_CMP_NUM)
+LOR_AVL_IMPL(Lor_AVLi64, int64_t, LOR_AVL_CMP_NUM)
+LOR_AVL_IMPL(Lor_AVLf64, double, LOR_AVL_CMP_NUM)
+
+/* End Of File */
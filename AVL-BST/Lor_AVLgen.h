@@ -0,0 +1,394 @@
+/* C Header file:
+ *               Lor_AVLgen.h
+ *
+ * Type-specialized AVL binary search trees.
+ *
+ * The macros below emit a node-oriented AVL tree (see Lor_AVLnbst.h) whose
+ * keys are stored by value in the nodes and compared by an expression that
+ * the compiler can inline, instead of through a function pointer on a
+ * void * key.
+ *
+ * LOR_AVL_DECLARE(prefix, key_type)
+ *     Declares the types 'prefix' (the tree) and 'prefix_node', and the
+ *     prototypes of the functions listed below.  Goes in a header.
+ *
+ * LOR_AVL_IMPL(prefix, key_type, cmp)
+ *     Defines the functions, in exactly one translation unit.  'cmp' is
+ *     the name of a function or of a function-like macro cmp(a, b) that
+ *     returns a negative, zero or positive int as a is smaller, equal or
+ *     greater than b, e.g. LOR_AVL_CMP_NUM.
+ *
+ * LOR_AVL_DEFINE(prefix, key_type, cmp)
+ *     Both of the above, for a tree used in a single translation unit.
+ *
+ * The library provides the instantiations Lor_AVLu64, Lor_AVLi64 and
+ * Lor_AVLf64 for uint64_t, int64_t and double keys (NaN keys are not
+ * supported).
+ *
+ * Generated functions:
+ *
+ * prefix *prefix_create(void);
+ *     This functions returns a new tree on the heap.
+ *
+ * int prefix_init(prefix *restrict tree, Lor_AVL_free_data freedata);
+ *     This function initializes an empty tree whose nodes are taken with
+ *     malloc.
+ *     Returns:
+ *         - LOR_SUCCESS
+ *
+ * int prefix_init_with_pool(prefix *restrict tree, Lor_mem_pool *pool,
+ *                           Lor_AVL_free_data freedata);
+ *     Same, with the nodes taken from the slab of pool.
+ *
+ * int prefix_destroy(prefix **restrict tree);
+ * int prefix_clear(prefix *restrict tree);
+ * int prefix_insert(prefix *restrict tree, key_type key, void *data);
+ * int prefix_delete(prefix *restrict tree, key_type key, void **data);
+ * int prefix_traverse_lr(const prefix *restrict tree, Lor_AVL_map mapfn);
+ *     Same as their Lor_AVLn_ counterparts.
+ *
+ * void *prefix_find(const prefix *restrict tree, key_type key);
+ *     Returns:
+ *         - the data of key
+ *         - NULL if key is not on tree
+ **************************************************************************/
+#ifndef LOR_AVL_GEN_H
+#define LOR_AVL_GEN_H 1
+
+#include <Lor_mem_pool.h>
+#include <Lor_AVLbst.h>
+#include <Lor_BSTs.h>
+#include <Lor_assert.h>
+#include <Lor_error_log.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef LOR_AVL_GEN_MAX_HEIGHT
+#define LOR_AVL_GEN_MAX_HEIGHT 48
+#endif
+
+/* Three-way comparison of numbers */
+#define LOR_AVL_CMP_NUM(a, b) (((a) > (b)) - ((a) < (b)))
+
+#define LOR_AVL_DECLARE(prefix, key_type)                                                   \
+    typedef struct prefix##_node {                                                          \
+        int32_t height;                                                                     \
+        key_type key;                                                                       \
+        void *data;                                                                         \
+        struct prefix##_node *subtrees[2];                                                  \
+    } prefix##_node;                                                                        \
+                                                                                            \
+    typedef struct prefix {                                                                 \
+        size_t nitems;                                                                      \
+        prefix##_node *root;                                                                \
+        Lor_mem_pool *pool;  /* nodes are malloc'ed if NULL */                              \
+        Lor_AVL_free_data freedata;                                                         \
+    } prefix;                                                                               \
+                                                                                            \
+    extern prefix *prefix##_create(void);                                                   \
+    extern int prefix##_init(prefix *restrict tree, Lor_AVL_free_data freedata);            \
+    extern int prefix##_init_with_pool(prefix *restrict tree, Lor_mem_pool *pool,           \
+                                       Lor_AVL_free_data freedata);                         \
+    extern int prefix##_destroy(prefix **restrict tree);                                    \
+    extern int prefix##_clear(prefix *restrict tree);                                       \
+    extern void *prefix##_find(const prefix *restrict tree, key_type key);                  \
+    extern int prefix##_insert(prefix *restrict tree, key_type key, void *data);            \
+    extern int prefix##_delete(prefix *restrict tree, key_type key, void **data);           \
+    extern int prefix##_traverse_lr(const prefix *restrict tree, Lor_AVL_map mapfn)
+
+#define LOR_AVL_IMPL(prefix, key_type, cmp)                                                 \
+    static inline int32_t prefix##__height(const prefix##_node *node)                       \
+    {                                                                                       \
+        return (node) ? node->height : 0;                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##__update_height(prefix##_node *node)                         \
+    {                                                                                       \
+        int32_t lh = prefix##__height(node->subtrees[0]);                                   \
+        int32_t rh = prefix##__height(node->subtrees[1]);                                   \
+        node->height = 1 + ((lh > rh) ? lh : rh);                                           \
+    }                                                                                       \
+                                                                                            \
+    /* dir 0 rotates left, 1 rotates right */                                               \
+    static inline void prefix##__rotate(prefix##_node **link, int dir)                      \
+    {                                                                                       \
+        prefix##_node *node = *link;                                                        \
+        prefix##_node *up = node->subtrees[!dir];                                           \
+                                                                                            \
+        node->subtrees[!dir] = up->subtrees[dir];                                           \
+        up->subtrees[dir] = node;                                                           \
+        prefix##__update_height(node);                                                      \
+        prefix##__update_height(up);                                                        \
+        *link = up;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##__rebalance(prefix##_node **link)                            \
+    {                                                                                       \
+        prefix##_node *node = *link;                                                        \
+        int32_t balance = prefix##__height(node->subtrees[0])                               \
+                          - prefix##__height(node->subtrees[1]);                            \
+                                                                                            \
+        if (balance == 2) {                                                                 \
+            prefix##_node *left = node->subtrees[0];                                        \
+            if (prefix##__height(left->subtrees[0]) < prefix##__height(left->subtrees[1])) { \
+                prefix##__rotate(&node->subtrees[0], 0);                                    \
+            }                                                                               \
+            prefix##__rotate(link, 1);                                                      \
+        }                                                                                   \
+        else if (balance == -2) {                                                           \
+            prefix##_node *right = node->subtrees[1];                                       \
+            if (prefix##__height(right->subtrees[1]) < prefix##__height(right->subtrees[0])) { \
+                prefix##__rotate(&node->subtrees[1], 1);                                    \
+            }                                                                               \
+            prefix##__rotate(link, 0);                                                      \
+        }                                                                                   \
+        else {                                                                              \
+            prefix##__update_height(node);                                                  \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Rebalance the links of stack[0..height), up to the first subtree whose */           \
+    /* height did not change */                                                             \
+    static inline void prefix##__rebalance_path(prefix##_node ***stack, size_t height)      \
+    {                                                                                       \
+        while (height) {                                                                    \
+            prefix##_node **link = stack[--height];                                         \
+            int32_t oldheight = (*link)->height;                                            \
+            prefix##__rebalance(link);                                                      \
+            if ((*link)->height == oldheight) {                                             \
+                break;                                                                      \
+            }                                                                               \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline prefix##_node *prefix##__alloc_node(prefix *restrict tree)                \
+    {                                                                                       \
+        if (tree->pool) {                                                                   \
+            return Lor_mem_pool_slab_alloc(tree->pool, sizeof(prefix##_node));              \
+        }                                                                                   \
+        return malloc(sizeof(prefix##_node));                                               \
+    }                                                                                       \
+                                                                                            \
+    static inline void prefix##__free_node(prefix *restrict tree, prefix##_node *node)      \
+    {                                                                                       \
+        if (tree->pool) {                                                                   \
+            Lor_mem_pool_slab_free(tree->pool, node, sizeof(prefix##_node));                \
+        }                                                                                   \
+        else {                                                                              \
+            free(node);                                                                     \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    prefix *prefix##_create(void)                                                           \
+    {                                                                                       \
+        prefix *tree = malloc(sizeof *tree);                                                \
+        if (!tree) {                                                                        \
+            LOR_PERROR("malloc failed", __func__);                                          \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return tree;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_init(prefix *restrict tree, Lor_AVL_free_data freedata)                    \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+                                                                                            \
+        *tree = (prefix){ .nitems = 0, .root = NULL, .pool = NULL, .freedata = freedata };  \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_init_with_pool(prefix *restrict tree, Lor_mem_pool *pool,                  \
+                                Lor_AVL_free_data freedata)                                 \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+        Lor_assert(pool, __func__, "argument pool must be non-NULL");                       \
+                                                                                            \
+        *tree = (prefix){ .nitems = 0, .root = NULL, .pool = pool, .freedata = freedata };  \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_destroy(prefix **restrict tree)                                            \
+    {                                                                                       \
+        if (!(*tree)) {                                                                     \
+            return LOR_FREE_NULLPTR_WARN;                                                   \
+        }                                                                                   \
+        if ((*tree)->root) {                                                                \
+            return LOR_DESTROY_ROOT_NON_NULL;                                               \
+        }                                                                                   \
+        free(*tree);                                                                        \
+                                                                                            \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_clear(prefix *restrict tree)                                               \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+                                                                                            \
+        if (!tree->root) {                                                                  \
+            return LOR_EMPTY_TREE_ERR;                                                      \
+        }                                                                                   \
+                                                                                            \
+        /* Rotate the left subtrees away to free the nodes without a stack */               \
+        prefix##_node *p = tree->root;                                                      \
+        for (prefix##_node *q = NULL; p; p = q) {                                           \
+            if (p->subtrees[0]) {                                                           \
+                q = p->subtrees[0];                                                         \
+                p->subtrees[0] = q->subtrees[1];                                            \
+                q->subtrees[1] = p;                                                         \
+            }                                                                               \
+            else {                                                                          \
+                q = p->subtrees[1];                                                         \
+                if (tree->freedata) tree->freedata(p->data);                                \
+                prefix##__free_node(tree, p);                                               \
+            }                                                                               \
+        }                                                                                   \
+                                                                                            \
+        tree->root = NULL;                                                                  \
+        tree->nitems = 0;                                                                   \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    void *prefix##_find(const prefix *restrict tree, key_type key)                          \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+                                                                                            \
+        const prefix##_node *tmpnode = tree->root;                                          \
+        while (tmpnode) {                                                                   \
+            int c = cmp(key, tmpnode->key);                                                 \
+            if (!c) {                                                                       \
+                return tmpnode->data;                                                       \
+            }                                                                               \
+            tmpnode = tmpnode->subtrees[c > 0];                                             \
+        }                                                                                   \
+        return NULL;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_insert(prefix *restrict tree, key_type key, void *data)                    \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+        Lor_assert(data, __func__, "argument data must be non-NULL");                       \
+                                                                                            \
+        prefix##_node **stack[LOR_AVL_GEN_MAX_HEIGHT];                                      \
+        size_t height = 0;                                                                  \
+                                                                                            \
+        prefix##_node **link = &tree->root;                                                 \
+        while (*link) {                                                                     \
+            prefix##_node *node = *link;                                                    \
+            int c = cmp(key, node->key);                                                    \
+            if (!c) {                                                                       \
+                LOR_AVL_GEN_SAME_KEY_(tree, node, data);                                    \
+            }                                                                               \
+            if (height == LOR_AVL_GEN_MAX_HEIGHT) {                                         \
+                return LOR_MAX_HEIGHT_ERR;                                                  \
+            }                                                                               \
+            stack[height++] = link;                                                         \
+            link = &node->subtrees[c > 0];                                                  \
+        }                                                                                   \
+                                                                                            \
+        prefix##_node *newnode = prefix##__alloc_node(tree);                                \
+        if (!newnode) {                                                                     \
+            return LOR_ALLOC_FAIL_ERR;                                                      \
+        }                                                                                   \
+        *newnode = (prefix##_node){ .height = 1, .key = key, .data = data };                \
+        *link = newnode;                                                                    \
+        ++tree->nitems;                                                                     \
+                                                                                            \
+        prefix##__rebalance_path(stack, height);                                            \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_delete(prefix *restrict tree, key_type key, void **data)                   \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+                                                                                            \
+        if (!tree->root) {                                                                  \
+            *data = NULL;                                                                   \
+            return LOR_EMPTY_TREE_ERR;                                                      \
+        }                                                                                   \
+                                                                                            \
+        prefix##_node **stack[LOR_AVL_GEN_MAX_HEIGHT];                                      \
+        size_t height = 0;                                                                  \
+                                                                                            \
+        prefix##_node **link = &tree->root;                                                 \
+        int c;                                                                              \
+        while (*link && (c = cmp(key, (*link)->key))) {                                    \
+            stack[height++] = link;                                                         \
+            link = &(*link)->subtrees[c > 0];                                               \
+        }                                                                                   \
+        if (!*link) {                                                                       \
+            *data = NULL;                                                                   \
+            return LOR_DELETE_NON_EXISTENT_KEY_ERR;                                         \
+        }                                                                                   \
+                                                                                            \
+        prefix##_node *node = *link;                                                        \
+        *data = node->data;                                                                 \
+        if (node->subtrees[0] && node->subtrees[1]) {                                       \
+            /* Move the successor in place of the node, and remove it instead */           \
+            stack[height++] = link;                                                         \
+            link = &node->subtrees[1];                                                      \
+            while ((*link)->subtrees[0]) {                                                  \
+                stack[height++] = link;                                                     \
+                link = &(*link)->subtrees[0];                                               \
+            }                                                                               \
+            prefix##_node *successor = *link;                                               \
+            node->key = successor->key;                                                     \
+            node->data = successor->data;                                                   \
+            node = successor;                                                               \
+        }                                                                                   \
+        *link = (node->subtrees[0]) ? node->subtrees[0] : node->subtrees[1];                \
+        prefix##__free_node(tree, node);                                                    \
+        --tree->nitems;                                                                     \
+                                                                                            \
+        prefix##__rebalance_path(stack, height);                                            \
+        return LOR_SUCCESS;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    int prefix##_traverse_lr(const prefix *restrict tree, Lor_AVL_map mapfn)                \
+    {                                                                                       \
+        Lor_assert(tree, __func__, "argument tree must be non-NULL");                       \
+        Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");                     \
+                                                                                            \
+        if (!tree->root) { /* empty tree */                                                 \
+            return LOR_EMPTY_TREE_ERR;                                                      \
+        }                                                                                   \
+                                                                                            \
+        const prefix##_node *stack[LOR_AVL_GEN_MAX_HEIGHT];                                 \
+        size_t top = 0;                                                                     \
+        const prefix##_node *tmpnode = tree->root;                                          \
+        while (tmpnode || top) {                                                            \
+            while (tmpnode) {                                                               \
+                if (top == LOR_AVL_GEN_MAX_HEIGHT) {                                        \
+                    return LOR_MAX_HEIGHT_ERR;                                              \
+                }                                                                           \
+                stack[top++] = tmpnode;                                                     \
+                tmpnode = tmpnode->subtrees[0];                                             \
+            }                                                                               \
+            tmpnode = stack[--top];                                                         \
+            mapfn(tmpnode->data); /* map over data */                                       \
+            tmpnode = tmpnode->subtrees[1];                                                 \
+        }                                                                                   \
+        return LOR_SUCCESS;                                                                 \
+    }
+
+#define LOR_AVL_DEFINE(prefix, key_type, cmp)                                               \
+    LOR_AVL_DECLARE(prefix, key_type);                                                      \
+    LOR_AVL_IMPL(prefix, key_type, cmp)
+
+/* Insertion of a key already on the tree, see Lor_AVL_insert */
+#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
+#define LOR_AVL_GEN_SAME_KEY_(tree, node, newdata) return LOR_DISTINCT_KEY_ERR
+#else
+#define LOR_AVL_GEN_SAME_KEY_(tree, node, newdata)                                          \
+    do {                                                                                    \
+        void *tmpdata = (node)->data;                                                       \
+        (node)->data = (newdata);                                                           \
+        if ((tree)->freedata) (tree)->freedata(tmpdata);                                    \
+        return LOR_SUCCESS;                                                                 \
+    } while (0)
+#endif
+
+LOR_AVL_DECLARE(Lor_AVLu64, uint64_t);
+LOR_AVL_DECLARE(Lor_AVLi64, int64_t);
+LOR_AVL_DECLARE(Lor_AVLf64, double);
+
+#endif
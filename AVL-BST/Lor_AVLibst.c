@@ -0,0 +1,228 @@
+/* C file:
+ *         AVLibst.c
+ * Implementation for intrusive AVL binary search tree
+ */
+#include "Lor_AVLibstdef.h"
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+static int32_t treei_height(const Lor_AVL_link *);
+static void treei_update_height(Lor_AVL_link *);
+static void treei_rotate(Lor_AVL_link **, int);
+static void treei_rebalance(Lor_AVL_link **);
+
+/* Rebalance the positions stack[0..height), up to the first subtree whose
+ * height did not change */
+static void __AVLi_rebalance_path(Lor_AVL_link ***stack, size_t height)
+{
+    while (height) {
+        Lor_AVL_link **pos = stack[--height];
+        int32_t oldheight = (*pos)->height;
+        treei_rebalance(pos);
+        if ((*pos)->height == oldheight) {
+            break;
+        }
+    }
+}
+
+Lor_AVLi_bst *Lor_AVLi_create(void)
+{
+    Lor_AVLi_bst *tree = malloc(sizeof *tree);
+    if (!tree) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    return tree;
+}
+
+int Lor_AVLi_init(Lor_AVLi_bst *restrict tree, Lor_AVLi_compare compare)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+
+    tree->root = NULL;
+    tree->compare = compare;
+    tree->nitems = 0;
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLi_destroy(Lor_AVLi_bst **restrict tree)
+{
+    if (!(*tree)) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    if ((*tree)->root) {
+        return LOR_DESTROY_ROOT_NON_NULL;
+    }
+    free(*tree);
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLi_clear(Lor_AVLi_bst *restrict tree, Lor_AVLi_map release)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->root) {
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    /* Rotate the left subtrees away so that the links can be released in
+     * order without a stack */
+    if (release) {
+        Lor_AVL_link *p = tree->root;
+        for (Lor_AVL_link *q = NULL; p; p = q) {
+            if (p->subtrees[0]) {
+                q = p->subtrees[0];
+                p->subtrees[0] = q->subtrees[1];
+                q->subtrees[1] = p;
+            }
+            else {
+                q = p->subtrees[1];
+                release(p);
+            }
+        }
+    }
+
+    tree->root = NULL;
+    tree->nitems = 0;
+    return LOR_SUCCESS;
+}
+
+Lor_AVL_link *Lor_AVLi_find(const Lor_AVLi_bst *restrict tree, const Lor_AVL_link *probe)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(probe, __func__, "argument probe must be non-NULL");
+
+    Lor_AVL_link *tmplink = tree->root;
+    while (tmplink) {
+        int32_t cmp = tree->compare(probe, tmplink);
+        if (!cmp) {
+            return tmplink;
+        }
+        tmplink = tmplink->subtrees[cmp > 0];
+    }
+    return NULL;
+}
+
+int Lor_AVLi_insert(Lor_AVLi_bst *restrict tree, Lor_AVL_link *link)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(link, __func__, "argument link must be non-NULL");
+
+    Lor_AVL_link **stack[LOR_AVLI_BST_MAX_HEIGHT];  /* positions on the path, for rebalancing */
+    size_t height = 0;
+
+    Lor_AVL_link **pos = &tree->root;
+    while (*pos) {
+        int32_t cmp = tree->compare(link, *pos);
+        if (!cmp) {
+            return LOR_DISTINCT_KEY_ERR;
+        }
+        if (height == LOR_AVLI_BST_MAX_HEIGHT) {
+            return LOR_MAX_HEIGHT_ERR;
+        }
+        stack[height++] = pos;
+        pos = &(*pos)->subtrees[cmp > 0];
+    }
+
+    *link = (Lor_AVL_link){ .height = 1 };
+    *pos = link;
+    ++tree->nitems;
+
+    __AVLi_rebalance_path(stack, height);
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLi_delete(Lor_AVLi_bst *restrict tree, const Lor_AVL_link *probe, Lor_AVL_link **link)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(probe, __func__, "argument probe must be non-NULL");
+
+    if (!tree->root) {
+        *link = NULL;
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    Lor_AVL_link **stack[LOR_AVLI_BST_MAX_HEIGHT];  /* positions on the path, for rebalancing */
+    size_t height = 0;
+
+    Lor_AVL_link **pos = &tree->root;
+    int32_t cmp;
+    while (*pos && (cmp = tree->compare(probe, *pos))) {
+        stack[height++] = pos;
+        pos = &(*pos)->subtrees[cmp > 0];
+    }
+    if (!*pos) {
+        *link = NULL;
+        return LOR_DELETE_NON_EXISTENT_KEY_ERR;
+    }
+
+    Lor_AVL_link *target = *pos;
+    if (target->subtrees[0] && target->subtrees[1]) {
+        /* The records cannot be copied, so the successor is unlinked and
+         * relinked in place of the target */
+        Lor_AVL_link **targetpos = pos;
+        size_t targetdepth = height;
+        stack[height++] = pos;
+        pos = &target->subtrees[1];
+        while ((*pos)->subtrees[0]) {
+            stack[height++] = pos;
+            pos = &(*pos)->subtrees[0];
+        }
+        Lor_AVL_link *successor = *pos;
+        *pos = successor->subtrees[1];
+
+        *successor = *target;
+        *targetpos = successor;
+        if (height > targetdepth + 1) {
+            stack[targetdepth + 1] = &successor->subtrees[1];
+        }
+    }
+    else {
+        *pos = (target->subtrees[0]) ? target->subtrees[0] : target->subtrees[1];
+    }
+    *target = (Lor_AVL_link){ .height = 0 };
+    *link = target;
+    --tree->nitems;
+
+    __AVLi_rebalance_path(stack, height);
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLi_traverse_lr(const Lor_AVLi_bst *restrict tree, Lor_AVLi_map mapfn)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    if (!tree->root) { /* empty tree */
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    Lor_AVL_link *stack[LOR_AVLI_BST_MAX_HEIGHT];
+    size_t top = 0;
+    Lor_AVL_link *tmplink = tree->root;
+    while (tmplink || top) {
+        while (tmplink) {
+            if (top == LOR_AVLI_BST_MAX_HEIGHT) {
+                return LOR_MAX_HEIGHT_ERR;
+            }
+            stack[top++] = tmplink;
+            tmplink = tmplink->subtrees[0];
+        }
+        tmplink = stack[--top];
+        Lor_AVL_link *right = tmplink->subtrees[1];
+        mapfn(tmplink); /* map over links */
+        tmplink = right;
+    }
+    return LOR_SUCCESS;
+}
+
+/* End Of File */
@@ -0,0 +1,100 @@
+/* C Header file:
+ *               Lor_AVLibst.h
+ *
+ * Interface for intrusive AVL binary search tree.
+ *
+ * The nodes of an intrusive tree are Lor_AVL_link structs embedded in the
+ * records of the user, so the tree never allocates and the key of a record
+ * can share a cache line with its links.  The records are reached from
+ * their links with LOR_CONTAINER_OF, and compared through them:
+ *
+ *     struct conn { uint64_t id; Lor_AVL_link link; ... };
+ *
+ *     int32_t compare_conn(const Lor_AVL_link *a, const Lor_AVL_link *b)
+ *     {
+ *         uint64_t ida = LOR_CONTAINER_OF(a, struct conn, link)->id;
+ *         uint64_t idb = LOR_CONTAINER_OF(b, struct conn, link)->id;
+ *         return (ida > idb) - (ida < idb);
+ *     }
+ *
+ * Lookups take a probe: a link embedded in a record holding the key searched
+ * for, that is never inserted.  A record is on at most one tree per link.
+ *
+ * Public functions:
+ *
+ * Lor_AVLi_bst *Lor_AVLi_create(void);
+ *     This functions returns a new Lor_AVLi_bst on the heap.
+ *
+ * int Lor_AVLi_init(Lor_AVLi_bst *restrict tree, Lor_AVLi_compare compare);
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_COMPARE_FN_NOT_PROVIDED_ERR if compare is NULL
+ *
+ * int Lor_AVLi_destroy(Lor_AVLi_bst **restrict tree);
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_FREE_NULLPTR_WARN if *tree is a NULL pointer
+ *         - LOR_DESTROY_ROOT_NON_NULL if the tree is not empty
+ *
+ * int Lor_AVLi_clear(Lor_AVLi_bst *restrict tree, Lor_AVLi_map release);
+ *     This function empties the tree, calling release (if non-NULL) once
+ *     on every link, after which the tree does not touch it.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_EMPTY_TREE_ERR if the tree is already empty
+ *
+ * Lor_AVL_link *Lor_AVLi_find(const Lor_AVLi_bst *restrict tree,
+ *                             const Lor_AVL_link *probe);
+ *     Returns:
+ *         - the link on tree comparing equal to probe
+ *         - NULL if there is none
+ *
+ * int Lor_AVLi_insert(Lor_AVLi_bst *restrict tree, Lor_AVL_link *link);
+ *     This function links a record in the tree, without allocating.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_DISTINCT_KEY_ERR if a link comparing equal is already on
+ *           tree (the tree does not own the records, so it does not
+ *           replace them)
+ *         - LOR_MAX_HEIGHT_ERR
+ *
+ * int Lor_AVLi_delete(Lor_AVLi_bst *restrict tree, const Lor_AVL_link *probe,
+ *                     Lor_AVL_link **link);
+ *     This function unlinks the record comparing equal to probe, and
+ *     stores it in *link (NULL if it fails).
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_EMPTY_TREE_ERR
+ *         - LOR_DELETE_NON_EXISTENT_KEY_ERR
+ *
+ * int Lor_AVLi_traverse_lr(const Lor_AVLi_bst *restrict tree, Lor_AVLi_map mapfn);
+ *     Same as Lor_AVL_traverse_lr, mapping over the links.
+ **************************************************************************/
+#ifndef LOR_AVL_IBST_H
+#define LOR_AVL_IBST_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Address of the struct of type 'type' whose member 'member' is at 'ptr' */
+#define LOR_CONTAINER_OF(ptr, type, member) ((type *) ((char *) (ptr) - offsetof(type, member)))
+
+typedef struct Lor_AVL_link {
+    struct Lor_AVL_link *subtrees[2];  /* [0] for left, [1] for right subtree */
+    int32_t height;                    /* 1 for a link without subtrees */
+} Lor_AVL_link;
+
+typedef struct _Lor_AVLi_bst Lor_AVLi_bst;
+typedef int32_t (*Lor_AVLi_compare)(const Lor_AVL_link *, const Lor_AVL_link *);
+typedef void (*Lor_AVLi_map)(Lor_AVL_link *);
+
+extern Lor_AVLi_bst *Lor_AVLi_create(void);
+extern int Lor_AVLi_init(Lor_AVLi_bst *restrict tree, Lor_AVLi_compare compare);
+extern int Lor_AVLi_destroy(Lor_AVLi_bst **restrict tree);
+extern int Lor_AVLi_clear(Lor_AVLi_bst *restrict tree, Lor_AVLi_map release);
+extern Lor_AVL_link *Lor_AVLi_find(const Lor_AVLi_bst *restrict tree, const Lor_AVL_link *probe);
+extern int Lor_AVLi_insert(Lor_AVLi_bst *restrict tree, Lor_AVL_link *link);
+extern int Lor_AVLi_delete(Lor_AVLi_bst *restrict tree, const Lor_AVL_link *probe, Lor_AVL_link **link);
+extern int Lor_AVLi_traverse_lr(const Lor_AVLi_bst *restrict tree, Lor_AVLi_map mapfn);
+
+#endif
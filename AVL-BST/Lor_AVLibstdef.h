@@ -0,0 +1,77 @@
+/* C Header file:
+ *               Lor_AVLibstdef.h
+ * Type definitions for intrusive AVL binary search tree
+ * NOTE: This header file is for exclusive use of the implementation
+ * and should not be exposed.
+ */
+#ifndef LOR_AVL_IBST_DEF_H
+#define LOR_AVL_IBST_DEF_H 1
+
+#include "Lor_AVLibst.h"
+#include <Lor_BSTs.h>
+#include <Lor_assert.h>
+
+#ifndef LOR_AVLI_BST_MAX_HEIGHT
+#define LOR_AVLI_BST_MAX_HEIGHT 48
+#endif
+
+struct _Lor_AVLi_bst {
+    size_t nitems;          /* number of items */
+    Lor_AVL_link *root;
+    Lor_AVLi_compare compare;
+};
+
+/*========== Inline functions ===========*/
+
+static inline int32_t treei_height(const Lor_AVL_link *link)
+{
+    return (link) ? link->height : 0;
+}
+
+static inline void treei_update_height(Lor_AVL_link *link)
+{
+    int32_t lh = treei_height(link->subtrees[0]);
+    int32_t rh = treei_height(link->subtrees[1]);
+    link->height = 1 + ((lh > rh) ? lh : rh);
+}
+
+/* Rotate the subtree at *pos; dir 0 rotates left, 1 rotates right */
+static inline void treei_rotate(Lor_AVL_link **pos, int dir)
+{
+    Lor_AVL_link *link = *pos;
+    Lor_AVL_link *up = link->subtrees[!dir];
+
+    link->subtrees[!dir] = up->subtrees[dir];
+    up->subtrees[dir] = link;
+    treei_update_height(link);
+    treei_update_height(up);
+    *pos = up;
+}
+
+/* Restore the balance of the subtree at *pos after one of its subtrees
+ * changed height by one */
+static inline void treei_rebalance(Lor_AVL_link **pos)
+{
+    Lor_AVL_link *link = *pos;
+    int32_t balance = treei_height(link->subtrees[0]) - treei_height(link->subtrees[1]);
+
+    if (balance == 2) {
+        Lor_AVL_link *left = link->subtrees[0];
+        if (treei_height(left->subtrees[0]) < treei_height(left->subtrees[1])) {
+            treei_rotate(&link->subtrees[0], 0);  /* Left-right unbalanced */
+        }
+        treei_rotate(pos, 1);
+    }
+    else if (balance == -2) {
+        Lor_AVL_link *right = link->subtrees[1];
+        if (treei_height(right->subtrees[1]) < treei_height(right->subtrees[0])) {
+            treei_rotate(&link->subtrees[1], 1);  /* Right-left unbalanced */
+        }
+        treei_rotate(pos, 0);
+    }
+    else {
+        treei_update_height(link);
+    }
+}
+
+#endif
@@ -0,0 +1,421 @@
+/* C file:
+ *         AVLnbst.c
+ * Implementation for node-oriented AVL binary search tree
+ */
+#include "Lor_AVLnbstdef.h"
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+static int32_t treen_height(const Lor_AVLn_bst_node *);
+static void treen_update_height(Lor_AVLn_bst_node *);
+static Lor_AVLn_bst_node *treen_alloc_node(Lor_AVLn_bst *restrict);
+static void treen_free_node(Lor_AVLn_bst *restrict, Lor_AVLn_bst_node *);
+static void treen_left_rotate(Lor_AVLn_bst_node **);
+static void treen_right_rotate(Lor_AVLn_bst_node **);
+static void treen_rebalance(Lor_AVLn_bst_node **);
+
+/**********************************************************
+ * Adapters that bind the tree allocator interface  to  the
+ * slab of a Lor_mem_pool.
+ **********************************************************/
+static void *__AVLn_pool_alloc(void *ctx, size_t nbytes)
+{
+    return Lor_mem_pool_slab_alloc((Lor_mem_pool *) ctx, nbytes);
+}
+
+static void __AVLn_pool_free_node(void *ctx, void *ptr, size_t nbytes)
+{
+    Lor_mem_pool_slab_free((Lor_mem_pool *) ctx, ptr, nbytes);
+}
+
+/**********************************************************
+ * Common part of the Lor_AVLn_init* functions, called once
+ * the node allocator of the tree has been set.
+ **********************************************************/
+static int __AVLn_init_tree(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+                            Lor_AVL_free_data freedata)
+{
+    tree->nodealign = 0;
+    tree->root = NULL;
+    tree->compare = compare;
+    tree->nitems = 0;
+    tree->freedata = freedata;
+
+    return LOR_SUCCESS;
+}
+
+/* Compare 'key' with the key of 'node', without calling compare on a hit
+ * by pointer */
+static inline int32_t __AVLn_compare(const Lor_AVLn_bst *restrict tree, const void *key,
+                                     const Lor_AVLn_bst_node *node)
+{
+    return (key == node->key) ? 0 : tree->compare(key, node->key);
+}
+
+Lor_AVLn_bst *Lor_AVLn_create(void)
+{
+    Lor_AVLn_bst *tree = malloc(sizeof *tree);
+    if (!tree) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    return tree;
+}
+
+int Lor_AVLn_init(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare, Lor_AVL_alloc alloc,
+               Lor_AVL_free_node freenode, Lor_AVL_free_data freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+    if (!alloc) {
+        return LOR_ALLOC_FN_NOT_PROVIDED_ERR;
+    }
+
+    tree->alloc = alloc;
+    tree->freenode = (freenode) ? freenode : free;
+    tree->allocator = (Lor_AVL_allocator){ .alloc = NULL };
+    tree->pool = NULL;
+
+    return __AVLn_init_tree(tree, compare, freedata);
+}
+
+int Lor_AVLn_init_with_allocator(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+                              const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+    if (!allocator || !allocator->alloc) {
+        return LOR_ALLOC_FN_NOT_PROVIDED_ERR;
+    }
+
+    tree->alloc = NULL;
+    tree->freenode = NULL;
+    tree->allocator = *allocator;
+    tree->pool = NULL;
+
+    return __AVLn_init_tree(tree, compare, freedata);
+}
+
+int Lor_AVLn_init_with_pool(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+                         Lor_mem_pool *pool, Lor_AVL_free_data freedata)
+{
+    Lor_assert(pool, __func__, "argument pool must be non-NULL");
+
+    const Lor_AVL_allocator allocator = {
+        .alloc = __AVLn_pool_alloc,
+        .freenode = __AVLn_pool_free_node,
+        .ctx = pool,
+    };
+    int ret = Lor_AVLn_init_with_allocator(tree, compare, &allocator, freedata);
+    if (ret == LOR_SUCCESS) {
+        tree->pool = pool;
+    }
+    return ret;
+}
+
+int Lor_AVLn_destroy(Lor_AVLn_bst **restrict tree)
+{
+    if (!(*tree)) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    if ((*tree)->root) {
+        return LOR_DESTROY_ROOT_NON_NULL;
+    }
+    free(*tree);
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLn_clear(Lor_AVLn_bst *restrict tree)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->root) {
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    /* Rotate the left subtrees away so that the nodes can be freed in
+     * order without a stack */
+    Lor_AVLn_bst_node *p = tree->root;
+    for (Lor_AVLn_bst_node *q = NULL; p; p = q) {
+        if (p->subtrees[0]) {
+            q = p->subtrees[0];
+            p->subtrees[0] = q->subtrees[1];
+            q->subtrees[1] = p;
+        }
+        else {
+            q = p->subtrees[1];
+            if (tree->freedata) tree->freedata(p->data);
+            treen_free_node(tree, p);
+        }
+    }
+
+    tree->root = NULL;
+    tree->nitems = 0;
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLn_discard(Lor_AVLn_bst *restrict tree, bool freedata)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->pool) {
+        return LOR_NOT_POOL_BACKED_ERR;
+    }
+
+    if (freedata && tree->freedata && tree->root) {
+        Lor_AVLn_traverse_lr(tree, tree->freedata);
+    }
+    Lor_mem_pool_discard(tree->pool, false);
+
+    *tree = (Lor_AVLn_bst){ .root = NULL, .nitems = 0 };
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLn_set_node_alignment(Lor_AVLn_bst *restrict tree, size_t align)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    if (!tree->pool) {
+        return LOR_NOT_POOL_BACKED_ERR;
+    }
+    if (align && !LOR_MEM_POOL_VALID_ALIGNMENT(align)) {
+        return LOR_INVALID_ALIGNMENT_ERR;
+    }
+
+    tree->nodealign = align;
+    return LOR_SUCCESS;
+}
+
+Lor_AVLn_bst_node *Lor_AVLn_find(Lor_AVLn_bst *restrict tree, const void *key)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    Lor_AVLn_bst_node *tmpnode = tree->root;
+    while (tmpnode) {
+        int32_t cmp = __AVLn_compare(tree, key, tmpnode);
+        if (!cmp) {
+            return tmpnode;
+        }
+        tmpnode = tmpnode->subtrees[cmp > 0];
+    }
+    return NULL;
+}
+
+Lor_AVLn_bst_node *Lor_AVLn_interval_find(Lor_AVLn_bst *restrict tree, const void *a, const void *b)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(a && b, __func__, "arguments a and b must be non-NULL");
+
+    Lor_AVLn_bst_node *list = NULL;
+    Lor_AVLn_bst_node **tail = &list;
+    Lor_AVLn_bst_node *stack[LOR_AVLN_BST_MAX_HEIGHT];
+    size_t top = 0;
+
+    /* In order walk of the nodes not smaller than a */
+    Lor_AVLn_bst_node *tmpnode = tree->root;
+    while (tmpnode || top) {
+        while (tmpnode) {
+            if (tree->compare(tmpnode->key, a) < 0) {
+                tmpnode = tmpnode->subtrees[1];
+            }
+            else {
+                stack[top++] = tmpnode;
+                tmpnode = tmpnode->subtrees[0];
+            }
+        }
+        if (!top) {
+            break;
+        }
+        tmpnode = stack[--top];
+        if (tree->compare(tmpnode->key, b) >= 0) {
+            break;
+        }
+
+        Lor_AVLn_bst_node *newnode = treen_alloc_node(tree);
+        if (!newnode) {
+            if (list) {
+                Lor_AVLn_clear_node_list(tree, list);
+            }
+            return NULL;
+        }
+        *newnode = (Lor_AVLn_bst_node){ .key = tmpnode->key, .data = tmpnode->data };
+        *tail = newnode;
+        tail = &newnode->subtrees[1];
+
+        tmpnode = tmpnode->subtrees[1];
+    }
+    return list;
+}
+
+void *Lor_AVLn_get_data_from_node(Lor_AVLn_bst_node *node)
+{
+    Lor_assert(node, __func__, "argument node must be non-NULL");
+
+    return node->data;
+}
+
+void Lor_AVLn_process_node_list(Lor_AVLn_bst_node *nodelst, Lor_AVL_map mapfn)
+{
+    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    for (Lor_AVLn_bst_node *p = nodelst; p; p = p->subtrees[1]) {
+        mapfn(p->data);
+    }
+}
+
+void Lor_AVLn_clear_node_list(Lor_AVLn_bst *restrict tree, Lor_AVLn_bst_node *nodelst)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(nodelst, __func__, "argument nodelst must be non-NULL");
+
+    Lor_AVLn_bst_node *q = NULL;
+    for (Lor_AVLn_bst_node *p = nodelst; p; p = q) {
+        q = p->subtrees[1];
+        treen_free_node(tree, p);
+    }
+}
+
+int Lor_AVLn_insert(Lor_AVLn_bst *restrict tree, void *key, void *data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key && data, __func__, "arguments key and data must be non-NULL");
+
+    Lor_AVLn_bst_node **stack[LOR_AVLN_BST_MAX_HEIGHT];  /* links on the path, for rebalancing */
+    size_t height = 0;
+
+    Lor_AVLn_bst_node **link = &tree->root;
+    while (*link) {
+        Lor_AVLn_bst_node *node = *link;
+        int32_t cmp = __AVLn_compare(tree, key, node);
+        if (!cmp) { /* permit only distinct keys */
+#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
+            return LOR_DISTINCT_KEY_ERR;
+#else  /* Updates the data if try same key insertion */
+            void *tmpdata = node->data;
+            node->data = data;
+            if (tree->freedata) tree->freedata(tmpdata);
+            return LOR_SUCCESS;
+#endif
+        }
+        if (height == LOR_AVLN_BST_MAX_HEIGHT) {
+            return LOR_MAX_HEIGHT_ERR;
+        }
+        stack[height++] = link;
+        link = &node->subtrees[cmp > 0];
+    }
+
+    Lor_AVLn_bst_node *newnode = treen_alloc_node(tree);
+    if (!newnode) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    *newnode = (Lor_AVLn_bst_node){ .height = 1, .key = key, .data = data };
+    *link = newnode;
+    ++tree->nitems;
+
+    /* Rebalance, up to the first subtree whose height did not change */
+    while (height) {
+        link = stack[--height];
+        int32_t oldheight = (*link)->height;
+        treen_rebalance(link);
+        if ((*link)->height == oldheight) {
+            break;
+        }
+    }
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLn_delete(Lor_AVLn_bst *restrict tree, void *key, void **data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    if (!tree->root) {
+        *data = NULL;
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    Lor_AVLn_bst_node **stack[LOR_AVLN_BST_MAX_HEIGHT];  /* links on the path, for rebalancing */
+    size_t height = 0;
+
+    Lor_AVLn_bst_node **link = &tree->root;
+    int32_t cmp;
+    while (*link && (cmp = __AVLn_compare(tree, key, *link))) {
+        stack[height++] = link;
+        link = &(*link)->subtrees[cmp > 0];
+    }
+    if (!*link) {
+        *data = NULL;
+        return LOR_DELETE_NON_EXISTENT_KEY_ERR;
+    }
+
+    Lor_AVLn_bst_node *node = *link;
+    *data = node->data;
+    if (node->subtrees[0] && node->subtrees[1]) {
+        /* Move the successor in place of the node, and remove it instead */
+        stack[height++] = link;
+        link = &node->subtrees[1];
+        while ((*link)->subtrees[0]) {
+            stack[height++] = link;
+            link = &(*link)->subtrees[0];
+        }
+        Lor_AVLn_bst_node *successor = *link;
+        node->key = successor->key;
+        node->data = successor->data;
+        node = successor;
+    }
+    *link = (node->subtrees[0]) ? node->subtrees[0] : node->subtrees[1];
+    treen_free_node(tree, node);
+    --tree->nitems;
+
+    /* Rebalance, up to the first subtree whose height did not change */
+    while (height) {
+        link = stack[--height];
+        int32_t oldheight = (*link)->height;
+        treen_rebalance(link);
+        if ((*link)->height == oldheight) {
+            break;
+        }
+    }
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLn_traverse_lr(Lor_AVLn_bst *restrict tree, Lor_AVL_map mapfn)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    if (!tree->root) { /* empty tree */
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    Lor_AVLn_bst_node *stack[LOR_AVLN_BST_MAX_HEIGHT];
+    size_t top = 0;
+    Lor_AVLn_bst_node *tmpnode = tree->root;
+    while (tmpnode || top) {
+        while (tmpnode) {
+            if (top == LOR_AVLN_BST_MAX_HEIGHT) {
+                return LOR_MAX_HEIGHT_ERR;
+            }
+            stack[top++] = tmpnode;
+            tmpnode = tmpnode->subtrees[0];
+        }
+        tmpnode = stack[--top];
+        mapfn(tmpnode->data); /* map over data */
+        tmpnode = tmpnode->subtrees[1];
+    }
+    return LOR_SUCCESS;
+}
+
+/* End Of File */
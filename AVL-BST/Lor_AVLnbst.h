@@ -0,0 +1,94 @@
+/* C Header file:
+ *               Lor_AVLnbst.h
+ *
+ * Interface for node-oriented AVL binary search tree.
+ *
+ * Unlike Lor_AVLbst.h, which implements a 'leaf tree', every node of this
+ * tree holds a key and its data: n items take n nodes instead of 2n-1,
+ * an insertion allocates a single node, and a lookup stops at the node of
+ * its key instead of descending to a leaf.
+ *
+ * The public functions mirror the ones of Lor_AVLbst.h, with the Lor_AVLn_
+ * prefix, and have the same contract, including the LOR_AVL_ONLY_DISTINCT_KEYS
+ * mode and the responsabilities of the user on keys and data.  The only
+ * differences are:
+ *
+ * - An empty tree has no node: Lor_AVLn_clear leaves the tree empty and
+ *   still usable, Lor_AVLn_destroy accepts any empty tree, and
+ *   Lor_AVLn_discard discards the pool of an empty tree too, where
+ *   Lor_AVL_discard returns LOR_FREE_NULLPTR_WARN for a tree without root.
+ * - Lor_AVLn_get_data_from_node returns the data of any node.
+ * - The nodes of Lor_AVLn_interval_find are copies linked through their
+ *   right subtree, in increasing order of keys.
+ *
+ * Lor_AVLn_bst *Lor_AVLn_create(void);
+ * int Lor_AVLn_init(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare, Lor_AVL_alloc alloc,
+ *              Lor_AVL_free_node freenode, Lor_AVL_free_data freedata);
+ * int Lor_AVLn_init_with_allocator(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+ *              const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata);
+ * int Lor_AVLn_init_with_pool(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+ *              Lor_mem_pool *pool, Lor_AVL_free_data freedata);
+ *     Same as their Lor_AVL_ counterparts, except that no node is allocated
+ *     by the initialization.
+ *
+ * int Lor_AVLn_destroy(Lor_AVLn_bst **restrict tree);
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_FREE_NULLPTR_WARN if *tree is a NULL pointer
+ *         - LOR_DESTROY_ROOT_NON_NULL if the tree is not empty
+ *
+ * int Lor_AVLn_clear(Lor_AVLn_bst *restrict tree);
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_EMPTY_TREE_ERR if the tree is already empty
+ *
+ * int Lor_AVLn_discard(Lor_AVLn_bst *restrict tree, bool freedata);
+ *     Empties a tree bound to a pool by discarding the pool; the tree
+ *     must be initialized again before being used.  An empty tree has its
+ *     pool discarded as well.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull, the tree being empty or not
+ *         - LOR_NOT_POOL_BACKED_ERR if the tree is not bound to a pool
+ *
+ * int Lor_AVLn_set_node_alignment(Lor_AVLn_bst *restrict tree, size_t align);
+ * Lor_AVLn_bst_node *Lor_AVLn_find(Lor_AVLn_bst *restrict tree, const void *key);
+ * Lor_AVLn_bst_node *Lor_AVLn_interval_find(Lor_AVLn_bst *restrict tree, const void *a, const void *b);
+ * void *Lor_AVLn_get_data_from_node(Lor_AVLn_bst_node *node);
+ * void Lor_AVLn_process_node_list(Lor_AVLn_bst_node *nodelst, Lor_AVL_map mapfn);
+ * void Lor_AVLn_clear_node_list(Lor_AVLn_bst *restrict tree, Lor_AVLn_bst_node *nodelst);
+ * int Lor_AVLn_insert(Lor_AVLn_bst *restrict tree, void *key, void *data);
+ *     Also returns LOR_ALLOC_FAIL_ERR if the node could not be allocated.
+ * int Lor_AVLn_delete(Lor_AVLn_bst *restrict tree, void *key, void **data);
+ * int Lor_AVLn_traverse_lr(Lor_AVLn_bst *restrict tree, Lor_AVL_map mapfn);
+ *     Same as their Lor_AVL_ counterparts.
+ **************************************************************************/
+#ifndef LOR_AVL_NBST_H
+#define LOR_AVL_NBST_H 1
+
+#include <Lor_mem_pool.h>
+#include <Lor_AVLbst.h>
+
+typedef struct _Lor_AVLn_bst_node Lor_AVLn_bst_node;
+typedef struct _Lor_AVLn_bst Lor_AVLn_bst;
+
+extern Lor_AVLn_bst *Lor_AVLn_create(void);
+extern int Lor_AVLn_init(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare, Lor_AVL_alloc alloc,
+                      Lor_AVL_free_node freenode, Lor_AVL_free_data freedata);
+extern int Lor_AVLn_init_with_allocator(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+                                     const Lor_AVL_allocator *allocator, Lor_AVL_free_data freedata);
+extern int Lor_AVLn_init_with_pool(Lor_AVLn_bst *restrict tree, Lor_AVL_compare compare,
+                                Lor_mem_pool *pool, Lor_AVL_free_data freedata);
+extern int Lor_AVLn_destroy(Lor_AVLn_bst **restrict tree);
+extern int Lor_AVLn_clear(Lor_AVLn_bst *restrict tree);
+extern int Lor_AVLn_discard(Lor_AVLn_bst *restrict tree, bool freedata);
+extern int Lor_AVLn_set_node_alignment(Lor_AVLn_bst *restrict tree, size_t align);
+extern Lor_AVLn_bst_node *Lor_AVLn_find(Lor_AVLn_bst *restrict tree, const void *key);
+extern Lor_AVLn_bst_node *Lor_AVLn_interval_find(Lor_AVLn_bst *restrict tree, const void *a, const void *b);
+extern void *Lor_AVLn_get_data_from_node(Lor_AVLn_bst_node *node);
+extern void Lor_AVLn_process_node_list(Lor_AVLn_bst_node *nodelst, Lor_AVL_map mapfn);
+extern void Lor_AVLn_clear_node_list(Lor_AVLn_bst *restrict tree, Lor_AVLn_bst_node *nodelst);
+extern int Lor_AVLn_insert(Lor_AVLn_bst *restrict tree, void *key, void *data);
+extern int Lor_AVLn_delete(Lor_AVLn_bst *restrict tree, void *key, void **data);
+extern int Lor_AVLn_traverse_lr(Lor_AVLn_bst *restrict tree, Lor_AVL_map mapfn);
+
+#endif
@@ -0,0 +1,127 @@
+/* C Header file:
+ *               Lor_AVLnbstdef.h
+ * Type definitions for node-oriented AVL binary search tree
+ * NOTE: This header file is for exclusive use of the implementation
+ * and should not be exposed.
+ */
+#ifndef LOR_AVL_NBST_DEF_H
+#define LOR_AVL_NBST_DEF_H 1
+
+#include "Lor_AVLnbst.h"
+#include <Lor_BSTs.h>
+#include <Lor_assert.h>
+
+/* A tree of height h has at least F(h+2)-1 nodes (F being the Fibonacci
+ * numbers), so 48 levels hold far more items than fit in memory */
+#ifndef LOR_AVLN_BST_MAX_HEIGHT
+#define LOR_AVLN_BST_MAX_HEIGHT 48
+#endif
+
+struct _Lor_AVLn_bst_node {
+    int32_t height;                          /* 1 for a node without subtrees */
+    void *key;
+    void *data;
+    struct _Lor_AVLn_bst_node *subtrees[2];  /* [0] for  left,  [1]  for  right subtree */
+};
+
+struct _Lor_AVLn_bst {
+    size_t nitems;          /* number of items */
+    Lor_AVLn_bst_node *root;
+    Lor_AVL_compare compare;
+    Lor_AVL_alloc alloc;
+    Lor_AVL_free_node freenode;
+    Lor_AVL_free_data freedata;
+    Lor_AVL_allocator allocator;  /* used instead of alloc/freenode if allocator.alloc is set */
+    Lor_mem_pool *pool;           /* non-NULL if the tree is bound to a memory pool */
+    size_t nodealign;             /* alignment of the nodes taken from pool, 0 for the default */
+};
+
+/*========== Inline functions ===========*/
+
+static inline int32_t treen_height(const Lor_AVLn_bst_node *node)
+{
+    return (node) ? node->height : 0;
+}
+
+static inline void treen_update_height(Lor_AVLn_bst_node *node)
+{
+    int32_t lh = treen_height(node->subtrees[0]);
+    int32_t rh = treen_height(node->subtrees[1]);
+    node->height = 1 + ((lh > rh) ? lh : rh);
+}
+
+static inline Lor_AVLn_bst_node *treen_alloc_node(Lor_AVLn_bst *restrict tree)
+{
+    if (tree->nodealign) {
+        return Lor_mem_pool_slab_aligned_alloc(tree->pool, sizeof(Lor_AVLn_bst_node), tree->nodealign);
+    }
+    if (tree->allocator.alloc) {
+        return tree->allocator.alloc(tree->allocator.ctx, sizeof(Lor_AVLn_bst_node));
+    }
+    return tree->alloc(sizeof(Lor_AVLn_bst_node));
+}
+
+static inline void treen_free_node(Lor_AVLn_bst *restrict tree, Lor_AVLn_bst_node *node)
+{
+    if (tree->allocator.alloc) {
+        if (tree->allocator.freenode) {
+            tree->allocator.freenode(tree->allocator.ctx, node, sizeof(Lor_AVLn_bst_node));
+        }
+    }
+    else {
+        tree->freenode(node);
+    }
+}
+
+/* Rotations relink the nodes: 'link' is the pointer to the subtree root */
+static inline void treen_left_rotate(Lor_AVLn_bst_node **link)
+{
+    Lor_AVLn_bst_node *node = *link;
+    Lor_AVLn_bst_node *right = node->subtrees[1];
+
+    node->subtrees[1] = right->subtrees[0];
+    right->subtrees[0] = node;
+    treen_update_height(node);
+    treen_update_height(right);
+    *link = right;
+}
+
+static inline void treen_right_rotate(Lor_AVLn_bst_node **link)
+{
+    Lor_AVLn_bst_node *node = *link;
+    Lor_AVLn_bst_node *left = node->subtrees[0];
+
+    node->subtrees[0] = left->subtrees[1];
+    left->subtrees[1] = node;
+    treen_update_height(node);
+    treen_update_height(left);
+    *link = left;
+}
+
+/* Restore the balance of the subtree at 'link' after one of its subtrees
+ * changed height by one */
+static inline void treen_rebalance(Lor_AVLn_bst_node **link)
+{
+    Lor_AVLn_bst_node *node = *link;
+    int32_t balance = treen_height(node->subtrees[0]) - treen_height(node->subtrees[1]);
+
+    if (balance == 2) {
+        Lor_AVLn_bst_node *left = node->subtrees[0];
+        if (treen_height(left->subtrees[0]) < treen_height(left->subtrees[1])) {
+            treen_left_rotate(&node->subtrees[0]);  /* Left-right unbalanced */
+        }
+        treen_right_rotate(link);
+    }
+    else if (balance == -2) {
+        Lor_AVLn_bst_node *right = node->subtrees[1];
+        if (treen_height(right->subtrees[1]) < treen_height(right->subtrees[0])) {
+            treen_right_rotate(&node->subtrees[1]);  /* Right-left unbalanced */
+        }
+        treen_left_rotate(link);
+    }
+    else {
+        treen_update_height(node);
+    }
+}
+
+#endif
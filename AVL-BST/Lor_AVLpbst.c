@@ -0,0 +1,278 @@
+/* C file:
+ *         AVLpbst.c
+ * Implementation for AVL binary search tree stored in a file pool
+ */
+#include "Lor_AVLpbstdef.h"
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+static void treep_left_rotate(const Lor_AVLp_bst *restrict, Lor_AVLp_node *);
+static void treep_right_rotate(const Lor_AVLp_bst *restrict, Lor_AVLp_node *);
+
+static Lor_mem_pool_off __AVLp_new_leaf(Lor_AVLp_bst *restrict tree, Lor_mem_pool_off key,
+                                        Lor_mem_pool_off data)
+{
+    Lor_mem_pool_off off = Lor_mem_pool_file_alloc(tree->pool, sizeof(Lor_AVLp_node));
+    if (off) {
+        *AVLP_NODE(tree, off) = (Lor_AVLp_node){ .height = 0,
+                                                 .key = key,
+                                                 .subtrees = { data, 0 },
+                                           };
+    }
+    return off;
+}
+
+Lor_AVLp_bst *Lor_AVLp_create(void)
+{
+    Lor_AVLp_bst *tree = malloc(sizeof *tree);
+    if (!tree) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    return tree;
+}
+
+int Lor_AVLp_init(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool, Lor_AVL_compare compare)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(pool, __func__, "argument pool must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+
+    /* The header and the root node are allocated together */
+    Lor_mem_pool_off off = Lor_mem_pool_file_alloc(pool, sizeof(Lor_AVLp_header) + sizeof(Lor_AVLp_node));
+    if (!off) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    tree->pool = pool;
+    tree->base = (char *) Lor_mem_pool_file_ptr(pool, off) - off;
+    tree->compare = compare;
+    tree->header = off;
+
+    Lor_mem_pool_off root = off + sizeof(Lor_AVLp_header);
+    *treep_header(tree) = (Lor_AVLp_header){ .root = root, .nitems = 0 };
+    *AVLP_NODE(tree, root) = (Lor_AVLp_node){ .height = 0 };  /* empty tree */
+
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLp_open(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool, Lor_AVL_compare compare,
+                  Lor_mem_pool_off off)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(pool, __func__, "argument pool must be non-NULL");
+
+    if (!compare) {
+        return LOR_COMPARE_FN_NOT_PROVIDED_ERR;
+    }
+    /* The header and the root node must lie in the used part of the pool */
+    size_t used = Lor_mem_pool_file_used(pool);
+    if (!off || (off & (sizeof(uintmax_t) - 1)) ||
+        off > used || used - off < sizeof(Lor_AVLp_header) + sizeof(Lor_AVLp_node)) {
+        return LOR_BAD_FILE_FORMAT_ERR;
+    }
+
+    tree->pool = pool;
+    tree->base = (char *) Lor_mem_pool_file_ptr(pool, off) - off;
+    tree->compare = compare;
+    tree->header = off;
+
+    return LOR_SUCCESS;
+}
+
+Lor_mem_pool_off Lor_AVLp_get_offset(const Lor_AVLp_bst *restrict tree)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    return tree->header;
+}
+
+size_t Lor_AVLp_nitems(const Lor_AVLp_bst *restrict tree)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+
+    return (size_t) treep_header(tree)->nitems;
+}
+
+int Lor_AVLp_destroy(Lor_AVLp_bst **restrict tree)
+{
+    if (!(*tree)) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    free(*tree);
+    *tree = NULL;
+
+    return LOR_SUCCESS;
+}
+
+Lor_mem_pool_off Lor_AVLp_find(const Lor_AVLp_bst *restrict tree, const void *key)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key, __func__, "argument key must be non-NULL");
+
+    Lor_AVLp_node *tmpnode = AVLP_NODE(tree, treep_header(tree)->root);
+    if (!tmpnode->subtrees[0]) {
+        return 0;
+    }
+
+    while (tmpnode->subtrees[1]) {
+        if (tree->compare(AVLP_PTR(tree, tmpnode->key), key) > 0) {
+            tmpnode = AVLP_NODE(tree, tmpnode->subtrees[0]);
+        }
+        else {
+            tmpnode = AVLP_NODE(tree, tmpnode->subtrees[1]);
+        }
+    }
+    return (!tree->compare(AVLP_PTR(tree, tmpnode->key), key)) ? tmpnode->subtrees[0] : 0;
+}
+
+int Lor_AVLp_insert(Lor_AVLp_bst *restrict tree, Lor_mem_pool_off key, Lor_mem_pool_off data)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(key && data, __func__, "arguments key and data must be non-null offsets");
+
+    if (Lor_mem_pool_file_is_readonly(tree->pool)) {
+        return LOR_READ_ONLY_ERR;
+    }
+
+    Lor_AVLp_header *header = treep_header(tree);
+    Lor_AVLp_node *current = AVLP_NODE(tree, header->root);
+    const void *keyptr = AVLP_PTR(tree, key);
+
+    if (!current->subtrees[0]) {  /* empty tree */
+        *current = (Lor_AVLp_node){ .height = 0, .key = key, .subtrees = { data, 0 } };
+        header->nitems++;
+        return LOR_SUCCESS;
+    }
+
+    Lor_AVLp_node *stack[LOR_AVL_BST_MAX_HEIGHT];
+    size_t height = 0;
+    while (current->subtrees[1] && height < LOR_AVL_BST_MAX_HEIGHT) {
+        stack[height++] = current;  /* for rebalancing */
+        if (tree->compare(keyptr, AVLP_PTR(tree, current->key)) < 0) {
+            current = AVLP_NODE(tree, current->subtrees[0]);
+        }
+        else {
+            current = AVLP_NODE(tree, current->subtrees[1]);
+        }
+    }
+    if (current->subtrees[1]) {
+        return LOR_MAX_HEIGHT_ERR;
+    }
+    /* Found a candidate leaf */
+    int32_t cmp = tree->compare(AVLP_PTR(tree, current->key), keyptr);
+    if (!cmp) {  /* permit only distinct keys */
+#ifdef LOR_AVL_ONLY_DISTINCT_KEYS
+        return LOR_DISTINCT_KEY_ERR;
+#else  /* Updates the data if try same key insertion */
+        current->subtrees[0] = data;
+        return LOR_SUCCESS;
+#endif
+    }
+
+    Lor_mem_pool_off oldleaf = __AVLp_new_leaf(tree, current->key, current->subtrees[0]);
+    Lor_mem_pool_off newleaf = (oldleaf) ? __AVLp_new_leaf(tree, key, data) : 0;
+    if (!newleaf) {
+        return LOR_ALLOC_FAIL_ERR;
+    }
+
+    if (cmp < 0) {
+        current->subtrees[0] = oldleaf;
+        current->subtrees[1] = newleaf;
+        current->key = key;
+    }
+    else {
+        current->subtrees[0] = newleaf;
+        current->subtrees[1] = oldleaf;
+    }
+    current->height = 1;
+    header->nitems++;
+
+    /* Rebalance */
+    while (height) {
+        current = stack[--height];
+        Lor_AVLp_node *left = AVLP_NODE(tree, current->subtrees[0]);
+        Lor_AVLp_node *right = AVLP_NODE(tree, current->subtrees[1]);
+
+        if (left->height - right->height == 2) {
+            /* Left-left unbalanced */
+            if (AVLP_NODE(tree, left->subtrees[0])->height - right->height == 1) {
+                treep_right_rotate(tree, current);
+                Lor_AVLp_node *newright = AVLP_NODE(tree, current->subtrees[1]);
+                newright->height = AVLP_NODE(tree, newright->subtrees[0])->height + 1;
+                current->height = newright->height + 1;
+            }
+            /* Left-right unbalanced */
+            else {
+                treep_left_rotate(tree, left);
+                treep_right_rotate(tree, current);
+                Lor_AVLp_node *newleft = AVLP_NODE(tree, current->subtrees[0]);
+                int32_t tmpheight = AVLP_NODE(tree, newleft->subtrees[0])->height;
+                newleft->height = tmpheight + 1;
+                AVLP_NODE(tree, current->subtrees[1])->height = tmpheight + 1;
+                current->height = tmpheight + 2;
+            }
+        }
+        else if (left->height - right->height == -2) {
+            /* Right-right unbalanced */
+            if (AVLP_NODE(tree, right->subtrees[1])->height - left->height == 1) {
+                treep_left_rotate(tree, current);
+                Lor_AVLp_node *newleft = AVLP_NODE(tree, current->subtrees[0]);
+                newleft->height = AVLP_NODE(tree, newleft->subtrees[1])->height + 1;
+                current->height = newleft->height + 1;
+            }
+            /* Right-left unbalanced */
+            else {
+                treep_right_rotate(tree, right);
+                treep_left_rotate(tree, current);
+                Lor_AVLp_node *newright = AVLP_NODE(tree, current->subtrees[1]);
+                int32_t tmpheight = AVLP_NODE(tree, newright->subtrees[1])->height;
+                AVLP_NODE(tree, current->subtrees[0])->height = tmpheight + 1;
+                newright->height = tmpheight + 1;
+                current->height = tmpheight + 2;
+            }
+        }
+        else { /* update height even if there was no rotation */
+            current->height = 1 + ((left->height > right->height) ? left->height : right->height);
+        }
+    }
+    return LOR_SUCCESS;
+}
+
+int Lor_AVLp_traverse_lr(const Lor_AVLp_bst *restrict tree, Lor_AVL_map mapfn)
+{
+    Lor_assert(tree, __func__, "argument tree must be non-NULL");
+    Lor_assert(mapfn, __func__, "argument mapfn must be non-NULL");
+
+    Lor_AVLp_node *current = AVLP_NODE(tree, treep_header(tree)->root);
+    if (!current->subtrees[0]) { /* empty tree */
+        return LOR_EMPTY_TREE_ERR;
+    }
+
+    Lor_AVLp_node *stack[LOR_AVL_BST_MAX_HEIGHT];
+    size_t height = 0;
+    size_t itemsmapped = (size_t) treep_header(tree)->nitems;
+    while (itemsmapped) {
+        if (!current->subtrees[1]) { /* if it's a leaf */
+            mapfn(AVLP_PTR(tree, current->subtrees[0])); /* map over data */
+            if (--itemsmapped) {
+                current = AVLP_NODE(tree, stack[--height]->subtrees[1]);
+            }
+        }
+        else if (height == LOR_AVL_BST_MAX_HEIGHT) {
+            return LOR_MAX_HEIGHT_ERR;
+        }
+        else {
+            stack[height++] = current;
+            current = AVLP_NODE(tree, current->subtrees[0]);
+        }
+    }
+    return LOR_SUCCESS;
+}
+
+/* End Of File */
@@ -0,0 +1,112 @@
+/* C Header file:
+ *               Lor_AVLpbst.h
+ *
+ * Interface for AVL binary search tree stored in a Lor_mem_pool_file.
+ *
+ * This is the same 'leaf tree' as Lor_AVLbst.h, but every link of a node
+ * (subtrees, key and data) is an offset in the file instead of an address,
+ * so a tree built once by a loader can be mapped by any number of reader
+ * processes, read-only, and searched right away.  The keys and the data
+ * must be allocated in the same file with Lor_mem_pool_file_alloc.  There
+ * is no delete: the nodes of a file pool are never freed.
+ *
+ * The tree itself lives in the file; a Lor_AVLp_bst is only a handle to
+ * it, found again by a reader with the offset given by Lor_AVLp_get_offset
+ * (usually recorded with Lor_mem_pool_file_set_root).
+ *
+ * Public functions:
+ *
+ * Lor_AVLp_bst *Lor_AVLp_create(void);
+ *     This functions returns a new tree handle on the heap.
+ *
+ * int Lor_AVLp_init(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool,
+ *              Lor_AVL_compare compare);
+ *     This function creates an empty tree in pool.
+ *     Parameters:
+ *         - tree    -> a handle created by Lor_AVLp_create
+ *         - pool    -> a writable Lor_mem_pool_file
+ *         - compare -> a comparison function for keys
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_COMPARE_FN_NOT_PROVIDED_ERR if compare function has not been
+ *           provided
+ *         - LOR_ALLOC_FAIL_ERR if the pool is full or read-only
+ *
+ * int Lor_AVLp_open(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool,
+ *              Lor_AVL_compare compare, Lor_mem_pool_off off);
+ *     This function binds tree to the tree stored at off in pool.
+ *     Parameters:
+ *         - tree    -> a handle created by Lor_AVLp_create
+ *         - pool    -> the Lor_mem_pool_file holding the tree
+ *         - compare -> the comparison function the tree was built with
+ *         - off     -> the offset given by Lor_AVLp_get_offset
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_COMPARE_FN_NOT_PROVIDED_ERR if compare function has not been
+ *           provided
+ *         - LOR_BAD_FILE_FORMAT_ERR if off is not the aligned offset of a
+ *           tree header and root node within the used part of pool
+ *
+ * Lor_mem_pool_off Lor_AVLp_get_offset(const Lor_AVLp_bst *restrict tree);
+ *     This function returns the offset of the tree in its pool.
+ *
+ * size_t Lor_AVLp_nitems(const Lor_AVLp_bst *restrict tree);
+ *     This function returns the number of items of the tree.
+ *
+ * int Lor_AVLp_destroy(Lor_AVLp_bst **restrict tree);
+ *     This function destroys a handle allocated by Lor_AVLp_create.  The
+ *     tree stays in its pool.
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_FREE_NULLPTR_WARN if *tree is a NULL pointer
+ *
+ * Lor_mem_pool_off Lor_AVLp_find(const Lor_AVLp_bst *restrict tree, const void *key);
+ *     This function searches for key in tree.  key may be anywhere in
+ *     memory.
+ *     Returns:
+ *         - the offset of the data of key
+ *         - 0 if key is not on tree
+ *
+ * int Lor_AVLp_insert(Lor_AVLp_bst *restrict tree, Lor_mem_pool_off key,
+ *              Lor_mem_pool_off data);
+ *     This function inserts the key allocated at key in the pool with the
+ *     data allocated at data.  As in Lor_AVL_insert, inserting a key that
+ *     is already on tree updates its data (or fails if the library  was
+ *     built with LOR_AVL_ONLY_DISTINCT_KEYS).
+ *     Returns:
+ *         - LOR_SUCCESS if successfull
+ *         - LOR_READ_ONLY_ERR if the pool is read-only
+ *         - LOR_ALLOC_FAIL_ERR if the pool is full
+ *         - LOR_DISTINCT_KEY_ERR if the key is already on tree
+ *         - LOR_MAX_HEIGHT_ERR if the height of the tree is greater than the
+ *           permitted
+ *
+ * int Lor_AVLp_traverse_lr(const Lor_AVLp_bst *restrict tree, Lor_AVL_map mapfn);
+ *     Function the traverses the tree applying mapfn function over the
+ *     address of the data in this mapping of the pool.
+ *     Returns:
+ *         - LOR_SUCCESS, if successfull
+ *         - LOR_EMPTY_TREE_ERR, if the tree is empty
+ *         - LOR_MAX_HEIGHT_ERR, if the height of the tree is greater  than
+ *           the permitted
+ **************************************************************************/
+#ifndef LOR_AVL_PBST_H
+#define LOR_AVL_PBST_H 1
+
+#include <Lor_mem_pool.h>
+#include <Lor_AVLbst.h>
+
+typedef struct _Lor_AVLp_bst Lor_AVLp_bst;
+
+extern Lor_AVLp_bst *Lor_AVLp_create(void);
+extern int Lor_AVLp_init(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool, Lor_AVL_compare compare);
+extern int Lor_AVLp_open(Lor_AVLp_bst *restrict tree, Lor_mem_pool_file *pool, Lor_AVL_compare compare,
+                         Lor_mem_pool_off off);
+extern Lor_mem_pool_off Lor_AVLp_get_offset(const Lor_AVLp_bst *restrict tree);
+extern size_t Lor_AVLp_nitems(const Lor_AVLp_bst *restrict tree);
+extern int Lor_AVLp_destroy(Lor_AVLp_bst **restrict tree);
+extern Lor_mem_pool_off Lor_AVLp_find(const Lor_AVLp_bst *restrict tree, const void *key);
+extern int Lor_AVLp_insert(Lor_AVLp_bst *restrict tree, Lor_mem_pool_off key, Lor_mem_pool_off data);
+extern int Lor_AVLp_traverse_lr(const Lor_AVLp_bst *restrict tree, Lor_AVL_map mapfn);
+
+#endif
@@ -0,0 +1,73 @@
+/* C Header file:
+ *               Lor_AVLpbstdef.h
+ * Type definitions for AVL binary search tree stored in a file pool
+ * NOTE: This header file is for exclusive use of the implementation
+ * and should not be exposed.
+ */
+#ifndef LOR_AVL_PBST_DEF_H
+#define LOR_AVL_PBST_DEF_H 1
+
+#include "Lor_AVLpbst.h"
+#include "Lor_AVLbstdef.h"
+#include <Lor_BSTs.h>
+#include <Lor_assert.h>
+
+/* The layout of these structures is the file format of the tree */
+typedef struct Lor_AVLp_node {
+    int32_t height;
+    uint32_t reserved;
+    Lor_mem_pool_off key;
+    Lor_mem_pool_off subtrees[2];  /* [0] for left, [1] for right subtree.  A leaf */
+} Lor_AVLp_node;                   /* has no right subtree and its data in [0].    */
+
+typedef struct Lor_AVLp_header {
+    Lor_mem_pool_off root;
+    uint64_t nitems;
+} Lor_AVLp_header;
+
+struct _Lor_AVLp_bst {
+    Lor_mem_pool_file *pool;
+    char *base;                /* start of the mapping of pool */
+    Lor_AVL_compare compare;
+    Lor_mem_pool_off header;   /* offset of the Lor_AVLp_header of the tree */
+};
+
+#define AVLP_NODE(tree, off) ((Lor_AVLp_node *) ((tree)->base + (off)))
+#define AVLP_PTR(tree, off) ((void *) ((tree)->base + (off)))
+
+/*========== Inline functions ===========*/
+
+static inline Lor_AVLp_header *treep_header(const Lor_AVLp_bst *restrict tree)
+{
+    return (Lor_AVLp_header *) (tree->base + tree->header);
+}
+
+static inline void treep_left_rotate(const Lor_AVLp_bst *restrict tree, Lor_AVLp_node *node)
+{
+    Lor_mem_pool_off tmpkey = node->key;
+    Lor_mem_pool_off tmpnode = node->subtrees[0];
+    Lor_AVLp_node *right = AVLP_NODE(tree, node->subtrees[1]);
+
+    node->key = right->key;
+    node->subtrees[0] = node->subtrees[1];
+    node->subtrees[1] = right->subtrees[1];
+    right->subtrees[1] = right->subtrees[0];
+    right->subtrees[0] = tmpnode;
+    right->key = tmpkey;
+}
+
+static inline void treep_right_rotate(const Lor_AVLp_bst *restrict tree, Lor_AVLp_node *node)
+{
+    Lor_mem_pool_off tmpkey = node->key;
+    Lor_mem_pool_off tmpnode = node->subtrees[1];
+    Lor_AVLp_node *left = AVLP_NODE(tree, node->subtrees[0]);
+
+    node->key = left->key;
+    node->subtrees[1] = node->subtrees[0];
+    node->subtrees[0] = left->subtrees[0];
+    left->subtrees[0] = left->subtrees[1];
+    left->subtrees[1] = tmpnode;
+    left->key = tmpkey;
+}
+
+#endif
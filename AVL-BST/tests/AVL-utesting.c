@@ -3,6 +3,10 @@
  * Simple unit testing for AVL_bst implementation
  */
 #include "Lor_AVLbstdef.h"
+#include "Lor_AVLnbstdef.h"
+#include "Lor_AVLcbstdef.h"
+#include "Lor_AVLibstdef.h"
+#include <Lor_mem_pool_def.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -12,6 +16,7 @@
 #include <cmocka.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 
 typedef struct UserTest_ UserTest;
 
@@ -32,6 +37,27 @@ static void TEST_INT_AVL_delete(void **state);
 static void TEST_USER_DEF_TYPE_insert(void **state);
 static void TEST_USER_DEF_TYPE_interval_find(void **state);
 static void TEST_USER_DEF_TYPE_delete(void **state);
+static void TEST_INT_AVL_allocator_ctx(void **state);
+static void TEST_INT_AVL_pool_churn(void **state);
+static void TEST_INT_AVL_discard(void **state);
+static void TEST_INT_AVL_node_alignment(void **state);
+static void TEST_INT_AVL_pool_trim(void **state);
+static void TEST_INT_AVLp_file(void **state);
+static void TEST_STR_AVL_interned_keys(void **state);
+static void TEST_INT_AVLn_insert_delete(void **state);
+static void TEST_INT_AVLn_interval_pool(void **state);
+static void TEST_INT_AVLc_insert_delete(void **state);
+static void TEST_AVLgen_typed_keys(void **state);
+static void TEST_AVLi_intrusive_records(void **state);
+static void TEST_INT_AVL_build_sorted(void **state);
+static void TEST_INT_AVL_join_split_sets(void **state);
+static void TEST_INT_AVL_order_statistics(void **state);
+static void TEST_INT_AVL_cursor(void **state);
+static void TEST_INT_AVL_leaf_threads(void **state);
+static void TEST_INT_AVL_range_aggregate(void **state);
+static void TEST_INT_AVL_delete_range(void **state);
+static void TEST_INT_AVL_find_batch(void **state);
+static void TEST_INT_AVL_finger_search(void **state);
 
 static int setup(void **state);
 static int tear_down(void **state);
@@ -219,9 +245,9 @@ static void TEST_INT_AVL_insert_unordered1(void **state)
 static void _AVL_insert_increasing_order(Lor_AVL_bst *tree)
 {
     int *ptrs[NTESTS];
-    for (size_t i = 1; i <= NTESTS; i++) {
+    for (size_t i = 0; i < NTESTS; i++) {
         ptrs[i] = malloc(sizeof *ptrs[i]);
-        *ptrs[i] = i;
+        *ptrs[i] = i+1;
         assert(Lor_AVL_insert(tree, ptrs[i], ptrs[i]) == LOR_SUCCESS);
     }
 }
@@ -484,6 +510,1882 @@ static void TEST_USER_DEF_TYPE_delete(void **state)
     assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
 }
 
+typedef struct {
+    size_t nlive;
+    size_t nodesize;    /* size of the nodes freed, 0 for sizeof(Lor_AVL_bst_node) */
+    size_t nallocs;     /* allocations requested */
+    size_t failat;      /* number of the allocation that fails, 0 for none */
+} CountingCtx;
+
+static void *counting_alloc(void *ctx, size_t nbytes)
+{
+    CountingCtx *counting = ctx;
+    if (++counting->nallocs == counting->failat) {
+        return NULL;
+    }
+    counting->nlive++;
+    return alloc(nbytes);
+}
+
+static void counting_free_node(void *ctx, void *ptr, size_t nbytes)
+{
+    size_t nodesize = ((CountingCtx *) ctx)->nodesize;
+    assert_int_equal(nbytes, (nodesize) ? nodesize : sizeof(Lor_AVL_bst_node));
+    ((CountingCtx *) ctx)->nlive--;
+    free(ptr);
+}
+
+#undef NTESTS
+#define NTESTS 1000
+
+static void TEST_INT_AVL_allocator_ctx(void **state)
+{
+    CountingCtx ctx = { .nlive = 0 };
+    const Lor_AVL_allocator allocator = {
+        .alloc = counting_alloc,
+        .freenode = counting_free_node,
+        .ctx = &ctx,
+    };
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_allocator(tree, compare_int, NULL, NULL), LOR_ALLOC_FN_NOT_PROVIDED_ERR);
+    assert_int_equal(Lor_AVL_init_with_allocator(tree, compare_int, &allocator, NULL), LOR_SUCCESS);
+    assert_int_equal(ctx.nlive, 1);
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) ((i * 7919) % NTESTS);
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    /* leaf tree: n items are stored in 2n-1 nodes */
+    assert_int_equal(ctx.nlive, 2*NTESTS - 1);
+
+    void *data;
+    assert_int_equal(Lor_AVL_delete(tree, &keys[0], &data), LOR_SUCCESS);
+    assert_int_equal(ctx.nlive, 2*NTESTS - 3);
+
+    /* A failed allocation of either new leaf leaves the tree unchanged */
+    for (size_t i = 1; i <= 2; i++) {
+        ctx.failat = ctx.nallocs + i;
+        assert_int_equal(Lor_AVL_insert(tree, &keys[0], &keys[0]), LOR_ALLOC_FAIL_ERR);
+        assert_int_equal(ctx.nlive, 2*NTESTS - 3);
+        assert_int_equal(tree->nitems, NTESTS - 1);
+        assert_null(Lor_AVL_find(tree, &keys[0]));
+    }
+    ctx.failat = 0;
+    assert_int_equal(Lor_AVL_insert(tree, &keys[0], &keys[0]), LOR_SUCCESS);
+    assert_int_equal(ctx.nlive, 2*NTESTS - 1);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(ctx.nlive, 0);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_pool_churn(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, NULL), LOR_SUCCESS);
+    assert_true(Lor_mem_pool_contains(pool, tree->root));
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) ((i * 7919) % NTESTS);
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    size_t poolalloc = pool->poolalloc;
+
+    for (size_t round = 0; round < 5; round++) {
+        void *data;
+        for (size_t i = 0; i < NTESTS; i += 2) {
+            assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+            assert_ptr_equal(data, &keys[i]);
+        }
+        assert_int_equal(tree->nitems, NTESTS / 2);
+        for (size_t i = 0; i < NTESTS; i += 2) {
+            assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+        }
+    }
+    assert_int_equal(pool->poolalloc, poolalloc);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, &keys[i]);
+        assert_non_null(f);
+        assert_true(Lor_mem_pool_contains(pool, f));
+    }
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static size_t nfreed;
+
+static void count_free(void *ptr)
+{
+    nfreed++;
+}
+
+static void TEST_INT_AVL_discard(void **state)
+{
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_discard(tree, false), LOR_NOT_POOL_BACKED_ERR);
+    assert_int_equal(Lor_AVL_clear(tree), LOR_EMPTY_TREE_ERR);
+    free(tree->root);
+    tree->root = NULL;
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+
+    tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, count_free), LOR_SUCCESS);
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) i;
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_discard(tree, true), LOR_SUCCESS);
+    assert_int_equal(nfreed, NTESTS);
+    assert_null(tree->root);
+    assert_null(pool->mpblock);
+    assert_int_equal(Lor_AVL_discard(tree, true), LOR_FREE_NULLPTR_WARN);
+
+    /* The pool can back a new tree right away */
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, count_free), LOR_SUCCESS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_discard(tree, false), LOR_SUCCESS);
+    assert_int_equal(nfreed, 0);
+
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static bool nodes_aligned(Lor_AVL_bst_node *node, size_t align)
+{
+    if ((uintptr_t) node & (align - 1)) {
+        return false;
+    }
+    if (!node->subtrees[1]) {  /* leaf */
+        return true;
+    }
+    return nodes_aligned(node->subtrees[0], align) && nodes_aligned(node->subtrees[1], align);
+}
+
+static void TEST_INT_AVL_node_alignment(void **state)
+{
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_node_alignment(tree, 64), LOR_NOT_POOL_BACKED_ERR);
+    free(tree->root);
+    tree->root = NULL;
+
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    assert_non_null(Lor_mem_pool_alloc(pool, 8));  /* misalign the pool */
+
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_node_alignment(tree, 48), LOR_INVALID_ALIGNMENT_ERR);
+    assert_int_equal(Lor_AVL_set_node_alignment(tree, 2 * LOR_MEM_POOL_MAX_ALIGNMENT), LOR_INVALID_ALIGNMENT_ERR);
+    assert_int_equal(Lor_AVL_set_node_alignment(tree, 64), LOR_SUCCESS);
+    assert_true(nodes_aligned(tree->root, 64));
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) ((i * 7919) % NTESTS);
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    /* Released nodes are reused */
+    void *data;
+    for (size_t i = 0; i < NTESTS; i += 3) {
+        assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+    }
+    for (size_t i = 0; i < NTESTS; i += 3) {
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    assert_true(nodes_aligned(tree->root, 64));
+    for (size_t i = 0; i < NTESTS; i++) {
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, &keys[i]);
+        assert_non_null(f);
+        assert_int_equal(*(int *) Lor_AVL_get_data_from_node(f), keys[i]);
+    }
+
+    assert_int_equal(Lor_AVL_discard(tree, false), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_pool_trim(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    const Lor_mem_pool_options opts = { .growthsize = 4096, .flags = LOR_MEM_POOL_TRACK_LIVE };
+    assert_int_equal(Lor_mem_pool_init_with_options(pool, 4096, &opts), LOR_SUCCESS);
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, NULL), LOR_SUCCESS);
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) i;
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    size_t peak = pool->poolalloc;
+
+    void *data;
+    for (size_t i = NTESTS / 10; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_mem_pool_trim(pool), LOR_SUCCESS);
+    assert_true(pool->poolalloc < peak);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, &keys[i]);
+        if (i < NTESTS / 10) {
+            assert_non_null(f);
+            assert_true(Lor_mem_pool_contains(pool, f));
+        }
+        else {
+            assert_null(f);
+        }
+    }
+    /* The tree grows again on the trimmed pool */
+    for (size_t i = NTESTS / 10; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    assert_int_equal(tree->nitems, NTESTS);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static int lastmapped;
+static size_t nmapped;
+
+static void check_increasing(void *ptr)
+{
+    assert_true(*(int *) ptr > lastmapped);
+    lastmapped = *(int *) ptr;
+    nmapped++;
+}
+
+static void TEST_INT_AVLp_file(void **state)
+{
+    char path[] = "/tmp/AVL-utesting-XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+    close(fd);
+
+    /* Loader */
+    Lor_mem_pool_file *pool = Lor_mem_pool_file_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 1 << 20, LOR_MEM_POOL_FILE_CREATE), LOR_SUCCESS);
+    Lor_AVLp_bst *tree = Lor_AVLp_create();
+    assert_non_null(tree);
+    assert_int_equal(Lor_AVLp_init(tree, pool, NULL), LOR_COMPARE_FN_NOT_PROVIDED_ERR);
+    assert_int_equal(Lor_AVLp_init(tree, pool, compare_int), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLp_traverse_lr(tree, check_increasing), LOR_EMPTY_TREE_ERR);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        Lor_mem_pool_off off = Lor_mem_pool_file_alloc(pool, sizeof(int));
+        assert_true(off != 0);
+        *(int *) Lor_mem_pool_file_ptr(pool, off) = (int) (2 * ((i * 7919) % NTESTS));
+        assert_int_equal(Lor_AVLp_insert(tree, off, off), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_AVLp_nitems(tree), NTESTS);
+    assert_int_equal(Lor_mem_pool_file_set_root(pool, Lor_AVLp_get_offset(tree)), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLp_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+
+    /* Reader */
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 0, LOR_MEM_POOL_FILE_READONLY), LOR_SUCCESS);
+    tree = Lor_AVLp_create();
+    assert_non_null(tree);
+    assert_int_equal(Lor_AVLp_open(tree, pool, compare_int, 0), LOR_BAD_FILE_FORMAT_ERR);
+    /* Offsets that cannot hold a tree are rejected, not read */
+    Lor_mem_pool_off used = Lor_mem_pool_file_used(pool);
+    assert_int_equal(Lor_AVLp_open(tree, pool, compare_int, Lor_mem_pool_file_get_root(pool) + 4),
+                     LOR_BAD_FILE_FORMAT_ERR);
+    assert_int_equal(Lor_AVLp_open(tree, pool, compare_int, used - sizeof(uintmax_t)), LOR_BAD_FILE_FORMAT_ERR);
+    assert_int_equal(Lor_AVLp_open(tree, pool, compare_int, used + 1024 * sizeof(uintmax_t)),
+                     LOR_BAD_FILE_FORMAT_ERR);
+    assert_int_equal(Lor_AVLp_open(tree, pool, compare_int, Lor_mem_pool_file_get_root(pool)), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLp_nitems(tree), NTESTS);
+    for (int i = 0; i < 2 * NTESTS; i++) {
+        Lor_mem_pool_off off = Lor_AVLp_find(tree, &i);
+        if (i % 2) {
+            assert_int_equal(off, 0);
+        }
+        else {
+            assert_true(off != 0);
+            assert_int_equal(*(int *) Lor_mem_pool_file_ptr(pool, off), i);
+        }
+    }
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVLp_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, NTESTS);
+    assert_int_equal(Lor_AVLp_insert(tree, Lor_mem_pool_file_get_root(pool), Lor_mem_pool_file_get_root(pool)),
+                     LOR_READ_ONLY_ERR);
+
+    assert_int_equal(Lor_AVLp_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_destroy(&pool), LOR_SUCCESS);
+    unlink(path);
+}
+
+static size_t ncompares;
+
+static int32_t compare_str_counting(const void *str1, const void *str2)
+{
+    ncompares++;
+    return compare_str(str1, str2);
+}
+
+static void TEST_STR_AVL_interned_keys(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    Lor_mem_pool_strtab *tab = Lor_mem_pool_strtab_create();
+    assert_non_null(tab);
+    assert_int_equal(Lor_mem_pool_strtab_init(tab, pool), LOR_SUCCESS);
+
+    /* Two trees share the interned keys */
+    Lor_AVL_bst *trees[2];
+    for (size_t t = 0; t < 2; t++) {
+        trees[t] = Lor_AVL_create();
+        assert(trees[t]);
+        assert_int_equal(Lor_AVL_init_with_pool(trees[t], compare_str_counting, pool, NULL), LOR_SUCCESS);
+    }
+    char buf[32];
+    for (size_t i = 0; i < NTESTS; i++) {
+        snprintf(buf, sizeof buf, "key-%zu", i);
+        const char *key = Lor_mem_pool_strtab_intern(tab, buf);
+        assert_non_null(key);
+        for (size_t t = 0; t < 2; t++) {
+            assert_int_equal(Lor_AVL_insert(trees[t], (void *) key, (void *) key), LOR_SUCCESS);
+        }
+    }
+    assert_int_equal(Lor_mem_pool_strtab_count(tab), NTESTS);
+
+    /* A canonical key skips the compare of the final leaf check */
+    for (size_t i = 0; i < NTESTS; i++) {
+        snprintf(buf, sizeof buf, "key-%zu", i);
+        const char *key = Lor_mem_pool_strtab_lookup(tab, buf);
+        ncompares = 0;
+        Lor_AVL_bst_node *f = Lor_AVL_find(trees[0], buf);
+        assert_non_null(f);
+        size_t copycompares = ncompares;
+        ncompares = 0;
+        assert_ptr_equal(Lor_AVL_find(trees[0], key), f);
+        assert_int_equal(ncompares + 1, copycompares);
+        assert_ptr_equal(Lor_AVL_get_data_from_node(f), key);
+    }
+
+    void *data;
+    for (size_t i = 0; i < NTESTS; i += 2) {
+        snprintf(buf, sizeof buf, "key-%zu", i);
+        assert_int_equal(Lor_AVL_delete(trees[1], (void *) Lor_mem_pool_strtab_lookup(tab, buf), &data), LOR_SUCCESS);
+        assert_string_equal((char *) data, buf);
+    }
+    assert_int_equal(trees[1]->nitems, NTESTS / 2);
+    assert_int_equal(trees[0]->nitems, NTESTS);
+
+    for (size_t t = 0; t < 2; t++) {
+        assert_int_equal(Lor_AVL_clear(trees[t]), LOR_SUCCESS);
+        assert_int_equal(Lor_AVL_destroy(&trees[t]), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_mem_pool_strtab_clear(tab), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_strtab_destroy(&tab), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+/* Check the heights, the balance and the order of a node-oriented tree.
+ * Returns the number of nodes. */
+static size_t check_AVLn(const Lor_AVLn_bst *tree, const Lor_AVLn_bst_node *node,
+                         const void *lo, const void *hi)
+{
+    if (!node) {
+        return 0;
+    }
+    if (lo) assert_true(tree->compare(node->key, lo) > 0);
+    if (hi) assert_true(tree->compare(node->key, hi) < 0);
+    int32_t lh = treen_height(node->subtrees[0]);
+    int32_t rh = treen_height(node->subtrees[1]);
+    assert_true(lh - rh <= 1 && rh - lh <= 1);
+    assert_int_equal(node->height, 1 + ((lh > rh) ? lh : rh));
+    return 1 + check_AVLn(tree, node->subtrees[0], lo, node->key)
+             + check_AVLn(tree, node->subtrees[1], node->key, hi);
+}
+
+static void TEST_INT_AVLn_insert_delete(void **state)
+{
+    Lor_AVLn_bst *tree = Lor_AVLn_create();
+    assert(tree);
+    assert_int_equal(Lor_AVLn_init(tree, NULL, alloc, NULL, NULL), LOR_COMPARE_FN_NOT_PROVIDED_ERR);
+    assert_int_equal(Lor_AVLn_init(tree, compare_int, NULL, NULL, NULL), LOR_ALLOC_FN_NOT_PROVIDED_ERR);
+    assert_int_equal(Lor_AVLn_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLn_clear(tree), LOR_EMPTY_TREE_ERR);
+    assert_int_equal(Lor_AVLn_traverse_lr(tree, check_increasing), LOR_EMPTY_TREE_ERR);
+
+    static int keys[NTESTS];
+    void *data;
+    assert_int_equal(Lor_AVLn_delete(tree, &keys[0], &data), LOR_EMPTY_TREE_ERR);
+    for (size_t order = 0; order < 3; order++) {
+        for (size_t i = 0; i < NTESTS; i++) {
+            keys[i] = (order == 0) ? (int) i : (order == 1) ? (int) (NTESTS - i) : (int) ((i * 7919) % NTESTS);
+            assert_int_equal(Lor_AVLn_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+        }
+        assert_int_equal(tree->nitems, NTESTS);
+        assert_int_equal(check_AVLn(tree, tree->root, NULL, NULL), NTESTS);
+        /* n items in at most 1.44 log2(n) levels */
+        assert_true(tree->root->height <= 15);
+
+        lastmapped = -1;
+        nmapped = 0;
+        assert_int_equal(Lor_AVLn_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+        assert_int_equal(nmapped, NTESTS);
+
+        for (size_t i = 0; i < NTESTS; i++) {
+            int key = keys[i];
+            Lor_AVLn_bst_node *f = Lor_AVLn_find(tree, &key);
+            assert_non_null(f);
+            assert_ptr_equal(Lor_AVLn_get_data_from_node(f), &keys[i]);
+        }
+        int missing = -1;
+        assert_null(Lor_AVLn_find(tree, &missing));
+        assert_int_equal(Lor_AVLn_delete(tree, &missing, &data), LOR_DELETE_NON_EXISTENT_KEY_ERR);
+        assert_null(data);
+
+        for (size_t i = 0; i < NTESTS; i += 2) {
+            assert_int_equal(Lor_AVLn_delete(tree, &keys[i], &data), LOR_SUCCESS);
+            assert_ptr_equal(data, &keys[i]);
+        }
+        assert_int_equal(check_AVLn(tree, tree->root, NULL, NULL), NTESTS / 2);
+        for (size_t i = 0; i < NTESTS; i++) {
+            assert_true(!Lor_AVLn_find(tree, &keys[i]) == !(i % 2));
+        }
+        if (order < 2) {
+            for (size_t i = 1; i < NTESTS; i += 2) {
+                assert_int_equal(Lor_AVLn_delete(tree, &keys[i], &data), LOR_SUCCESS);
+                assert_int_equal(check_AVLn(tree, tree->root, NULL, NULL), tree->nitems);
+            }
+            assert_null(tree->root);
+        }
+        else {
+            assert_int_equal(Lor_AVLn_clear(tree), LOR_SUCCESS);
+            assert_null(tree->root);
+            assert_int_equal(tree->nitems, 0);
+        }
+    }
+    assert_int_equal(Lor_AVLn_destroy(&tree), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVLn_interval_pool(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+
+    Lor_AVLn_bst *tree = Lor_AVLn_create();
+    assert(tree);
+    assert_int_equal(Lor_AVLn_init_with_pool(tree, compare_int, pool, count_free), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLn_set_node_alignment(tree, 64), LOR_SUCCESS);
+
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) (2 * ((i * 7919) % NTESTS));
+        assert_int_equal(Lor_AVLn_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+        assert_true(Lor_mem_pool_contains(pool, Lor_AVLn_find(tree, &keys[i])));
+    }
+    /* One node per item */
+    Lor_mem_pool_stats stats;
+    Lor_mem_pool_get_stats(pool, &stats);
+    assert_true(stats.used < NTESTS * (sizeof(Lor_AVLn_bst_node) + 64));
+
+    int a = 101, b = 201;
+    Lor_AVLn_bst_node *list = Lor_AVLn_interval_find(tree, &a, &b);
+    assert_non_null(list);
+    int expected = 102;
+    for (Lor_AVLn_bst_node *p = list; p; p = p->subtrees[1]) {
+        assert_int_equal(*(int *) Lor_AVLn_get_data_from_node(p), expected);
+        expected += 2;
+    }
+    assert_int_equal(expected, 202);
+    lastmapped = -1;
+    nmapped = 0;
+    Lor_AVLn_process_node_list(list, check_increasing);
+    assert_int_equal(nmapped, 50);
+    Lor_AVLn_clear_node_list(tree, list);
+
+    nfreed = 0;
+    assert_int_equal(Lor_AVLn_discard(tree, true), LOR_SUCCESS);
+    assert_int_equal(nfreed, NTESTS);
+    assert_null(pool->mpblock);
+    assert_int_equal(Lor_AVLn_discard(tree, true), LOR_NOT_POOL_BACKED_ERR);
+
+    /* The pool of an empty tree is discarded too */
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLn_init_with_pool(tree, compare_int, pool, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLn_discard(tree, true), LOR_SUCCESS);
+    assert_null(pool->mpblock);
+    assert_int_equal(Lor_AVLn_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+/* Check the heights, the balance and the order of a compact tree.
+ * Returns the number of nodes. */
+static size_t check_AVLc(Lor_AVLc_bst *tree, uint32_t i, const uint64_t *lo, const uint64_t *hi)
+{
+    if (!i) {
+        return 0;
+    }
+    uint64_t key = AVLC_NODE(tree, i)->key;
+    if (lo) assert_true(key > *lo);
+    if (hi) assert_true(key < *hi);
+    int32_t lh = treec_height(tree, treec_child(tree, i, 0));
+    int32_t rh = treec_height(tree, treec_child(tree, i, 1));
+    assert_true(lh - rh <= 1 && rh - lh <= 1);
+    assert_int_equal(treec_height(tree, i), 1 + ((lh > rh) ? lh : rh));
+    return 1 + check_AVLc(tree, treec_child(tree, i, 0), lo, &key)
+             + check_AVLc(tree, treec_child(tree, i, 1), &key, hi);
+}
+
+static void TEST_INT_AVLc_insert_delete(void **state)
+{
+    assert_int_equal(sizeof(Lor_AVLc_node), 16);
+
+    Lor_AVLc_bst *tree = Lor_AVLc_create();
+    assert(tree);
+    assert_int_equal(Lor_AVLc_init(tree, count_free), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLc_clear(tree), LOR_EMPTY_TREE_ERR);
+    assert_int_equal(Lor_AVLc_traverse_lr(tree, check_increasing), LOR_EMPTY_TREE_ERR);
+    assert_int_equal(Lor_AVLc_reserve(tree, (size_t) LOR_AVLC_MAX_ITEMS + 1), LOR_ALLOC_FAIL_ERR);
+    assert_int_equal(Lor_AVLc_reserve(tree, NTESTS / 2), LOR_SUCCESS);
+
+    static int keys[NTESTS];
+    void *data;
+    assert_int_equal(Lor_AVLc_delete(tree, 0, &data), LOR_EMPTY_TREE_ERR);
+    for (size_t order = 0; order < 3; order++) {
+        for (size_t i = 0; i < NTESTS; i++) {
+            keys[i] = (order == 0) ? (int) i : (order == 1) ? (int) (NTESTS - i) : (int) ((i * 7919) % NTESTS);
+            assert_int_equal(Lor_AVLc_insert(tree, (uint64_t) keys[i], &keys[i]), LOR_SUCCESS);
+        }
+        assert_int_equal(tree->nitems, NTESTS);
+        assert_int_equal(check_AVLc(tree, tree->root, NULL, NULL), NTESTS);
+        assert_true(treec_height(tree, tree->root) <= 15);
+
+        lastmapped = -1;
+        nmapped = 0;
+        assert_int_equal(Lor_AVLc_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+        assert_int_equal(nmapped, NTESTS);
+
+        for (size_t i = 0; i < NTESTS; i++) {
+            assert_ptr_equal(Lor_AVLc_find(tree, (uint64_t) keys[i]), &keys[i]);
+        }
+        assert_null(Lor_AVLc_find(tree, UINT64_MAX));
+        assert_int_equal(Lor_AVLc_delete(tree, UINT64_MAX, &data), LOR_DELETE_NON_EXISTENT_KEY_ERR);
+        assert_null(data);
+
+        for (size_t i = 0; i < NTESTS; i += 2) {
+            assert_int_equal(Lor_AVLc_delete(tree, (uint64_t) keys[i], &data), LOR_SUCCESS);
+            assert_ptr_equal(data, &keys[i]);
+        }
+        assert_int_equal(check_AVLc(tree, tree->root, NULL, NULL), NTESTS / 2);
+        for (size_t i = 0; i < NTESTS; i++) {
+            assert_true(!Lor_AVLc_find(tree, (uint64_t) keys[i]) == !(i % 2));
+        }
+        /* The released nodes are reused before the array grows */
+        uint32_t nnodes = tree->nnodes;
+        for (size_t i = 0; i < NTESTS; i += 2) {
+            assert_int_equal(Lor_AVLc_insert(tree, (uint64_t) keys[i], &keys[i]), LOR_SUCCESS);
+        }
+        assert_int_equal(tree->nnodes, nnodes);
+        assert_int_equal(check_AVLc(tree, tree->root, NULL, NULL), NTESTS);
+
+        if (order < 2) {
+            for (size_t i = 0; i < NTESTS; i++) {
+                assert_int_equal(Lor_AVLc_delete(tree, (uint64_t) keys[i], &data), LOR_SUCCESS);
+                assert_int_equal(check_AVLc(tree, tree->root, NULL, NULL), tree->nitems);
+            }
+            assert_int_equal(tree->root, 0);
+        }
+        else {
+            nfreed = 0;
+            assert_int_equal(Lor_AVLc_clear(tree), LOR_SUCCESS);
+            assert_int_equal(nfreed, NTESTS);
+            assert_int_equal(tree->root, 0);
+            assert_int_equal(tree->nitems, 0);
+        }
+    }
+    assert_int_equal(Lor_AVLc_destroy(&tree), LOR_SUCCESS);
+}
+
+/* A tree generated in this file, in decreasing order of its keys */
+#define CMP_DECREASING(a, b) LOR_AVL_CMP_NUM(b, a)
+LOR_AVL_DEFINE(Dec_AVL, int32_t, CMP_DECREASING)
+
+static size_t check_Dec_AVL(const Dec_AVL_node *node)
+{
+    if (!node) {
+        return 0;
+    }
+    int32_t lh = (node->subtrees[0]) ? node->subtrees[0]->height : 0;
+    int32_t rh = (node->subtrees[1]) ? node->subtrees[1]->height : 0;
+    assert_true(lh - rh <= 1 && rh - lh <= 1);
+    assert_int_equal(node->height, 1 + ((lh > rh) ? lh : rh));
+    if (node->subtrees[0]) assert_true(node->subtrees[0]->key > node->key);
+    if (node->subtrees[1]) assert_true(node->subtrees[1]->key < node->key);
+    return 1 + check_Dec_AVL(node->subtrees[0]) + check_Dec_AVL(node->subtrees[1]);
+}
+
+static void TEST_AVLgen_typed_keys(void **state)
+{
+    static int keys[NTESTS];
+    void *data;
+
+    Lor_AVLi64 *itree = Lor_AVLi64_create();
+    assert(itree);
+    assert_int_equal(Lor_AVLi64_init(itree, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLi64_delete(itree, 0, &data), LOR_EMPTY_TREE_ERR);
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) ((i * 7919) % NTESTS);
+        assert_int_equal(Lor_AVLi64_insert(itree, (int64_t) keys[i] - NTESTS / 2, &keys[i]), LOR_SUCCESS);
+    }
+    assert_int_equal(itree->nitems, NTESTS);
+    assert_true(itree->root->height <= 15);
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVLi64_traverse_lr(itree, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, NTESTS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_ptr_equal(Lor_AVLi64_find(itree, (int64_t) keys[i] - NTESTS / 2), &keys[i]);
+    }
+    assert_null(Lor_AVLi64_find(itree, INT64_MIN));
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVLi64_delete(itree, (int64_t) keys[i] - NTESTS / 2, &data), LOR_SUCCESS);
+        assert_ptr_equal(data, &keys[i]);
+    }
+    assert_null(itree->root);
+    assert_int_equal(Lor_AVLi64_destroy(&itree), LOR_SUCCESS);
+
+    /* Pool backed, cleared */
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    Lor_AVLu64 utree;
+    assert_int_equal(Lor_AVLu64_init_with_pool(&utree, pool, count_free), LOR_SUCCESS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVLu64_insert(&utree, UINT64_MAX - keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    assert_true(Lor_mem_pool_contains(pool, utree.root));
+    assert_ptr_equal(Lor_AVLu64_find(&utree, UINT64_MAX - keys[7]), &keys[7]);
+    nfreed = 0;
+    assert_int_equal(Lor_AVLu64_clear(&utree), LOR_SUCCESS);
+    assert_int_equal(nfreed, NTESTS);
+    assert_int_equal(Lor_AVLu64_clear(&utree), LOR_EMPTY_TREE_ERR);
+
+    Lor_AVLf64 ftree;
+    assert_int_equal(Lor_AVLf64_init_with_pool(&ftree, pool, NULL), LOR_SUCCESS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVLf64_insert(&ftree, keys[i] * 0.5, &keys[i]), LOR_SUCCESS);
+    }
+    assert_int_equal(*(int *) Lor_AVLf64_find(&ftree, 21.5), 43);
+    assert_null(Lor_AVLf64_find(&ftree, 21.25));
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVLf64_traverse_lr(&ftree, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, NTESTS);
+    assert_int_equal(Lor_AVLf64_clear(&ftree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+
+    /* Generated with a custom comparison */
+    Dec_AVL dtree;
+    assert_int_equal(Dec_AVL_init(&dtree, NULL), LOR_SUCCESS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Dec_AVL_insert(&dtree, keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    assert_int_equal(check_Dec_AVL(dtree.root), NTESTS);
+    for (size_t i = 0; i < NTESTS; i += 2) {
+        assert_int_equal(Dec_AVL_delete(&dtree, keys[i], &data), LOR_SUCCESS);
+    }
+    assert_int_equal(check_Dec_AVL(dtree.root), NTESTS / 2);
+    assert_int_equal(Dec_AVL_clear(&dtree), LOR_SUCCESS);
+}
+
+/* Records of an intrusive tree */
+struct conn {
+    uint64_t id;
+    Lor_AVL_link link;
+    int released;
+};
+
+static int32_t compare_conn(const Lor_AVL_link *a, const Lor_AVL_link *b)
+{
+    uint64_t ida = LOR_CONTAINER_OF(a, struct conn, link)->id;
+    uint64_t idb = LOR_CONTAINER_OF(b, struct conn, link)->id;
+    return (ida > idb) - (ida < idb);
+}
+
+static uint64_t lastid;
+
+static void check_conn_increasing(Lor_AVL_link *link)
+{
+    struct conn *c = LOR_CONTAINER_OF(link, struct conn, link);
+    assert_true(nmapped == 0 || c->id > lastid);
+    lastid = c->id;
+    nmapped++;
+}
+
+static void release_conn(Lor_AVL_link *link)
+{
+    LOR_CONTAINER_OF(link, struct conn, link)->released++;
+}
+
+/* Check the heights, the balance and the order of an intrusive tree.
+ * Returns the number of links. */
+static size_t check_AVLi(const Lor_AVL_link *link, const Lor_AVL_link *lo, const Lor_AVL_link *hi)
+{
+    if (!link) {
+        return 0;
+    }
+    if (lo) assert_true(compare_conn(link, lo) > 0);
+    if (hi) assert_true(compare_conn(link, hi) < 0);
+    int32_t lh = treei_height(link->subtrees[0]);
+    int32_t rh = treei_height(link->subtrees[1]);
+    assert_true(lh - rh <= 1 && rh - lh <= 1);
+    assert_int_equal(link->height, 1 + ((lh > rh) ? lh : rh));
+    return 1 + check_AVLi(link->subtrees[0], lo, link) + check_AVLi(link->subtrees[1], link, hi);
+}
+
+static void TEST_AVLi_intrusive_records(void **state)
+{
+    static struct conn conns[NTESTS];
+    struct conn probe = { .id = 0 };
+    Lor_AVL_link *link;
+
+    Lor_AVLi_bst *tree = Lor_AVLi_create();
+    assert(tree);
+    assert_int_equal(Lor_AVLi_init(tree, NULL), LOR_COMPARE_FN_NOT_PROVIDED_ERR);
+    assert_int_equal(Lor_AVLi_init(tree, compare_conn), LOR_SUCCESS);
+    assert_int_equal(Lor_AVLi_delete(tree, &probe.link, &link), LOR_EMPTY_TREE_ERR);
+    assert_null(link);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        conns[i] = (struct conn){ .id = (i * 7919) % NTESTS };
+        assert_int_equal(Lor_AVLi_insert(tree, &conns[i].link), LOR_SUCCESS);
+    }
+    assert_int_equal(tree->nitems, NTESTS);
+    assert_int_equal(check_AVLi(tree->root, NULL, NULL), NTESTS);
+    probe.id = conns[3].id;
+    assert_int_equal(Lor_AVLi_insert(tree, &probe.link), LOR_DISTINCT_KEY_ERR);
+
+    nmapped = 0;
+    assert_int_equal(Lor_AVLi_traverse_lr(tree, check_conn_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, NTESTS);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        probe.id = conns[i].id;
+        link = Lor_AVLi_find(tree, &probe.link);
+        assert_ptr_equal(LOR_CONTAINER_OF(link, struct conn, link), &conns[i]);
+    }
+    probe.id = NTESTS;
+    assert_null(Lor_AVLi_find(tree, &probe.link));
+    assert_int_equal(Lor_AVLi_delete(tree, &probe.link, &link), LOR_DELETE_NON_EXISTENT_KEY_ERR);
+
+    /* Deleting relinks the records, whatever their number of subtrees */
+    for (size_t i = 0; i < NTESTS; i += 2) {
+        probe.id = conns[i].id;
+        assert_int_equal(Lor_AVLi_delete(tree, &probe.link, &link), LOR_SUCCESS);
+        assert_ptr_equal(link, &conns[i].link);
+        if (i % 64 == 0) {
+            assert_int_equal(check_AVLi(tree->root, NULL, NULL), tree->nitems);
+        }
+    }
+    assert_int_equal(check_AVLi(tree->root, NULL, NULL), NTESTS / 2);
+    for (size_t i = 0; i < NTESTS; i++) {
+        probe.id = conns[i].id;
+        assert_true(!Lor_AVLi_find(tree, &probe.link) == !(i % 2));
+    }
+    /* A deleted record can be inserted again */
+    assert_int_equal(Lor_AVLi_insert(tree, &conns[0].link), LOR_SUCCESS);
+
+    assert_int_equal(Lor_AVLi_destroy(&tree), LOR_DESTROY_ROOT_NON_NULL);
+    assert_int_equal(Lor_AVLi_clear(tree, release_conn), LOR_SUCCESS);
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(conns[i].released, (i % 2 || i == 0) ? 1 : 0);
+    }
+    assert_int_equal(Lor_AVLi_clear(tree, release_conn), LOR_EMPTY_TREE_ERR);
+    assert_int_equal(Lor_AVLi_destroy(&tree), LOR_SUCCESS);
+}
+
+/* Check the heights, the balance, the keys and the sizes, if kept, of a
+ * leaf tree: the keys of a subtree are in [lo, hi[.  Returns the number of
+ * leafs. */
+static size_t check_AVL(const Lor_AVL_bst *tree, const Lor_AVL_bst_node *node,
+                        const void *lo, const void *hi)
+{
+    if (!node->subtrees[1]) {
+        assert_int_equal(node->height, 0);
+        if (tree->sizes) assert_int_equal(node->size, 1);
+        if (lo) assert_true(tree->compare(node->key, lo) >= 0);
+        if (hi) assert_true(tree->compare(node->key, hi) < 0);
+        return 1;
+    }
+    int32_t lh = node->subtrees[0]->height;
+    int32_t rh = node->subtrees[1]->height;
+    assert_true(lh - rh <= 1 && rh - lh <= 1);
+    assert_int_equal(node->height, 1 + ((lh > rh) ? lh : rh));
+    size_t n = check_AVL(tree, node->subtrees[0], lo, node->key)
+             + check_AVL(tree, node->subtrees[1], node->key, hi);
+    if (tree->sizes) assert_int_equal(node->size, n);
+    return n;
+}
+
+typedef struct {
+    int *keys;
+    size_t i, n;
+} IntSource;
+
+static bool next_int(void *ctx, void **key, void **data)
+{
+    IntSource *src = ctx;
+    if (src->i == src->n) {
+        return false;
+    }
+    *key = *data = &src->keys[src->i++];
+    return true;
+}
+
+static void TEST_INT_AVL_build_sorted(void **state)
+{
+    CountingCtx ctx = { .nlive = 0 };
+    const Lor_AVL_allocator allocator = {
+        .alloc = counting_alloc,
+        .freenode = counting_free_node,
+        .ctx = &ctx,
+    };
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_allocator(tree, compare_int, &allocator, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_subtree_sizes(tree, true), LOR_SUCCESS);
+
+    static int keys[NTESTS];
+    static void *keyptrs[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) (2 * i);
+        keyptrs[i] = &keys[i];
+    }
+    assert_int_equal(Lor_AVL_build_sorted(tree, keyptrs, keyptrs, 0), LOR_SUCCESS);
+    assert_int_equal(tree->nitems, 0);
+    assert_int_equal(Lor_AVL_build_sorted(tree, keyptrs, keyptrs, (size_t) UINT32_MAX + 1), LOR_MAX_ITEMS_ERR);
+    assert_int_equal(ctx.nlive, 1);
+
+    /* Unsorted input leaves the tree empty, with no node leaked */
+    keys[NTESTS / 2] = keys[NTESTS / 2 - 1];
+    assert_int_equal(Lor_AVL_build_sorted(tree, keyptrs, keyptrs, NTESTS), LOR_UNSORTED_KEYS_ERR);
+    assert_int_equal(ctx.nlive, 1);
+    assert_null(tree->root->subtrees[0]);
+    keys[NTESTS / 2] = NTESTS;
+
+    assert_int_equal(Lor_AVL_build_sorted(tree, keyptrs, keyptrs, NTESTS), LOR_SUCCESS);
+    assert_int_equal(tree->nitems, NTESTS);
+    assert_int_equal(ctx.nlive, 2*NTESTS - 1);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS);
+    assert_int_equal(tree->root->height, 10);  /* ceil(log2(1000)) */
+    assert_int_equal(Lor_AVL_build_sorted(tree, keyptrs, keyptrs, NTESTS), LOR_TREE_NOT_EMPTY_ERR);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        int key = (int) (2 * i);
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, &key);
+        assert_non_null(f);
+        assert_ptr_equal(Lor_AVL_get_data_from_node(f), &keys[i]);
+        key++;
+        assert_null(Lor_AVL_find(tree, &key));
+    }
+
+    /* The built tree is an ordinary AVL tree */
+    static int odd[NTESTS];
+    void *data;
+    for (size_t i = 0; i < NTESTS; i++) {
+        odd[i] = (int) (2 * i + 1);
+        assert_int_equal(Lor_AVL_insert(tree, &odd[i], &odd[i]), LOR_SUCCESS);
+        assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS);
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(ctx.nlive, 0);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+
+    /* Streamed from an iterator, into a pool */
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_pool(tree, compare_int, pool, NULL), LOR_SUCCESS);
+
+    IntSource src = { .keys = odd, .i = 0, .n = NTESTS - 1 };
+    assert_int_equal(Lor_AVL_build_from_iter(tree, next_int, &src, NTESTS), LOR_SRC_EMPTY_WARN);
+    assert_null(tree->root->subtrees[0]);
+    src.i = 0;
+    assert_int_equal(Lor_AVL_build_from_iter(tree, next_int, &src, NTESTS - 1), LOR_SUCCESS);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS - 1);
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVL_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, NTESTS - 1);
+
+    assert_int_equal(Lor_AVL_discard(tree, false), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+/* Items of the set operation tests: the key k is at setkeys[k] */
+static int setkeys[3 * NTESTS];
+
+static Lor_AVL_bst *set_tree(const Lor_AVL_allocator *allocator, size_t first, size_t last, size_t step)
+{
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init_with_allocator(tree, compare_int, allocator, count_free), LOR_SUCCESS);
+    for (size_t k = first; k < last; k += step) {
+        assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    return tree;
+}
+
+/* Release the root of an empty tree, and the tree */
+static void drop_empty_tree(Lor_AVL_bst **tree)
+{
+    assert_null((*tree)->root->subtrees[0]);
+    tree_free_node(*tree, (*tree)->root);
+    (*tree)->root = NULL;
+    assert_int_equal(Lor_AVL_destroy(tree), LOR_SUCCESS);
+}
+
+/* Check that tree holds the keys k of [first, last[ with pred(k) */
+static void check_set_tree(Lor_AVL_bst *tree, size_t first, size_t last, bool (*pred)(size_t))
+{
+    size_t n = 0;
+    for (size_t k = first; k < last; k++) {
+        int key = (int) k;
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, &key);
+        assert_true(!f == !pred(k));
+        n += (f != NULL);
+    }
+    assert_int_equal(tree->nitems, n);
+    if (n) {
+        assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), n);
+        lastmapped = -1;
+        nmapped = 0;
+        assert_int_equal(Lor_AVL_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+        assert_int_equal(nmapped, n);
+    }
+}
+
+static bool is_any(size_t k) { return true; }
+static bool is_even(size_t k) { return k % 2 == 0; }
+static bool is_even_or_mult3(size_t k) { return k % 2 == 0 || k % 3 == 0; }
+static bool is_mult3(size_t k) { return k % 3 == 0; }
+static bool is_mult6(size_t k) { return k % 6 == 0; }
+static bool is_even_not_mult3(size_t k) { return k % 2 == 0 && k % 3 != 0; }
+
+static void TEST_INT_AVL_join_split_sets(void **state)
+{
+    CountingCtx ctx = { .nlive = 0 };
+    const Lor_AVL_allocator allocator = {
+        .alloc = counting_alloc,
+        .freenode = counting_free_node,
+        .ctx = &ctx,
+    };
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+    }
+
+    /* Split in three and join back */
+    Lor_AVL_bst *t1 = set_tree(&allocator, 0, 3 * NTESTS, 1);
+    Lor_AVL_bst *t2 = set_tree(&allocator, 0, 0, 1);
+    Lor_AVL_bst *t3 = set_tree(&allocator, 0, 0, 1);
+    int key = NTESTS;
+    assert_int_equal(Lor_AVL_split(t1, &key, t2), LOR_SUCCESS);
+    key = 2 * NTESTS + 17;
+    assert_int_equal(Lor_AVL_split(t2, &key, t3), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_split(t2, &key, t3), LOR_TREE_NOT_EMPTY_ERR);
+    check_set_tree(t1, 0, NTESTS, is_any);
+    check_set_tree(t2, NTESTS, 2 * NTESTS + 17, is_any);
+    check_set_tree(t3, 2 * NTESTS + 17, 3 * NTESTS, is_any);
+    assert_int_equal(ctx.nlive, 2 * 3 * NTESTS - 3);
+
+    assert_int_equal(Lor_AVL_join(t3, t1), LOR_UNSORTED_KEYS_ERR);
+    /* The subtree sizes hold at most UINT32_MAX items */
+    size_t n1 = t1->nitems;
+    t1->nitems = UINT32_MAX - t2->nitems + 1;
+    assert_int_equal(Lor_AVL_join(t1, t2), LOR_MAX_ITEMS_ERR);
+    assert_int_equal(Lor_AVL_union(t1, t2), LOR_MAX_ITEMS_ERR);
+    t1->nitems = n1;
+    assert_int_equal(Lor_AVL_join(t1, t2), LOR_SUCCESS);
+    check_set_tree(t1, 0, 2 * NTESTS + 17, is_any);
+    assert_int_equal(t2->nitems, 0);
+    assert_int_equal(Lor_AVL_join(t1, t3), LOR_SUCCESS);
+    check_set_tree(t1, 0, 3 * NTESTS, is_any);
+    assert_int_equal(ctx.nlive, 2 * 3 * NTESTS - 1 + 2);
+
+    /* Splits at the ends */
+    key = -1;
+    assert_int_equal(Lor_AVL_split(t1, &key, t2), LOR_SUCCESS);
+    check_set_tree(t2, 0, 3 * NTESTS, is_any);
+    assert_int_equal(t1->nitems, 0);
+    key = 3 * NTESTS;
+    assert_int_equal(Lor_AVL_split(t2, &key, t1), LOR_SUCCESS);
+    check_set_tree(t2, 0, 3 * NTESTS, is_any);
+    assert_int_equal(t1->nitems, 0);
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_clear(t2), LOR_SUCCESS);
+    assert_int_equal(nfreed, 3 * NTESTS);
+    assert_int_equal(Lor_AVL_destroy(&t2), LOR_SUCCESS);
+    drop_empty_tree(&t1);
+
+    /* Union of the even keys and the multiples of 3 */
+    t1 = set_tree(&allocator, 0, 3 * NTESTS, 2);
+    assert_int_equal(Lor_AVL_union(t1, t3), LOR_SUCCESS);  /* t3 is empty */
+    check_set_tree(t1, 0, 3 * NTESTS, is_even);
+    drop_empty_tree(&t3);
+    t3 = set_tree(&allocator, 0, 3 * NTESTS, 3);
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_union(t1, t3), LOR_SUCCESS);
+    assert_int_equal(nfreed, NTESTS / 2);  /* multiples of 6 of t3 */
+    check_set_tree(t1, 0, 3 * NTESTS, is_even_or_mult3);
+    assert_int_equal(t3->nitems, 0);
+    assert_int_equal(ctx.nlive, 2 * t1->nitems - 1 + 1);
+    assert_int_equal(Lor_AVL_clear(t1), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&t1), LOR_SUCCESS);
+
+    /* Intersection and difference, t3 being only read */
+    drop_empty_tree(&t3);
+    t3 = set_tree(&allocator, 0, 3 * NTESTS, 3);
+    t1 = set_tree(&allocator, 0, 3 * NTESTS, 2);
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_intersection(t1, t3), LOR_SUCCESS);
+    check_set_tree(t1, 0, 3 * NTESTS, is_mult6);
+    assert_int_equal(nfreed, 3 * NTESTS / 2 - NTESTS / 2);
+    check_set_tree(t3, 0, 3 * NTESTS, is_mult3);
+    assert_int_equal(Lor_AVL_clear(t1), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&t1), LOR_SUCCESS);
+
+    t1 = set_tree(&allocator, 0, 3 * NTESTS, 2);
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_difference(t1, t3), LOR_SUCCESS);
+    check_set_tree(t1, 0, 3 * NTESTS, is_even_not_mult3);
+    assert_int_equal(nfreed, NTESTS / 2);
+    check_set_tree(t3, 0, 3 * NTESTS, is_mult3);
+
+    /* Intersection down to nothing, difference with an empty tree */
+    Lor_AVL_bst *empty = set_tree(&allocator, 0, 0, 1);
+    assert_int_equal(Lor_AVL_difference(t1, empty), LOR_SUCCESS);
+    check_set_tree(t1, 0, 3 * NTESTS, is_even_not_mult3);
+    assert_int_equal(Lor_AVL_intersection(t1, t3), LOR_SUCCESS);
+    assert_int_equal(t1->nitems, 0);
+    assert_null(t1->root->subtrees[0]);
+    assert_int_equal(ctx.nlive, 2 * t3->nitems - 1 + 2);
+
+    /* Trees of different compare functions cannot be combined */
+    Lor_AVL_bst *other = Lor_AVL_create();
+    assert(other);
+    assert_int_equal(Lor_AVL_init_with_allocator(other, compare_str, &allocator, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_union(t1, other), LOR_INCOMPATIBLE_TREES_ERR);
+    assert_int_equal(Lor_AVL_intersection(t1, other), LOR_INCOMPATIBLE_TREES_ERR);
+
+    assert_int_equal(Lor_AVL_clear(t3), LOR_SUCCESS);
+    drop_empty_tree(&t1);
+    drop_empty_tree(&empty);
+    drop_empty_tree(&other);
+    assert_int_equal(ctx.nlive, 0);
+    assert_int_equal(Lor_AVL_destroy(&t3), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_order_statistics(void **state)
+{
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+
+    int key = 0, b = 10;
+    size_t n;
+    Lor_AVL_bst_node *f;
+    /* The sizes are kept only on request */
+    assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_NO_SUBTREE_SIZES_ERR);
+    assert_int_equal(Lor_AVL_select(tree, 0, &f), LOR_NO_SUBTREE_SIZES_ERR);
+    assert_int_equal(Lor_AVL_count_range(tree, &key, &b, &n), LOR_NO_SUBTREE_SIZES_ERR);
+    assert_int_equal(Lor_AVL_insert(tree, &key, &key), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_subtree_sizes(tree, true), LOR_TREE_NOT_EMPTY_ERR);
+    void *data;
+    assert_int_equal(Lor_AVL_delete(tree, &key, &data), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_subtree_sizes(tree, true), LOR_SUCCESS);
+
+    assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_SUCCESS);
+    assert_int_equal(n, 0);
+    assert_int_equal(Lor_AVL_select(tree, 0, &f), LOR_SUCCESS);
+    assert_null(f);
+    assert_int_equal(Lor_AVL_count_range(tree, &key, &b, &n), LOR_SUCCESS);
+    assert_int_equal(n, 0);
+
+    /* Keys 0, 3, 6, ... inserted out of order */
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) (3 * ((i * 7919) % NTESTS));
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS);
+
+    for (size_t i = 0; i < NTESTS; i++) {
+        assert_int_equal(Lor_AVL_select(tree, i, &f), LOR_SUCCESS);
+        assert_non_null(f);
+        assert_int_equal(*(int *) Lor_AVL_get_data_from_node(f), 3 * i);
+        key = (int) (3 * i);
+        assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_SUCCESS);
+        assert_int_equal(n, i);
+        key++;
+        assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_SUCCESS);
+        assert_int_equal(n, i + 1);
+    }
+    assert_int_equal(Lor_AVL_select(tree, NTESTS, &f), LOR_SUCCESS);
+    assert_null(f);
+    key = -5;
+    b = 3 * NTESTS + 5;
+    assert_int_equal(Lor_AVL_count_range(tree, &key, &b, &n), LOR_SUCCESS);
+    assert_int_equal(n, NTESTS);
+    key = 10;
+    b = 31;  /* 12, 15, ..., 30 */
+    assert_int_equal(Lor_AVL_count_range(tree, &key, &b, &n), LOR_SUCCESS);
+    assert_int_equal(n, 7);
+    assert_int_equal(Lor_AVL_count_range(tree, &b, &key, &n), LOR_SUCCESS);
+    assert_int_equal(n, 0);
+
+    /* The sizes follow the deletions and their rotations */
+    for (size_t i = 0; i < NTESTS; i += 2) {
+        assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS / 2);
+    for (size_t i = 0; i < NTESTS / 2; i++) {
+        assert_int_equal(Lor_AVL_select(tree, i, &f), LOR_SUCCESS);
+        key = *(int *) Lor_AVL_get_data_from_node(f);
+        assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_SUCCESS);
+        assert_int_equal(n, i);
+    }
+
+    /* And the joins of the set operations, between trees that both keep
+     * the sizes */
+    Lor_AVL_bst *ge = Lor_AVL_create();
+    assert(ge);
+    assert_int_equal(Lor_AVL_init(ge, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    key = 3 * NTESTS / 2;
+    assert_int_equal(Lor_AVL_split(tree, &key, ge), LOR_INCOMPATIBLE_TREES_ERR);
+    assert_int_equal(Lor_AVL_set_subtree_sizes(ge, true), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_split(tree, &key, ge), LOR_SUCCESS);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), tree->nitems);
+    assert_int_equal(check_AVL(ge, ge->root, NULL, NULL), ge->nitems);
+    assert_int_equal(Lor_AVL_rank(ge, &key, &n), LOR_SUCCESS);
+    assert_int_equal(n, 0);
+    assert_int_equal(Lor_AVL_rank(tree, &key, &n), LOR_SUCCESS);
+    assert_int_equal(n, tree->nitems);
+    assert_int_equal(Lor_AVL_join(tree, ge), LOR_SUCCESS);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS / 2);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+    free(ge->root);
+    ge->root = NULL;
+    assert_int_equal(Lor_AVL_destroy(&ge), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_cursor(void **state)
+{
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+
+    int key = 7;
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+    assert_null(Lor_AVL_cursor_first(&cur));
+    assert_null(Lor_AVL_cursor_last(&cur));
+    assert_null(Lor_AVL_cursor_lower_bound(&cur, &key));
+    assert_null(Lor_AVL_cursor_floor(&cur, &key));
+    assert_null(Lor_AVL_cursor_next(&cur));
+
+    /* Keys 0, 3, 6, ... inserted out of order, every other one deleted
+     * after, so that some separators are stale */
+    static int keys[NTESTS];
+    for (size_t i = 0; i < NTESTS; i++) {
+        keys[i] = (int) (3 * ((i * 7919) % NTESTS));
+        assert_int_equal(Lor_AVL_insert(tree, &keys[i], &keys[i]), LOR_SUCCESS);
+    }
+    void *data;
+    for (size_t i = 0; i < NTESTS; i++) {
+        if (keys[i] % 2) {
+            assert_int_equal(Lor_AVL_delete(tree, &keys[i], &data), LOR_SUCCESS);
+        }
+    }
+    /* Left: 0, 6, 12, ..., 6 * (NTESTS / 2 - 1) */
+    const int maxkey = 6 * (NTESTS / 2 - 1);
+
+    int expected = 0;
+    for (Lor_AVL_bst_node *p = Lor_AVL_cursor_first(&cur); p; p = Lor_AVL_cursor_next(&cur)) {
+        assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), expected);
+        expected += 6;
+    }
+    assert_int_equal(expected, maxkey + 6);
+    for (Lor_AVL_bst_node *p = Lor_AVL_cursor_last(&cur); p; p = Lor_AVL_cursor_prev(&cur)) {
+        expected -= 6;
+        assert_int_equal(*(int *) Lor_AVL_get_data_from_node(p), expected);
+    }
+    assert_int_equal(expected, 0);
+
+    for (key = -2; key <= maxkey + 2; key++) {
+        int up = (key < 0) ? 0 : (key / 6 + 1) * 6;
+        int low = (key >= 0 && key % 6 == 0) ? key : up;
+        int fl = (key < 0) ? -1 : (key / 6) * 6;
+        if (fl > maxkey) {
+            fl = maxkey;
+        }
+
+        Lor_AVL_bst_node *p = Lor_AVL_cursor_lower_bound(&cur, &key);
+        if (low > maxkey) {
+            assert_null(p);
+        }
+        else {
+            assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), low);
+            p = Lor_AVL_cursor_prev(&cur);
+            if (low == 0) {
+                assert_null(p);
+            }
+            else {
+                assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), low - 6);
+            }
+        }
+        assert_ptr_equal(Lor_AVL_cursor_ceiling(&cur, &key), Lor_AVL_cursor_lower_bound(&cur, &key));
+
+        p = Lor_AVL_cursor_upper_bound(&cur, &key);
+        if (up > maxkey) {
+            assert_null(p);
+        }
+        else {
+            assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), up);
+        }
+
+        p = Lor_AVL_cursor_floor(&cur, &key);
+        if (fl < 0) {
+            assert_null(p);
+        }
+        else {
+            assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), fl);
+            p = Lor_AVL_cursor_next(&cur);
+            if (fl == maxkey) {
+                assert_null(p);
+            }
+            else {
+                assert_int_equal(*(int *) Lor_AVL_get_key_from_node(p), fl + 6);
+            }
+        }
+    }
+
+    /* The interval list comes in increasing key order */
+    key = 10;
+    int b = 40;  /* 12, 18, 24, 30, 36 */
+    Lor_AVL_bst_node *list = Lor_AVL_interval_find(tree, &key, &b);
+    expected = 12;
+    for (Lor_AVL_bst_node *p = list; p; p = p->subtrees[1]) {
+        assert_int_equal(*(int *) p->subtrees[0], expected);
+        expected += 6;
+    }
+    assert_int_equal(expected, 42);
+    Lor_AVL_clear_node_list(tree, list);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+}
+
+/* Check the leaf threads of tree against an in order walk */
+static void check_threads(Lor_AVL_bst *tree)
+{
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+
+    size_t n = 0;
+    Lor_AVL_bst_node *prev = NULL;
+    for (Lor_AVL_bst_node *p = Lor_AVL_cursor_first(&cur); p; p = Lor_AVL_cursor_next(&cur)) {
+        assert_ptr_equal(Lor_AVL_predecessor(tree, p), prev);
+        if (prev) {
+            assert_ptr_equal(Lor_AVL_successor(tree, prev), p);
+        }
+        prev = p;
+        n++;
+    }
+    if (prev) {
+        assert_null(Lor_AVL_successor(tree, prev));
+    }
+    assert_int_equal(n, tree->nitems);
+}
+
+static void TEST_INT_AVL_leaf_threads(void **state)
+{
+    CountingCtx ctx = { .nlive = 0, .nodesize = 0 };
+    const Lor_AVL_allocator allocator = {
+        .alloc = counting_alloc,
+        .freenode = counting_free_node,
+        .ctx = &ctx,
+    };
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+    }
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_leaf_threads(tree, true), LOR_SUCCESS);
+    check_threads(tree);
+
+    /* Threads kept by insert and delete */
+    for (size_t i = 0; i < NTESTS; i++) {
+        size_t k = (i * 7919) % NTESTS;
+        assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_AVL_set_leaf_threads(tree, false), LOR_TREE_NOT_EMPTY_ERR);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS);
+    check_threads(tree);
+
+    void *data;
+    for (size_t k = 0; k < NTESTS; k += 3) {
+        assert_int_equal(Lor_AVL_delete(tree, &setkeys[k], &data), LOR_SUCCESS);
+    }
+    check_threads(tree);
+    int key = 100;
+    Lor_AVL_bst_node *p = Lor_AVL_find(tree, &key);
+    assert_non_null(p);
+    assert_int_equal(*(int *) Lor_AVL_get_key_from_node(Lor_AVL_successor(tree, p)), 101);
+    assert_int_equal(*(int *) Lor_AVL_get_key_from_node(Lor_AVL_predecessor(tree, p)), 98);
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVL_traverse_lr(tree, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, tree->nitems);
+
+    /* Down to one item and back */
+    for (size_t k = 0; k < NTESTS; k++) {
+        if (k % 3 && k != 500) {
+            assert_int_equal(Lor_AVL_delete(tree, &setkeys[k], &data), LOR_SUCCESS);
+        }
+    }
+    check_threads(tree);
+    assert_int_equal(Lor_AVL_insert(tree, &setkeys[7], &setkeys[7]), LOR_SUCCESS);
+    check_threads(tree);
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+
+    /* Without threads, the same answers by a descent */
+    tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    for (size_t k = 0; k < NTESTS; k += 2) {
+        assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    check_threads(tree);
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+
+    /* Bulk build, join, split and set operations */
+    void *keys[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        keys[k] = &setkeys[k];
+    }
+    Lor_AVL_bst *t[3];
+    for (size_t i = 0; i < 3; i++) {
+        t[i] = Lor_AVL_create();
+        assert(t[i]);
+        assert_int_equal(Lor_AVL_init_with_allocator(t[i], compare_int, &allocator, NULL), LOR_SUCCESS);
+        assert_int_equal(Lor_AVL_set_leaf_threads(t[i], true), LOR_SUCCESS);
+    }
+    ctx.nodesize = sizeof(Lor_AVL_threaded_node);  /* the plain roots are freed */
+    assert_int_equal(Lor_AVL_build_sorted(t[0], keys, keys, 3 * NTESTS), LOR_SUCCESS);
+    check_threads(t[0]);
+
+    key = NTESTS;
+    assert_int_equal(Lor_AVL_split(t[0], &key, t[1]), LOR_SUCCESS);
+    key = NTESTS + 1;
+    assert_int_equal(Lor_AVL_split(t[1], &key, t[2]), LOR_SUCCESS);  /* t[1] holds one key */
+    check_threads(t[0]);
+    check_threads(t[1]);
+    check_threads(t[2]);
+    assert_int_equal(Lor_AVL_join(t[1], t[2]), LOR_SUCCESS);
+    check_threads(t[1]);
+    assert_int_equal(Lor_AVL_join(t[0], t[1]), LOR_SUCCESS);
+    check_threads(t[0]);
+    assert_int_equal(t[0]->nitems, 3 * NTESTS);
+
+    for (size_t k = 0; k < 3 * NTESTS; k += 3) {
+        assert_int_equal(Lor_AVL_insert(t[1], &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    for (size_t k = 0; k < 3 * NTESTS; k += 2) {
+        assert_int_equal(Lor_AVL_delete(t[0], &setkeys[k], &data), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_AVL_union(t[0], t[1]), LOR_SUCCESS);
+    check_threads(t[0]);
+    for (size_t k = 0; k < 3 * NTESTS; k += 2) {
+        assert_int_equal(Lor_AVL_insert(t[1], &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_AVL_intersection(t[1], t[0]), LOR_SUCCESS);
+    check_threads(t[1]);
+    assert_int_equal(t[1]->nitems, NTESTS / 2);  /* multiples of 6 */
+    assert_int_equal(Lor_AVL_difference(t[0], t[1]), LOR_SUCCESS);
+    check_threads(t[0]);
+    assert_int_equal(t[0]->nitems, 3 * NTESTS / 2);  /* odd keys */
+
+    /* Unions threading runs of t2 before, between and after the leafs of t1,
+     * into an empty tree and with equal keys */
+    assert_int_equal(Lor_AVL_union(t[2], t[1]), LOR_SUCCESS);
+    check_threads(t[2]);
+    size_t nunion = NTESTS / 2;
+    for (size_t k = 0; k < 3 * NTESTS; k += 2) {
+        if (k < NTESTS / 2 || (k > NTESTS && k % 16 < 6) || k > 5 * NTESTS / 2) {
+            assert_int_equal(Lor_AVL_insert(t[1], &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+            nunion += (k % 6 != 0);
+        }
+    }
+    assert_int_equal(Lor_AVL_union(t[2], t[1]), LOR_SUCCESS);
+    check_threads(t[2]);
+    assert_int_equal(t[2]->nitems, nunion);
+    assert_int_equal(Lor_AVL_union(t[2], t[0]), LOR_SUCCESS);
+    check_threads(t[2]);
+    assert_int_equal(t[2]->nitems, nunion + 3 * NTESTS / 2);
+    assert_int_equal(Lor_AVL_union(t[0], t[2]), LOR_SUCCESS);
+    check_threads(t[0]);
+    assert_int_equal(t[0]->nitems, nunion + 3 * NTESTS / 2);
+
+    /* A tree with threads and one without cannot be combined */
+    Lor_AVL_bst *plain = set_tree(&allocator, 0, 0, 1);
+    assert_int_equal(Lor_AVL_join(t[0], plain), LOR_INCOMPATIBLE_TREES_ERR);
+
+    ctx.nodesize = 0;
+    drop_empty_tree(&plain);
+    ctx.nodesize = sizeof(Lor_AVL_threaded_node);
+    assert_int_equal(Lor_AVL_clear(t[0]), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&t[0]), LOR_SUCCESS);
+    drop_empty_tree(&t[1]);
+    drop_empty_tree(&t[2]);
+    assert_int_equal(ctx.nlive, 0);
+}
+
+/* Summary of the range aggregate tests: first and last keep the order */
+typedef struct {
+    size_t count;
+    long sum;          /* of the data */
+    int max;           /* of the data */
+    int first, last;   /* keys */
+} IntSummary;
+
+static const IntSummary int_summary_identity = { .count = 0, .sum = 0, .max = INT32_MIN };
+
+static void int_summarize(void *summary, const void *key, const void *data)
+{
+    *(IntSummary *) summary = (IntSummary){ .count = 1,
+                                            .sum = *(const int *) data,
+                                            .max = *(const int *) data,
+                                            .first = *(const int *) key,
+                                            .last = *(const int *) key,
+                                      };
+}
+
+static void int_combine(void *summary, const void *left, const void *right)
+{
+    const IntSummary *l = left, *r = right;
+    IntSummary res = { .count = l->count + r->count,
+                       .sum = l->sum + r->sum,
+                       .max = (l->max > r->max) ? l->max : r->max,
+                       .first = (l->count) ? l->first : r->first,
+                       .last = (r->count) ? r->last : l->last,
+                 };
+    *(IntSummary *) summary = res;
+}
+
+/* Check the aggregate of [a, b[ against values[k] for the keys k present */
+static void check_aggregate(Lor_AVL_bst *tree, const int *values, const bool *present, int a, int b)
+{
+    IntSummary expected = int_summary_identity, got;
+    for (int k = (a < 0) ? 0 : a; k < b && k < 3 * NTESTS; k++) {
+        if (present[k]) {
+            IntSummary one;
+            int_summarize(&one, &setkeys[k], &values[k]);
+            int_combine(&expected, &expected, &one);
+        }
+    }
+    Lor_AVL_range_aggregate(tree, &a, &b, &got);
+    assert_int_equal(got.count, expected.count);
+    assert_int_equal(got.sum, expected.sum);
+    assert_int_equal(got.max, expected.max);
+    if (expected.count) {
+        assert_int_equal(got.first, expected.first);
+        assert_int_equal(got.last, expected.last);
+    }
+}
+
+static void TEST_INT_AVL_range_aggregate(void **state)
+{
+    static int values[3 * NTESTS], values2[3 * NTESTS];
+    static bool present[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+        values[k] = (int) ((k * 7919) % 1009);
+        values2[k] = -values[k];
+        present[k] = false;
+    }
+    const Lor_AVL_augmentation aug = {
+        .size = sizeof(IntSummary),
+        .summarize = int_summarize,
+        .combine = int_combine,
+        .identity = &int_summary_identity,
+    };
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_augmentation(tree, &aug), LOR_SUCCESS);
+    check_aggregate(tree, values, present, 0, 10);
+
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        size_t k = (i * 7919) % (3 * NTESTS);
+        if (k % 4) {
+            assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &values[k]), LOR_SUCCESS);
+            present[k] = true;
+        }
+    }
+    assert_int_equal(Lor_AVL_set_augmentation(tree, NULL), LOR_TREE_NOT_EMPTY_ERR);
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), tree->nitems);
+    int bounds[][2] = { { -5, 3 * NTESTS + 5 }, { 0, 1 }, { 4, 5 }, { 17, 18 }, { 10, 990 },
+                        { 1234, 2345 }, { 2999, 3000 }, { 500, 500 }, { 700, 600 } };
+    for (size_t i = 0; i < sizeof bounds / sizeof bounds[0]; i++) {
+        check_aggregate(tree, values, present, bounds[i][0], bounds[i][1]);
+    }
+
+    /* No limits: the summary of the whole tree */
+    IntSummary all;
+    Lor_AVL_range_aggregate(tree, NULL, NULL, &all);
+    assert_int_equal(all.count, tree->nitems);
+    assert_int_equal(all.first, 1);
+    assert_int_equal(all.last, 3 * NTESTS - 1);
+
+    /* Deletions and data updates */
+    void *data;
+    for (size_t k = 0; k < 3 * NTESTS; k += 3) {
+        if (present[k]) {
+            assert_int_equal(Lor_AVL_delete(tree, &setkeys[k], &data), LOR_SUCCESS);
+            present[k] = false;
+        }
+    }
+#ifndef LOR_AVL_ONLY_DISTINCT_KEYS
+    for (size_t k = 1; k < 3 * NTESTS; k += 5) {
+        if (present[k]) {
+            assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &values2[k]), LOR_SUCCESS);
+            values[k] = values2[k];
+        }
+    }
+#endif
+    for (size_t i = 0; i < sizeof bounds / sizeof bounds[0]; i++) {
+        check_aggregate(tree, values, present, bounds[i][0], bounds[i][1]);
+    }
+    for (int a = 0; a < 3 * NTESTS; a += 97) {
+        check_aggregate(tree, values, present, a, a + 211);
+    }
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+
+    /* Bulk build, split and join, with leaf threads */
+    void *keys[3 * NTESTS], *vals[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        keys[k] = &setkeys[k];
+        vals[k] = &values[k];
+        present[k] = true;
+    }
+    Lor_AVL_bst *t[2];
+    for (size_t i = 0; i < 2; i++) {
+        t[i] = Lor_AVL_create();
+        assert(t[i]);
+        assert_int_equal(Lor_AVL_init(t[i], compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+        assert_int_equal(Lor_AVL_set_leaf_threads(t[i], true), LOR_SUCCESS);
+        assert_int_equal(Lor_AVL_set_augmentation(t[i], &aug), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_AVL_build_sorted(t[0], keys, vals, 3 * NTESTS), LOR_SUCCESS);
+    check_aggregate(t[0], values, present, 100, 2900);
+    int key = 1500;
+    assert_int_equal(Lor_AVL_split(t[0], &key, t[1]), LOR_SUCCESS);
+    check_aggregate(t[0], values, present, -1, 1500);
+    check_aggregate(t[1], values, present, 1500, 3 * NTESTS);
+    assert_int_equal(Lor_AVL_join(t[0], t[1]), LOR_SUCCESS);
+    check_threads(t[0]);
+    for (int a = 0; a < 3 * NTESTS; a += 101) {
+        check_aggregate(t[0], values, present, a, a + 1009);
+    }
+
+    assert_int_equal(Lor_AVL_clear(t[0]), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&t[0]), LOR_SUCCESS);
+    drop_empty_tree(&t[1]);
+}
+
+static bool in_0_10(size_t k) { return k >= 10; }
+static bool in_0_10_500_1500(size_t k) { return k >= 10 && (k < 500 || k >= 1500); }
+static bool in_0_10_500_1500_2990_(size_t k) { return in_0_10_500_1500(k) && k < 2990; }
+static bool in_only_700(size_t k) { return k == 700; }
+
+static void TEST_INT_AVL_delete_range(void **state)
+{
+    CountingCtx ctx = { .nlive = 0, .nodesize = 0 };
+    const Lor_AVL_allocator allocator = {
+        .alloc = counting_alloc,
+        .freenode = counting_free_node,
+        .ctx = &ctx,
+    };
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+    }
+
+    Lor_AVL_bst *tree = set_tree(&allocator, 0, 3 * NTESTS, 1);
+    int a = 0, b = 10;
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, &b, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, 10);
+    check_set_tree(tree, 0, 3 * NTESTS, in_0_10);
+    assert_int_equal(ctx.nlive, 2 * tree->nitems - 1);
+
+    a = 500;
+    b = 1500;
+    lastmapped = -1;
+    nmapped = 0;
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, &b, check_increasing), LOR_SUCCESS);
+    assert_int_equal(nmapped, 1000);
+    assert_int_equal(lastmapped, 1499);
+    check_set_tree(tree, 0, 3 * NTESTS, in_0_10_500_1500);
+
+    /* Empty ranges, with or without keys around */
+    assert_int_equal(Lor_AVL_delete_range(tree, &b, &a, check_increasing), LOR_SUCCESS);
+    a = 600;
+    b = 1400;
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, &b, check_increasing), LOR_SUCCESS);
+    check_set_tree(tree, 0, 3 * NTESTS, in_0_10_500_1500);
+
+    /* Open ended, the data released with freedata */
+    a = 2990;
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(nfreed, 10);
+    check_set_tree(tree, 0, 3 * NTESTS, in_0_10_500_1500_2990_);
+    assert_int_equal(ctx.nlive, 2 * tree->nitems - 1);
+    nfreed = 0;
+    assert_int_equal(Lor_AVL_delete_range(tree, NULL, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(nfreed, 3 * NTESTS - 10 - 1000 - 10);
+    assert_int_equal(tree->nitems, 0);
+    assert_null(tree->root->subtrees[0]);
+    assert_int_equal(Lor_AVL_delete_range(tree, NULL, NULL, NULL), LOR_SUCCESS);
+    drop_empty_tree(&tree);
+    assert_int_equal(ctx.nlive, 0);
+
+    /* With leaf threads and summaries, down to a single leaf */
+    static int values[3 * NTESTS];
+    static bool present[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        values[k] = (int) k;
+        present[k] = (k == 700);
+    }
+    const Lor_AVL_augmentation aug = {
+        .size = sizeof(IntSummary),
+        .summarize = int_summarize,
+        .combine = int_combine,
+        .identity = &int_summary_identity,
+    };
+    tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_leaf_threads(tree, true), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_augmentation(tree, &aug), LOR_SUCCESS);
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &values[k]), LOR_SUCCESS);
+    }
+    a = 701;
+    b = 2000;
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, &b, NULL), LOR_SUCCESS);
+    check_threads(tree);
+    assert_int_equal(Lor_AVL_delete_range(tree, NULL, &setkeys[700], NULL), LOR_SUCCESS);
+    check_threads(tree);
+    assert_int_equal(Lor_AVL_delete_range(tree, &a, NULL, NULL), LOR_SUCCESS);
+    check_threads(tree);
+    check_set_tree(tree, 0, 3 * NTESTS, in_only_700);
+    check_aggregate(tree, values, present, 0, 3 * NTESTS);
+    assert_int_equal(Lor_AVL_insert(tree, &setkeys[5], &values[5]), LOR_SUCCESS);
+    present[5] = true;
+    check_threads(tree);
+    check_aggregate(tree, values, present, 0, 3 * NTESTS);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_find_batch(void **state)
+{
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+    }
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+
+    /* Keys in any order, about one in three on tree, n not a multiple of
+     * the group */
+    const size_t n = 3 * NTESTS - 7;
+    const void *keys[3 * NTESTS];
+    Lor_AVL_bst_node *out[3 * NTESTS];
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = &setkeys[(i * 7919) % (3 * NTESTS)];
+    }
+    assert_int_equal(Lor_AVL_find_batch(tree, keys, n, out), 0);
+    for (size_t i = 0; i < n; i++) {
+        assert_null(out[i]);
+    }
+    assert_int_equal(Lor_AVL_insert(tree, &setkeys[42], &setkeys[42]), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_find_batch(tree, keys, n, out), 1);
+
+    for (size_t k = 0; k < 3 * NTESTS; k += 3) {
+        assert_int_equal(Lor_AVL_insert(tree, &setkeys[k], &setkeys[k]), LOR_SUCCESS);
+    }
+    size_t nfound = Lor_AVL_find_batch(tree, keys, n, out);
+    size_t expected = 0;
+    for (size_t i = 0; i < n; i++) {
+        Lor_AVL_bst_node *f = Lor_AVL_find(tree, keys[i]);
+        assert_ptr_equal(out[i], f);
+        expected += (f != NULL);
+    }
+    assert_int_equal(nfound, expected);
+    assert_true(nfound > n / 3 - LOR_AVL_FIND_BATCH_GROUP);
+    assert_int_equal(Lor_AVL_find_batch(tree, keys, 0, out), 0);
+    assert_int_equal(Lor_AVL_find_batch(tree, keys + 1, 1, out), Lor_AVL_find(tree, keys[1]) != NULL);
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+}
+
+static void TEST_INT_AVL_finger_search(void **state)
+{
+    static int values[3 * NTESTS];
+    static bool present[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        setkeys[k] = (int) k;
+        values[k] = (int) k;
+        present[k] = false;
+    }
+    const Lor_AVL_augmentation aug = {
+        .size = sizeof(IntSummary),
+        .summarize = int_summarize,
+        .combine = int_combine,
+        .identity = &int_summary_identity,
+    };
+
+    Lor_AVL_bst *tree = Lor_AVL_create();
+    assert(tree);
+    assert_int_equal(Lor_AVL_init(tree, compare_int, alloc, NULL, NULL), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_leaf_threads(tree, true), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_set_augmentation(tree, &aug), LOR_SUCCESS);
+
+    /* Increasing, then decreasing, then random keys, from the same cursor */
+    Lor_AVL_cursor cur;
+    Lor_AVL_cursor_init(&cur, tree);
+    for (size_t k = 0; k < 3 * NTESTS; k += 3) {
+        assert_int_equal(Lor_AVL_cursor_insert(&cur, &setkeys[k], &values[k]), LOR_SUCCESS);
+        assert_ptr_equal(Lor_AVL_get_key_from_node(cur.leaf), &setkeys[k]);
+        present[k] = true;
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), NTESTS);
+    for (size_t k = 3 * NTESTS - 2; k < 3 * NTESTS; k -= 3) {
+        assert_int_equal(Lor_AVL_cursor_insert(&cur, &setkeys[k], &values[k]), LOR_SUCCESS);
+        assert_ptr_equal(Lor_AVL_get_key_from_node(cur.leaf), &setkeys[k]);
+        present[k] = true;
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), 2 * NTESTS);
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        size_t k = (i * 7919) % (3 * NTESTS);
+        assert_int_equal(Lor_AVL_cursor_insert(&cur, &setkeys[k], &values[k]), LOR_SUCCESS);
+        assert_ptr_equal(Lor_AVL_get_data_from_node(cur.leaf), &values[k]);
+        present[k] = true;
+    }
+    assert_int_equal(check_AVL(tree, tree->root, NULL, NULL), 3 * NTESTS);
+    check_threads(tree);
+    check_aggregate(tree, values, present, 0, 3 * NTESTS);
+    check_aggregate(tree, values, present, 1000, 2000);
+
+    /* Finger searches: sorted, backwards, random, and absent keys */
+    void *data;
+    for (size_t k = 0; k < 3 * NTESTS; k += 4) {
+        assert_int_equal(Lor_AVL_delete(tree, &setkeys[k], &data), LOR_SUCCESS);
+    }
+    Lor_AVL_cursor_init(&cur, tree);
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        assert_ptr_equal(Lor_AVL_cursor_find(&cur, &setkeys[k]), Lor_AVL_find(tree, &setkeys[k]));
+    }
+    for (size_t k = 3 * NTESTS; k--; ) {
+        assert_ptr_equal(Lor_AVL_cursor_find(&cur, &setkeys[k]), Lor_AVL_find(tree, &setkeys[k]));
+    }
+    int outside[] = { -10, 3 * NTESTS + 10 };
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        size_t k = (i * 7919) % (3 * NTESTS);
+        assert_ptr_equal(Lor_AVL_cursor_find(&cur, &setkeys[k]), Lor_AVL_find(tree, &setkeys[k]));
+        assert_null(Lor_AVL_cursor_find(&cur, &outside[i % 2]));
+    }
+
+    /* Sorted batch, and unsorted keys give the same as Lor_AVL_find_batch */
+    const void *keys[3 * NTESTS];
+    Lor_AVL_bst_node *out[3 * NTESTS], *out2[3 * NTESTS];
+    for (size_t k = 0; k < 3 * NTESTS; k++) {
+        keys[k] = &setkeys[k];
+    }
+    assert_int_equal(Lor_AVL_find_sorted_batch(tree, keys, 3 * NTESTS, out), tree->nitems);
+    assert_int_equal(Lor_AVL_find_batch(tree, keys, 3 * NTESTS, out2), tree->nitems);
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        assert_ptr_equal(out[i], out2[i]);
+    }
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        keys[i] = &setkeys[(i * 7919) % (3 * NTESTS)];
+    }
+    assert_int_equal(Lor_AVL_find_sorted_batch(tree, keys, 3 * NTESTS, out), tree->nitems);
+    assert_int_equal(Lor_AVL_find_batch(tree, keys, 3 * NTESTS, out2), tree->nitems);
+    for (size_t i = 0; i < 3 * NTESTS; i++) {
+        assert_ptr_equal(out[i], out2[i]);
+    }
+
+    assert_int_equal(Lor_AVL_clear(tree), LOR_SUCCESS);
+    assert_int_equal(Lor_AVL_destroy(&tree), LOR_SUCCESS);
+}
 
 static int setup(void **state)
 {
@@ -509,6 +2411,27 @@ int main(int argc, char *argv[])
         cmocka_unit_test(TEST_USER_DEF_TYPE_insert),
         cmocka_unit_test(TEST_USER_DEF_TYPE_interval_find),
         cmocka_unit_test(TEST_USER_DEF_TYPE_delete),
+        cmocka_unit_test(TEST_INT_AVL_allocator_ctx),
+        cmocka_unit_test(TEST_INT_AVL_pool_churn),
+        cmocka_unit_test(TEST_INT_AVL_discard),
+        cmocka_unit_test(TEST_INT_AVL_node_alignment),
+        cmocka_unit_test(TEST_INT_AVL_pool_trim),
+        cmocka_unit_test(TEST_INT_AVLp_file),
+        cmocka_unit_test(TEST_STR_AVL_interned_keys),
+        cmocka_unit_test(TEST_INT_AVLn_insert_delete),
+        cmocka_unit_test(TEST_INT_AVLn_interval_pool),
+        cmocka_unit_test(TEST_INT_AVLc_insert_delete),
+        cmocka_unit_test(TEST_AVLgen_typed_keys),
+        cmocka_unit_test(TEST_AVLi_intrusive_records),
+        cmocka_unit_test(TEST_INT_AVL_build_sorted),
+        cmocka_unit_test(TEST_INT_AVL_join_split_sets),
+        cmocka_unit_test(TEST_INT_AVL_order_statistics),
+        cmocka_unit_test(TEST_INT_AVL_cursor),
+        cmocka_unit_test(TEST_INT_AVL_leaf_threads),
+        cmocka_unit_test(TEST_INT_AVL_range_aggregate),
+        cmocka_unit_test(TEST_INT_AVL_delete_range),
+        cmocka_unit_test(TEST_INT_AVL_find_batch),
+        cmocka_unit_test(TEST_INT_AVL_finger_search),
     };
     return cmocka_run_group_tests(tests, setup, tear_down);
 }
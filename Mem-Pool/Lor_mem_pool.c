@@ -10,15 +10,161 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
-
-#define USIZE_OVERFLOW_MSG(a, b, func)                                                                             \
-    fprintf(stderr, "[%s:%s:%lu]: [OVERFLOW]: size_t overflow encountered at: %"PRIuMAX" + %"PRIuMAX"\n", \
-                __FILE__, func, __LINE__+0UL, (uintmax_t) (a), (uintmax_t) (b));
-
+#include <sys/mman.h>
+#include <unistd.h>
 
 static size_t __st_add(jmp_buf, size_t, size_t);
 static size_t __st_mult(jmp_buf, size_t, size_t);
 
+/**********************************************************
+ * Map at least 'size' bytes for a block.  With huge pages,
+ * MAP_HUGETLB is tried first;  if the system has no huge
+ * pages reserved, fall back to a regular mapping aligned to
+ * the huge page size and advise the kernel to back it with
+ * transparent huge pages.
+ **********************************************************/
+static mem_pool_block *__mem_pool_map_block(size_t size, unsigned flags, size_t *mapsize)
+{
+    size_t pagesize = (flags & LOR_MEM_POOL_HUGEPAGES) ? HUGE_PAGE_SIZE
+                                                       : (size_t) sysconf(_SC_PAGESIZE);
+    if (UNSIGNED_ADD_OVERFLOWS(size, pagesize)) {
+        USIZE_OVERFLOW_MSG(size, pagesize, __func__);
+        return NULL;
+    }
+    size_t len = (size + pagesize - 1) & ~(pagesize - 1);
+
+    int mapflags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if (flags & LOR_MEM_POOL_POPULATE) {
+        mapflags |= MAP_POPULATE;
+    }
+#endif
+
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (flags & LOR_MEM_POOL_HUGEPAGES) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, mapflags | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (p == MAP_FAILED && (flags & LOR_MEM_POOL_HUGEPAGES) && !UNSIGNED_ADD_OVERFLOWS(len, pagesize)) {
+        /* Over-map so the block can start on a huge page boundary */
+        char *q = mmap(NULL, len + pagesize, PROT_READ | PROT_WRITE, mapflags, -1, 0);
+        if (q != MAP_FAILED) {
+            char *aligned = (char *) (((uintptr_t) q + pagesize - 1) & ~(uintptr_t) (pagesize - 1));
+            if (aligned > q) {
+                munmap(q, aligned - q);
+            }
+            if (aligned + len < q + len + pagesize) {
+                munmap(aligned + len, (q + len + pagesize) - (aligned + len));
+            }
+            p = aligned;
+#ifdef MADV_HUGEPAGE
+            madvise(p, len, MADV_HUGEPAGE);
+#endif
+        }
+    }
+    else if (p == MAP_FAILED) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, mapflags, -1, 0);
+    }
+    if (p == MAP_FAILED) {
+        LOR_PERROR("mmap failed", __func__);
+        return NULL;
+    }
+
+    *mapsize = len;
+    return p;
+}
+
+static void __mem_pool_free_block(mem_pool_block *block)
+{
+    if (block->mapsize) {
+        munmap(block, block->mapsize);
+    }
+    else {
+        free(block);
+    }
+}
+
+/**********************************************************
+ * Position in the block index of the first range  starting
+ * after 'addr'.
+ **********************************************************/
+static size_t __mem_pool_index_upper(const Lor_mem_pool *pool, uintptr_t addr)
+{
+    size_t lo = 0, hi = pool->nblocks;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (pool->index[mid].start <= addr) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**********************************************************
+ * Insert the range of 'block' in the block index  of  the
+ * pool, keeping it sorted. Returns false if the index could
+ * not grow.
+ **********************************************************/
+static bool __mem_pool_index_insert(Lor_mem_pool *pool, mem_pool_block *block)
+{
+    if (pool->nblocks == pool->indexalloc) {
+        size_t newalloc = (pool->indexalloc) ? 2 * pool->indexalloc : 8;
+        if (UNSIGNED_MULT_OVERFLOWS(newalloc, sizeof(*pool->index))) {
+            return false;
+        }
+        mem_pool_range *newindex = realloc(pool->index, newalloc * sizeof(*pool->index));
+        if (!newindex) {
+            LOR_PERROR("realloc failed", __func__);
+            return false;
+        }
+        pool->index = newindex;
+        pool->indexalloc = newalloc;
+    }
+
+    mem_pool_range range = { .start = (uintptr_t) block->space, .end = (uintptr_t) block->end };
+    size_t pos = __mem_pool_index_upper(pool, range.start);
+    memmove(&pool->index[pos + 1], &pool->index[pos], (pool->nblocks - pos) * sizeof(*pool->index));
+    pool->index[pos] = range;
+    pool->nblocks++;
+    return true;
+}
+
+/**********************************************************
+ * Remove the range of 'block' from the block index.
+ **********************************************************/
+static void __mem_pool_index_remove(Lor_mem_pool *pool, mem_pool_block *block)
+{
+    size_t pos = __mem_pool_index_upper(pool, (uintptr_t) block->space) - 1;
+    memmove(&pool->index[pos], &pool->index[pos + 1], (pool->nblocks - pos - 1) * sizeof(*pool->index));
+    pool->nblocks--;
+}
+
+/* Block of the pool whose space contains 'mem', or NULL */
+static mem_pool_block *__mem_pool_find_block(const Lor_mem_pool *pool, const void *mem)
+{
+    uintptr_t addr = (uintptr_t) mem;
+    size_t pos = __mem_pool_index_upper(pool, addr);
+    if (!pos || addr >= pool->index[pos - 1].end) {
+        return NULL;
+    }
+    return (mem_pool_block *) (pool->index[pos - 1].start - offsetof(mem_pool_block, space));
+}
+
+/**********************************************************
+ * Unindex and free 'block', returning its footprint  from
+ * the memory accounted by the pool.
+ **********************************************************/
+static void __mem_pool_release_block(Lor_mem_pool *pool, mem_pool_block *block)
+{
+    __mem_pool_index_remove(pool, block);
+    pool->poolalloc -= (block->mapsize) ? block->mapsize : (size_t) (block->end - (char *) block);
+    __mem_pool_free_block(block);
+}
+
 /**********************************************************
  * Allocate a  new mem_pool_block  and insert it after  the
  * block specified  in  'insertafter'.  If 'insertafter' is
@@ -31,9 +177,6 @@ static mem_pool_block *__mem_pool_alloc_block(Lor_mem_pool *pool, size_t blockal
 static mem_pool_block *__mem_pool_alloc_block(Lor_mem_pool *pool, size_t blockalloc,
                                               mem_pool_block *insertafter, bool *overflow)
 {
-    size_t oldpoolalloc = pool->poolalloc;
-    pool->poolalloc += sizeof(*pool->mpblock) + blockalloc;
-
     *overflow = false;
     /* Handling size_t overflow */
     jmp_buf env;
@@ -41,20 +184,43 @@ static mem_pool_block *__mem_pool_alloc_block(Lor_mem_pool *pool, size_t blockal
     if (val == LOR_USIZE_OVERFLOW_ERR) {
         USIZE_OVERFLOW_MSG(sizeof(mem_pool_block), blockalloc, __func__);
         *overflow = true;
-        pool->poolalloc = oldpoolalloc;
         return NULL;
     }
     size_t szsum =  __st_add(env, sizeof(mem_pool_block), blockalloc);
-
-    mem_pool_block *p = malloc(szsum);
-    if (!p) {
-        LOR_PERROR("malloc failed", __func__);
-        pool->poolalloc = oldpoolalloc;
+    size_t poolalloc = __st_add(env, pool->poolalloc, szsum);
+
+    mem_pool_block *p;
+    if (pool->flags & LOR_MEM_POOL_MMAP) {
+        size_t mapsize;
+        p = __mem_pool_map_block(szsum, pool->flags, &mapsize);
+        if (!p) {
+            return NULL;
+        }
+        /* The whole mapping is usable */
+        poolalloc += mapsize - szsum;
+        p->mapsize = mapsize;
+        p->nextfree = (char *) p->space;
+        p->end = ((char *) p) + mapsize;
+        p->dirty = p->nextfree;
+    }
+    else {
+        p = malloc(szsum);
+        if (!p) {
+            LOR_PERROR("malloc failed", __func__);
+            return NULL;
+        }
+        p->mapsize = 0;
+        p->nextfree = (char *) p->space;
+        p->end = p->nextfree + blockalloc;
+        p->dirty = p->end;
+    }
+    if (!__mem_pool_index_insert(pool, p)) {
+        __mem_pool_free_block(p);
         return NULL;
     }
-
-    p->nextfree = (char *) p->space;
-    p->end = p->nextfree + blockalloc;
+    pool->poolalloc = poolalloc;
+    p->seq = pool->blockseq++;
+    p->nlive = 0;
 
     if (insertafter) {
         p->nextblock = insertafter->nextblock;
@@ -64,10 +230,139 @@ static mem_pool_block *__mem_pool_alloc_block(Lor_mem_pool *pool, size_t blockal
         p->nextblock = pool->mpblock;
         pool->mpblock = p;
     }
+    if (!p->nextblock) {
+        pool->lastblock = p;
+    }
 
     return p;
 }
 
+static inline size_t __mem_pool_room(const mem_pool_block *block)
+{
+    return (size_t) (block->end - block->nextfree);
+}
+
+/* Bytes to skip in 'block' for the next allocation to be aligned to 'align' */
+static inline size_t __mem_pool_padding(const mem_pool_block *block, size_t align)
+{
+    return (size_t) (-(uintptr_t) block->nextfree & (align - 1));
+}
+
+static inline bool __mem_pool_fits(const mem_pool_block *block, size_t len, size_t align)
+{
+    size_t padding = __mem_pool_padding(block, align);
+    return __mem_pool_room(block) >= padding && __mem_pool_room(block) - padding >= len;
+}
+
+/**********************************************************
+ * Keep 'block' among the partially used blocks of the pool
+ * if it has more free space than one of them.  The  space
+ * left in the block that is not kept is wasted.
+ **********************************************************/
+static void __mem_pool_keep_partial(Lor_mem_pool *pool, mem_pool_block *block)
+{
+    size_t room = __mem_pool_room(block);
+    if (room < sizeof(uintmax_t)) {
+        return;
+    }
+
+    size_t min = 0;
+    for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        if (!pool->partial[i]) {
+            pool->partial[i] = block;
+            return;
+        }
+        if (__mem_pool_room(pool->partial[i]) < __mem_pool_room(pool->partial[min])) {
+            min = i;
+        }
+    }
+    if (__mem_pool_room(pool->partial[min]) < room) {
+        pool->partial[min] = block;
+    }
+}
+
+/**********************************************************
+ * Bump allocation shared by the allocation functions.  The
+ * returned memory is aligned to 'align', a power of two not
+ * smaller than sizeof(uintmax_t).  The block the memory was
+ * taken from is returned in 'blockp'.
+ **********************************************************/
+static void *__mem_pool_alloc(Lor_mem_pool *pool, size_t len, size_t align, mem_pool_block **blockp)
+{
+    /* Check for size_t overflow and round up to a uintmax_t alignment */
+    size_t alignment = sizeof(uintmax_t) - (len & (sizeof(uintmax_t) - 1));
+    if (UNSIGNED_ADD_OVERFLOWS(len, alignment)) {
+        USIZE_OVERFLOW_MSG(len, alignment, __func__);
+        return NULL;
+    }
+    else if (len & (sizeof(uintmax_t) - 1)) {
+        len += alignment;
+    }
+
+    mem_pool_block *p = NULL;
+    if (pool->mpblock && __mem_pool_fits(pool->mpblock, len, align)) {
+        p = pool->mpblock;
+    }
+
+    bool overflow;
+    if (!p) {
+        /* Best fit among the partially used blocks */
+        size_t slot = LOR_MEM_POOL_PARTIAL_SLOTS;
+        for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+            mem_pool_block *q = pool->partial[i];
+            if (q && __mem_pool_fits(q, len, align) &&
+                (slot == LOR_MEM_POOL_PARTIAL_SLOTS || __mem_pool_room(q) < __mem_pool_room(pool->partial[slot]))) {
+                slot = i;
+            }
+        }
+        if (slot < LOR_MEM_POOL_PARTIAL_SLOTS) {
+            p = pool->partial[slot];
+            if (__mem_pool_room(p) - __mem_pool_padding(p, align) - len < sizeof(uintmax_t)) {
+                pool->partial[slot] = NULL;
+            }
+        }
+    }
+    if (!p) {
+        /* The space of a new block is uintmax_t aligned, so the padding
+         * needed is never larger than this */
+        size_t maxpadding = align - sizeof(uintmax_t);
+        if (UNSIGNED_ADD_OVERFLOWS(len, maxpadding)) {
+            USIZE_OVERFLOW_MSG(len, maxpadding, __func__);
+            return NULL;
+        }
+
+        mem_pool_block *oldhead = pool->mpblock;
+        if (len + maxpadding >= (pool->blockalloc / 2)) {
+            /* Big allocations get a block of their own, inserted after the
+             * head so the head block keeps being used */
+            p = __mem_pool_alloc_block(pool, len + maxpadding, oldhead, &overflow);
+            if (!p) {
+                return NULL;
+            }
+            void *retblock = p->nextfree + __mem_pool_padding(p, align);
+            p->nextfree = (char *) retblock + len;
+            p->nlive++;
+            /* mmap'ed blocks are rounded up to the page size */
+            __mem_pool_keep_partial(pool, p);
+            *blockp = p;
+            return retblock;
+        }
+        p = __mem_pool_alloc_block(pool, pool->blockalloc, NULL, &overflow);
+        if (!p) {
+            return NULL;
+        }
+        if (oldhead) {
+            __mem_pool_keep_partial(pool, oldhead);
+        }
+    }
+
+    void *retblock = p->nextfree + __mem_pool_padding(p, align);
+    p->nextfree = (char *) retblock + len;
+    p->nlive++;
+    *blockp = p;
+    return retblock;
+}
+
 Lor_mem_pool *Lor_mem_pool_create(void)
 {
     Lor_mem_pool *pool = malloc(sizeof *pool);
@@ -79,12 +374,24 @@ Lor_mem_pool *Lor_mem_pool_create(void)
 }
 
 int Lor_mem_pool_init(Lor_mem_pool *pool, size_t size)
+{
+    return Lor_mem_pool_init_with_options(pool, size, NULL);
+}
+
+int Lor_mem_pool_init_with_options(Lor_mem_pool *pool, size_t size,
+                                   const Lor_mem_pool_options *opts)
 {
     Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
 
     memset(pool, 0, sizeof *pool);
     pool->blockalloc = 0;
     pool->poolalloc = 0;
+    if (opts) {
+        pool->flags = opts->flags;
+        if (pool->flags & (LOR_MEM_POOL_HUGEPAGES | LOR_MEM_POOL_POPULATE)) {
+            pool->flags |= LOR_MEM_POOL_MMAP;
+        }
+    }
 
     if (size > 0) {
         bool overflow;
@@ -100,7 +407,8 @@ int Lor_mem_pool_init(Lor_mem_pool *pool, size_t size)
         return LOR_ZERO_SIZE_ALLOC_ERR;
     }
 
-    pool->blockalloc = BLOCK_GROWTH_SIZE;
+    pool->blockalloc = (opts && opts->growthsize) ? opts->growthsize : BLOCK_GROWTH_SIZE;
+    pool->retainsize = (opts) ? opts->retainsize : 0;
     return LOR_SUCCESS;
 }
 
@@ -131,9 +439,18 @@ int Lor_mem_pool_discard(Lor_mem_pool *pool, bool invalidate_mem)
         if (invalidate_mem) {
             memset(blocktofree->space, 0xDD, ((char *) blocktofree->end) - ((char *) blocktofree->space));
         }
-        free(blocktofree);
+        __mem_pool_free_block(blocktofree);
     }
     pool->mpblock = NULL;
+    pool->lastblock = NULL;
+    memset(pool->freelist, 0, sizeof pool->freelist);
+    memset(pool->freemark, 0, sizeof pool->freemark);
+    memset(pool->partial, 0, sizeof pool->partial);
+
+    free(pool->index);
+    pool->index = NULL;
+    pool->nblocks = 0;
+    pool->indexalloc = 0;
 
     return LOR_SUCCESS;
 }
@@ -142,38 +459,18 @@ void *Lor_mem_pool_alloc(Lor_mem_pool *pool, size_t len)
 {
     Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
 
-    /* Check for size_t overflow and round up to a uintmax_t alignment */
-    size_t alignment = sizeof(uintmax_t) - (len & (sizeof(uintmax_t) - 1));
-    if (UNSIGNED_ADD_OVERFLOWS(len, alignment)) {
-        USIZE_OVERFLOW_MSG(len, alignment, __func__);
-        return NULL;
-    }
-    else if (len & (sizeof(uintmax_t) - 1)) {
-        len += alignment;
-    }
-
-    mem_pool_block *p = NULL;
-    if (pool->mpblock && pool->mpblock->end - pool->mpblock->nextfree >= len) {
-        p = pool->mpblock;
-    }
+    mem_pool_block *block;
+    return __mem_pool_alloc(pool, len, sizeof(uintmax_t), &block);
+}
 
-    bool overflow;
-    if (!p) {
-        if (len >= (pool->blockalloc / 2)) {
-            mem_pool_block *tmp =  __mem_pool_alloc_block(pool, len, pool->mpblock, &overflow);
-            if (overflow) return NULL;
-            return tmp;
-        }
-        p = __mem_pool_alloc_block(pool, pool->blockalloc, NULL, &overflow);
-        if (overflow) return NULL;
-    }
-    if (!p) {
-        return NULL;
-    }
+void *Lor_mem_pool_aligned_alloc(Lor_mem_pool *pool, size_t len, size_t align)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+    Lor_assert(LOR_MEM_POOL_VALID_ALIGNMENT(align), __func__,
+               "argument 'align' must be a power of two not larger than LOR_MEM_POOL_MAX_ALIGNMENT");
 
-    void *retblock = p->nextfree;
-    p->nextfree += len;
-    return retblock;
+    mem_pool_block *block;
+    return __mem_pool_alloc(pool, len, (align < sizeof(uintmax_t)) ? sizeof(uintmax_t) : align, &block);
 }
 
 void *Lor_mem_pool_calloc(Lor_mem_pool *pool, size_t count, size_t size)
@@ -191,8 +488,15 @@ void *Lor_mem_pool_calloc(Lor_mem_pool *pool, size_t count, size_t size)
     }
 
     size_t len = __st_mult(env, count, size);
-    void *retblock = Lor_mem_pool_alloc(pool, len);
-    memset(retblock, 0, len);
+    mem_pool_block *block;
+    char *retblock = __mem_pool_alloc(pool, len, sizeof(uintmax_t), &block);
+    if (!retblock) {
+        return NULL;
+    }
+    /* Fresh memory of an mmap'ed block is still zero */
+    if (retblock < block->dirty) {
+        memset(retblock, 0, len);
+    }
     return retblock;
 }
 
@@ -222,17 +526,323 @@ char *Lor_mem_pool_strndup(Lor_mem_pool *pool, const char *str, size_t len)
     return memcpy(retstr, str, actuallen);
 }
 
-bool Lor_mem_pool_contains(Lor_mem_pool *pool, void *mem)
+static void __mem_pool_slab_push(Lor_mem_pool *pool, size_t class, mem_pool_slab_obj *obj)
+{
+    if (!pool->freelist[class]) {
+        pool->freetail[class] = obj;
+    }
+    obj->next = pool->freelist[class];
+    pool->freelist[class] = obj;
+}
+
+static void *__mem_pool_slab_pop(Lor_mem_pool *pool, mem_pool_slab_obj **head)
+{
+    mem_pool_slab_obj *obj = *head;
+    *head = obj->next;
+    if (pool->flags & LOR_MEM_POOL_TRACK_LIVE) {
+        __mem_pool_find_block(pool, obj)->nlive++;
+    }
+    return obj;
+}
+
+void *Lor_mem_pool_slab_alloc(Lor_mem_pool *pool, size_t len)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    if (!len || len > LOR_MEM_POOL_SLAB_MAX_SIZE) {
+        return Lor_mem_pool_alloc(pool, len);
+    }
+
+    /* The objects set aside by a savepoint are not handed out */
+    mem_pool_slab_obj **head = &pool->freelist[SLAB_CLASS(len)];
+    if (*head != pool->freemark[SLAB_CLASS(len)]) {
+        return __mem_pool_slab_pop(pool, head);
+    }
+    /* Round up to the class size, so the object can later be reused by
+     * any request of the same class */
+    return Lor_mem_pool_alloc(pool, (SLAB_CLASS(len) + 1) * sizeof(uintmax_t));
+}
+
+void *Lor_mem_pool_slab_aligned_alloc(Lor_mem_pool *pool, size_t len, size_t align)
 {
     Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+    Lor_assert(LOR_MEM_POOL_VALID_ALIGNMENT(align), __func__,
+               "argument 'align' must be a power of two not larger than LOR_MEM_POOL_MAX_ALIGNMENT");
 
-    /* Check if memory is allocated in any block. */
+    if (!len || len > LOR_MEM_POOL_SLAB_MAX_SIZE) {
+        return Lor_mem_pool_aligned_alloc(pool, len, align);
+    }
+
+    /* The released objects of a class may have any alignment, only the
+     * first one is checked to keep this O(1) */
+    mem_pool_slab_obj **head = &pool->freelist[SLAB_CLASS(len)];
+    if (*head != pool->freemark[SLAB_CLASS(len)] && !((uintptr_t) *head & (align - 1))) {
+        return __mem_pool_slab_pop(pool, head);
+    }
+    return Lor_mem_pool_aligned_alloc(pool, (SLAB_CLASS(len) + 1) * sizeof(uintmax_t), align);
+}
+
+void Lor_mem_pool_slab_free(Lor_mem_pool *pool, void *ptr, size_t len)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    if (!ptr || !len || len > LOR_MEM_POOL_SLAB_MAX_SIZE) {
+        return;
+    }
+
+    if (pool->flags & LOR_MEM_POOL_TRACK_LIVE) {
+        mem_pool_block *block = __mem_pool_find_block(pool, ptr);
+        Lor_assert(block && block->nlive, __func__, "argument 'ptr' must be a live object of 'pool'");
+        block->nlive--;
+    }
+
+    __mem_pool_slab_push(pool, SLAB_CLASS(len), ptr);
+}
+
+void Lor_mem_pool_mark(Lor_mem_pool *pool, Lor_mem_pool_savepoint *sp)
+{
+    Lor_assert(pool && sp, __func__, "arguments 'pool' and 'sp' must be non-NULL");
+
+    *sp = (Lor_mem_pool_savepoint){ .block = pool->mpblock,
+                                    .nextfree = (pool->mpblock) ? pool->mpblock->nextfree : NULL,
+                                    .nlive = (pool->mpblock) ? pool->mpblock->nlive : 0,
+                                    .blockseq = pool->blockseq,
+                              };
+    for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        sp->partial[i].block = pool->partial[i];
+        sp->partial[i].nextfree = (pool->partial[i]) ? pool->partial[i]->nextfree : NULL;
+        sp->partial[i].nlive = (pool->partial[i]) ? pool->partial[i]->nlive : 0;
+    }
+
+    /* The released objects stay in the free lists, behind the ones that
+     * will be released after the mark */
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+        sp->freelist[i].head = pool->freelist[i];
+        sp->freelist[i].barrier = pool->freemark[i];
+        pool->freemark[i] = pool->freelist[i];
+    }
+}
+
+/**********************************************************
+ * Move the bump position of 'block' back to 'nextfree'.
+ **********************************************************/
+static void __mem_pool_rewind_block(mem_pool_block *block, char *nextfree)
+{
+    if (block->dirty < block->nextfree) {
+        block->dirty = block->nextfree;
+    }
+    block->nextfree = nextfree;
+}
+
+int Lor_mem_pool_rewind(Lor_mem_pool *pool, const Lor_mem_pool_savepoint *sp)
+{
+    Lor_assert(pool && sp, __func__, "arguments 'pool' and 'sp' must be non-NULL");
+
+    /* The objects released since the mark are in front of the ones it set
+     * aside.  Those allocated after the mark go away with their memory,
+     * the others are still released, so they are no longer live in the
+     * marked blocks */
+    size_t nlive = sp->nlive;
+    size_t partialnlive[LOR_MEM_POOL_PARTIAL_SLOTS];
+    for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        partialnlive[i] = sp->partial[i].nlive;
+    }
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+        mem_pool_slab_obj *obj = pool->freelist[i];
+        pool->freelist[i] = sp->freelist[i].head;
+        pool->freemark[i] = sp->freelist[i].barrier;
+        while (obj != sp->freelist[i].head) {
+            mem_pool_slab_obj *next = obj->next;
+            mem_pool_block *block = __mem_pool_find_block(pool, obj);
+            bool rewound = block->seq >= sp->blockseq;
+            size_t *count = NULL;
+            if (block == sp->block) {
+                rewound = (char *) obj >= sp->nextfree;
+                count = &nlive;
+            }
+            for (size_t j = 0; j < LOR_MEM_POOL_PARTIAL_SLOTS; j++) {
+                if (block == sp->partial[j].block) {
+                    rewound = (char *) obj >= sp->partial[j].nextfree;
+                    count = &partialnlive[j];
+                }
+            }
+            if (!rewound) {
+                if (count) {
+                    (*count)--;
+                }
+                __mem_pool_slab_push(pool, i, obj);
+            }
+            obj = next;
+        }
+    }
+
+    /* Regular blocks allocated after the mark were pushed in front of the
+     * marked block */
+    mem_pool_block *p = pool->mpblock;
+    while (p && p->seq >= sp->blockseq) {
+        mem_pool_block *blocktofree = p;
+        p = p->nextblock;
+        __mem_pool_release_block(pool, blocktofree);
+    }
+    pool->mpblock = p;
+
+    if (!p) {
+        pool->lastblock = NULL;
+    }
+    else {
+        Lor_assert(p == sp->block, __func__, "savepoint does not belong to 'pool'");
+
+        /* Big blocks are inserted right after the head block, so the ones
+         * allocated while the marked block was the head follow it */
+        mem_pool_block *q = p->nextblock;
+        while (q && q->seq >= sp->blockseq) {
+            mem_pool_block *blocktofree = q;
+            q = q->nextblock;
+            __mem_pool_release_block(pool, blocktofree);
+        }
+        p->nextblock = q;
+        if (!q) {
+            pool->lastblock = p;
+        }
+
+        __mem_pool_rewind_block(p, sp->nextfree);
+        p->nlive = nlive;
+    }
+
+    /* The partially used blocks when marked were all allocated before the
+     * mark, and are the only other blocks allocated from since then */
+    for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        pool->partial[i] = sp->partial[i].block;
+        if (pool->partial[i]) {
+            __mem_pool_rewind_block(pool->partial[i], sp->partial[i].nextfree);
+            pool->partial[i]->nlive = partialnlive[i];
+        }
+    }
+
+    return LOR_SUCCESS;
+}
+
+/**********************************************************
+ * Give the pages of the unused space of 'block' back to the
+ * system.  They read as zero afterwards.
+ **********************************************************/
+static void __mem_pool_purge_block(const Lor_mem_pool *pool, mem_pool_block *block)
+{
+#ifdef MADV_DONTNEED
+    size_t pagesize = (pool->flags & LOR_MEM_POOL_HUGEPAGES) ? HUGE_PAGE_SIZE
+                                                             : (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t) block->nextfree + pagesize - 1) & ~(uintptr_t) (pagesize - 1);
+    uintptr_t end = (uintptr_t) block->end & ~(uintptr_t) (pagesize - 1);
+    if (start < end && !madvise((void *) start, end - start, MADV_DONTNEED)) {
+        if ((char *) start < block->dirty) {
+            block->dirty = (char *) start;
+        }
+    }
+#endif
+}
+
+int Lor_mem_pool_trim(Lor_mem_pool *pool)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    if (!(pool->flags & LOR_MEM_POOL_TRACK_LIVE)) {
+        return LOR_NOT_TRACKING_LIVE_ERR;
+    }
+
+    /* Released objects of empty blocks are handed out again from the
+     * reset blocks, or go away with the released ones.  The objects set
+     * aside by savepoints are handed out again too */
+    memset(pool->freemark, 0, sizeof pool->freemark);
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+        mem_pool_slab_obj **link = &pool->freelist[i];
+        while (*link) {
+            if (!__mem_pool_find_block(pool, *link)->nlive) {
+                *link = (*link)->next;
+            }
+            else {
+                pool->freetail[i] = *link;
+                link = &(*link)->next;
+            }
+        }
+    }
+
+    size_t retained = 0;
+    mem_pool_block *prev = NULL;
+    for (mem_pool_block *p = pool->mpblock, *next; p; p = next) {
+        next = p->nextblock;
+        if (p->nlive) {
+            prev = p;
+            continue;
+        }
+
+        size_t footprint = (p->mapsize) ? p->mapsize : (size_t) (p->end - (char *) p);
+        for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+            if (pool->partial[i] == p) {
+                pool->partial[i] = NULL;
+            }
+        }
+        if (p->dirty < p->nextfree) {
+            p->dirty = p->nextfree;
+        }
+        p->nextfree = (char *) p->space;
+
+        if (!UNSIGNED_ADD_OVERFLOWS(retained, footprint) && retained + footprint <= pool->retainsize) {
+            retained += footprint;
+            if (p != pool->mpblock) {
+                __mem_pool_keep_partial(pool, p);
+            }
+            prev = p;
+        }
+        else if (p == pool->mpblock) {
+            if (p->mapsize) {
+                __mem_pool_purge_block(pool, p);
+            }
+            prev = p;
+        }
+        else {
+            prev->nextblock = next;
+            if (pool->lastblock == p) {
+                pool->lastblock = prev;
+            }
+            __mem_pool_release_block(pool, p);
+        }
+    }
+
+    return LOR_SUCCESS;
+}
+
+void Lor_mem_pool_get_stats(Lor_mem_pool *pool, Lor_mem_pool_stats *stats)
+{
+    Lor_assert(pool && stats, __func__, "arguments 'pool' and 'stats' must be non-NULL");
+
+    *stats = (Lor_mem_pool_stats){ .poolalloc = pool->poolalloc,
+                                   .nblocks = pool->nblocks,
+                             };
     for (mem_pool_block *p = pool->mpblock; p; p = p->nextblock) {
-        if ((((void *) p->space) <= mem) && (mem < ((void *) p->end))) {
-            return true;
+        stats->used += (size_t) (p->nextfree - (char *) p->space);
+
+        bool available = (p == pool->mpblock);
+        for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS && !available; i++) {
+            available = (p == pool->partial[i]);
+        }
+        if (available) {
+            stats->available += __mem_pool_room(p);
+        }
+        else {
+            stats->wasted += __mem_pool_room(p);
         }
     }
-    return false;
+}
+
+bool Lor_mem_pool_contains(Lor_mem_pool *pool, void *mem)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    /* Check if memory is allocated in any block: the candidate is the
+     * last block starting at or before 'mem'. */
+    uintptr_t addr = (uintptr_t) mem;
+    size_t pos = __mem_pool_index_upper(pool, addr);
+    return pos && addr < pool->index[pos - 1].end;
 }
 
 int Lor_mem_pool_combine(Lor_mem_pool *dst, Lor_mem_pool *src)
@@ -248,27 +858,78 @@ int Lor_mem_pool_combine(Lor_mem_pool *dst, Lor_mem_pool *src)
     }
     allocsum = __st_add(env, dst->poolalloc, src->poolalloc);
 
-    /* Append the blocks from 'src' to 'dst' */
-    if (dst->mpblock && src->mpblock) {
-        /* 'src' and 'dst' have blocks, append blocks from
-         * 'src' to 'dst' */
-        mem_pool_block *p = dst->mpblock;
-        while (p->nextblock) {
-            p = p->nextblock;
+    if (!src->mpblock) {
+        return LOR_SRC_EMPTY_WARN;
+    }
+
+    /* Merge the block indexes */
+    size_t nblocks = __st_add(env, dst->nblocks, src->nblocks);
+    if (UNSIGNED_MULT_OVERFLOWS(nblocks, sizeof(*dst->index))) {
+        return LOR_USIZE_OVERFLOW_ERR;
+    }
+    mem_pool_range *index = malloc(nblocks * sizeof(*index));
+    if (!index) {
+        LOR_PERROR("malloc failed", __func__);
+        return LOR_ALLOC_FAIL_ERR;
+    }
+    for (size_t i = 0, j = 0, k = 0; k < nblocks; k++) {
+        if (j == src->nblocks || (i < dst->nblocks && dst->index[i].start < src->index[j].start)) {
+            index[k] = dst->index[i++];
         }
-        p->nextblock = src->mpblock;
+        else {
+            index[k] = src->index[j++];
+        }
+    }
+    free(dst->index);
+    free(src->index);
+    dst->index = index;
+    dst->nblocks = dst->indexalloc = nblocks;
+    src->index = NULL;
+    src->nblocks = src->indexalloc = 0;
+
+    /* Append the blocks from 'src' to 'dst', numbered as allocated before
+     * any later savepoint of 'dst' */
+    for (mem_pool_block *p = src->mpblock; p; p = p->nextblock) {
+        p->seq = dst->blockseq++;
     }
-    else if (src->mpblock) {
+    if (dst->mpblock) {
+        dst->lastblock->nextblock = src->mpblock;
+    }
+    else {
         /* 'dst' is empty */
         dst->mpblock = src->mpblock;
     }
-    else {
-        return LOR_SRC_EMPTY_WARN;
+    dst->lastblock = src->lastblock;
+
+    /* The blocks of 'src' with free space may be kept by 'dst' */
+    __mem_pool_keep_partial(dst, src->mpblock);
+    for (size_t i = 0; i < LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        if (src->partial[i]) {
+            __mem_pool_keep_partial(dst, src->partial[i]);
+            src->partial[i] = NULL;
+        }
+    }
+
+    /* Hand the released slab objects of 'src' over to 'dst' */
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+        if (!src->freelist[i]) {
+            continue;
+        }
+        if (dst->freelist[i]) {
+            src->freetail[i]->next = dst->freelist[i];
+        }
+        else {
+            dst->freetail[i] = src->freetail[i];
+        }
+        dst->freelist[i] = src->freelist[i];
+        src->freelist[i] = NULL;
     }
+    memset(src->freemark, 0, sizeof src->freemark);
 
     dst->poolalloc = allocsum;
     src->poolalloc = 0;
     src->mpblock = NULL;
+    src->lastblock = NULL;
     return LOR_SUCCESS;
 }
 
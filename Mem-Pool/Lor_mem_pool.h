@@ -4,14 +4,106 @@
  * Interface for Lorena library memory pool.  This extension is
  * provided if the user doesn't want to provide its own special
  * memory manager.
+ *
+ * Lor_mem_pool is not synchronized.  For allocation from many threads
+ * use a Lor_mem_pool_shared: each thread allocates through its own
+ * Lor_mem_pool_tcache, which bumps from a private block and exchanges
+ * blocks with the other threads through a lock-free depot.
+ *
+ * A Lor_mem_pool_file lays its allocations out in a mapped file (or a
+ * shared anonymous mapping) and identifies them by their offset from the
+ * start of the mapping, so the data structures built in it can be mapped
+ * again, read-only, by other processes without any deserialization.
+ *
+ * A Lor_mem_pool_strtab interns strings in a Lor_mem_pool: equal strings
+ * get the same canonical pointer, stored once.
  */
 #ifndef LOR_MEM_POOL_H
 #define LOR_MEM_POOL_H 1
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct _Lor_mem_pool Lor_mem_pool;
+typedef struct _Lor_mem_pool_shared Lor_mem_pool_shared;
+typedef struct _Lor_mem_pool_tcache Lor_mem_pool_tcache;
+typedef struct _Lor_mem_pool_file Lor_mem_pool_file;
+typedef struct _Lor_mem_pool_strtab Lor_mem_pool_strtab;
+
+/* Position of an allocation in a Lor_mem_pool_file.  The file header lies
+ * at offset 0, so 0 never designates an allocation and is the null offset. */
+typedef uint64_t Lor_mem_pool_off;
+
+/* Largest object size served by the slab free lists. */
+#ifndef LOR_MEM_POOL_SLAB_MAX_SIZE
+#define LOR_MEM_POOL_SLAB_MAX_SIZE 256
+#endif
+
+/* Options of the blocks backing a Lor_mem_pool */
+enum {
+    LOR_MEM_POOL_MMAP      = 1 << 0,  /* map blocks with anonymous mmap instead of malloc */
+    LOR_MEM_POOL_HUGEPAGES = 1 << 1,  /* back blocks with huge pages (implies MMAP): */
+                                      /* MAP_HUGETLB if available, else transparent  */
+                                      /* huge pages through madvise                  */
+    LOR_MEM_POOL_POPULATE  = 1 << 2,  /* pre-fault the blocks when they are mapped   */
+                                      /* (implies MMAP)                              */
+    LOR_MEM_POOL_TRACK_LIVE = 1 << 3, /* count the live slab objects of each block, */
+                                      /* so Lor_mem_pool_trim can release the blocks */
+                                      /* that became empty                           */
+};
+
+/* Options of Lor_mem_pool_file_open */
+enum {
+    LOR_MEM_POOL_FILE_CREATE   = 1 << 0,  /* create the file, or truncate an existing one */
+    LOR_MEM_POOL_FILE_READONLY = 1 << 1,  /* map an existing file read-only              */
+};
+
+/* Largest alignment accepted by the aligned allocation functions */
+#ifndef LOR_MEM_POOL_MAX_ALIGNMENT
+#define LOR_MEM_POOL_MAX_ALIGNMENT 4096
+#endif
+
+#define LOR_MEM_POOL_VALID_ALIGNMENT(align) \
+    ((align) && !((align) & ((align) - 1)) && (align) <= LOR_MEM_POOL_MAX_ALIGNMENT)
+
+/* Number of partially used blocks, besides the head block, from which
+ * a pool keeps serving allocations. */
+#ifndef LOR_MEM_POOL_PARTIAL_SLOTS
+#define LOR_MEM_POOL_PARTIAL_SLOTS 4
+#endif
+
+/* A position of the pool to roll back to, see Lor_mem_pool_mark */
+typedef struct {
+    void *block;        /* head block of the pool when marked */
+    char *nextfree;     /* bump position of that block */
+    size_t nlive;       /* live objects of that block */
+    size_t blockseq;    /* blocks allocated after the mark have a higher sequence */
+    struct {
+        void *block;
+        char *nextfree;
+        size_t nlive;
+    } partial[LOR_MEM_POOL_PARTIAL_SLOTS];  /* partially used blocks when marked */
+    struct {
+        void *head;     /* first released object when marked */
+        void *barrier;  /* first released object set aside by the previous mark */
+    } freelist[LOR_MEM_POOL_SLAB_MAX_SIZE / sizeof(uintmax_t)];  /* slab free lists */
+} Lor_mem_pool_savepoint;
+
+/* Memory usage of a pool, see Lor_mem_pool_get_stats */
+typedef struct {
+    size_t poolalloc;   /* bytes obtained for the blocks, including their headers */
+    size_t nblocks;     /* number of blocks */
+    size_t used;        /* bytes handed out, including the alignment padding */
+    size_t available;   /* bytes still available in the head and partial blocks */
+    size_t wasted;      /* bytes left at the end of blocks no longer allocated from */
+} Lor_mem_pool_stats;
+
+typedef struct {
+    size_t growthsize;  /* size of the blocks the pool grows by, 0 for the default */
+    unsigned flags;     /* bitwise or of LOR_MEM_POOL_* options */
+    size_t retainsize;  /* bytes of empty blocks Lor_mem_pool_trim keeps for reuse */
+} Lor_mem_pool_options;
 
 /**********************************************************
  * \brief Alloc a Lor_mem_pool from the heap
@@ -35,6 +127,23 @@ extern Lor_mem_pool *Lor_mem_pool_create(void);
  **********************************************************/
 extern int Lor_mem_pool_init(Lor_mem_pool *pool, size_t size);
 
+/**********************************************************
+ * \brief Initialize the memory pool with specified size and
+ *        block options.  Memory handed out  from  mmap'ed
+ *        blocks is known to be zero, so Lor_mem_pool_calloc
+ *        doesn't clear it.
+ *
+ * \param pool    the Lor_mem_pool pointer to objecto to be
+ *                initialized
+ * \param size    the size of the initial block allocated
+ * \param opts    the block options, or NULL for the defaults
+ *                of Lor_mem_pool_init
+ *
+ * \return same as Lor_mem_pool_init
+ **********************************************************/
+extern int Lor_mem_pool_init_with_options(Lor_mem_pool *pool, size_t size,
+                                          const Lor_mem_pool_options *opts);
+
 /**********************************************************
  * \brief Deallocates a Lor_mem_pool of the heap
  *
@@ -63,6 +172,10 @@ extern int Lor_mem_pool_discard(Lor_mem_pool *pool, bool invalidate_mem);
 
 /**********************************************************
  * \brief Allocates a block of memory from the memory pool.
+ *        When the head block of the pool is full, the block
+ *        is kept among the LOR_MEM_POOL_PARTIAL_SLOTS blocks
+ *        with the most free space left, from which the later
+ *        allocations that fit are served.
  *
  * \param pool    the memory pool from which allocate the block
  * \param len     the size of the block to be allocated
@@ -72,6 +185,20 @@ extern int Lor_mem_pool_discard(Lor_mem_pool *pool, bool invalidate_mem);
  **********************************************************/
 extern void *Lor_mem_pool_alloc(Lor_mem_pool *pool, size_t len);
 
+/**********************************************************
+ * \brief Allocates a block of memory from the memory  pool
+ *        whose address is a multiple of 'align'.  The padding
+ *        skipped to align the block is not reused.
+ *
+ * \param pool     the memory pool from which allocate the block
+ * \param len      the size of the block
+ * \param align    a power of two not larger than LOR_MEM_POOL_MAX_ALIGNMENT
+ *
+ * \return the new block allocated from the pool
+ * \return NULL if the allocation fails
+ **********************************************************/
+extern void *Lor_mem_pool_aligned_alloc(Lor_mem_pool *pool, size_t len, size_t align);
+
 /**********************************************************
  * \brief Allocates a block of memory from the memory  pool
  *        and zero the memory.
@@ -112,6 +239,48 @@ extern char *Lor_mem_pool_strdup(Lor_mem_pool *pool, const char *str);
  **********************************************************/
 extern char *Lor_mem_pool_strndup(Lor_mem_pool *pool, const char *str, size_t len);
 
+/**********************************************************
+ * \brief Allocates a fixed size object from the slab free
+ *        lists of the pool, or from the pool itself if  no
+ *        object of that size class was released.  This  is
+ *        O(1) and meant for allocators of tree nodes.
+ *
+ * \param pool    the memory pool from which allocate the object
+ * \param len     the size of the object
+ *
+ * \return the new object allocated from the pool
+ * \return NULL if the allocation fails
+ **********************************************************/
+extern void *Lor_mem_pool_slab_alloc(Lor_mem_pool *pool, size_t len);
+
+/**********************************************************
+ * \brief Same as Lor_mem_pool_slab_alloc, but the object  is
+ *        aligned to 'align'.  Objects allocated  this  way
+ *        are released with Lor_mem_pool_slab_free.
+ *
+ * \param pool     the memory pool from which allocate the object
+ * \param len      the size of the object
+ * \param align    a power of two not larger than LOR_MEM_POOL_MAX_ALIGNMENT
+ *
+ * \return the new object allocated from the pool
+ * \return NULL if the allocation fails
+ **********************************************************/
+extern void *Lor_mem_pool_slab_aligned_alloc(Lor_mem_pool *pool, size_t len, size_t align);
+
+/**********************************************************
+ * \brief Release an object allocated by  Lor_mem_pool_slab_alloc
+ *        so that a later allocation of  the  same  size  class
+ *        can reuse it.  Objects  larger  than
+ *        LOR_MEM_POOL_SLAB_MAX_SIZE  are  not  recycled;  their
+ *        memory is held until the pool is discarded.
+ *
+ * \param pool    the memory pool that owns 'ptr'
+ * \param ptr     the object to be released
+ * \param len     the size  passed  to  Lor_mem_pool_slab_alloc
+ *                when 'ptr' was allocated
+ **********************************************************/
+extern void Lor_mem_pool_slab_free(Lor_mem_pool *pool, void *ptr, size_t len);
+
 /**********************************************************
  * \brief Move the memory associated with the 'src' pool to
  *        the 'dst' pool. The 'src' pool will be empty  and
@@ -126,6 +295,77 @@ extern char *Lor_mem_pool_strndup(Lor_mem_pool *pool, const char *str, size_t le
  **********************************************************/
 extern int Lor_mem_pool_combine(Lor_mem_pool *dst, Lor_mem_pool *src);
 
+/**********************************************************
+ * \brief Save the current allocation position of the pool,
+ *        so that everything allocated afterwards  can  be
+ *        released at once by Lor_mem_pool_rewind.
+ *
+ *        The objects released to the slab before  the  mark
+ *        are set aside until the pool is rewound to it,  so
+ *        the rewind does not have to take them back from the
+ *        allocations made after the mark.  A savepoint that is
+ *        never rewound to keeps them aside until the pool  is
+ *        trimmed.
+ *
+ * \param pool    the memory pool to be marked
+ * \param sp      the savepoint to be filled
+ **********************************************************/
+extern void Lor_mem_pool_mark(Lor_mem_pool *pool, Lor_mem_pool_savepoint *sp);
+
+/**********************************************************
+ * \brief Roll the pool back to a savepoint: the blocks
+ *        allocated after the mark are released, the  bump
+ *        position and the live objects of the marked blocks
+ *        are restored, and the slab free lists are  the ones
+ *        of the mark plus the objects allocated  before  it
+ *        and released since.  This takes O(blocks released +
+ *        objects released to the slab since the mark).
+ *        Savepoints can be nested; rewinding to one
+ *        invalidates the savepoints taken after it.  The pool
+ *        must not be discarded, trimmed or be the 'dst'  of
+ *        Lor_mem_pool_combine between the mark and the rewind.
+ *
+ * \param pool    the memory pool to be rolled back
+ * \param sp      a savepoint filled by Lor_mem_pool_mark
+ *
+ * \return LOR_SUCCESS    if the operation was successfull
+ **********************************************************/
+extern int Lor_mem_pool_rewind(Lor_mem_pool *pool, const Lor_mem_pool_savepoint *sp);
+
+/**********************************************************
+ * \brief Give the memory of the blocks that have no live
+ *        allocation back to the system.  Requires the pool to
+ *        be initialized with LOR_MEM_POOL_TRACK_LIVE.
+ *
+ *        A block is empty once every object taken from it by
+ *        Lor_mem_pool_slab_alloc has been released with
+ *        Lor_mem_pool_slab_free; memory from the other
+ *        allocation functions keeps its block live until the
+ *        pool is discarded.  Released objects lying in empty
+ *        blocks are dropped from the slab free lists.  Empty
+ *        blocks are reset for reuse up to the retainsize of
+ *        the pool options, the others are freed or unmapped.
+ *        The head block is never released; when mmap'ed, its
+ *        pages are given back with madvise(MADV_DONTNEED).
+ *
+ *        This invalidates the savepoints of the pool.
+ *
+ * \param pool     the memory pool to be trimmed
+ *
+ * \return LOR_SUCCESS                if the pool was trimmed
+ * \return LOR_NOT_TRACKING_LIVE_ERR  if the pool doesn't track live objects
+ **********************************************************/
+extern int Lor_mem_pool_trim(Lor_mem_pool *pool);
+
+/**********************************************************
+ * \brief Compute the memory usage of the pool.   This walks
+ *        every block of the pool.
+ *
+ * \param pool     the memory pool to be inspected
+ * \param stats    the stats to be filled
+ **********************************************************/
+extern void Lor_mem_pool_get_stats(Lor_mem_pool *pool, Lor_mem_pool_stats *stats);
+
 /**********************************************************
  * \brief Check if a memory pointed at by 'mem' is part  of
  *        the range of memory managed by the specified pool.
@@ -138,4 +378,289 @@ extern int Lor_mem_pool_combine(Lor_mem_pool *dst, Lor_mem_pool *src);
  **********************************************************/
 extern bool Lor_mem_pool_contains(Lor_mem_pool *pool, void *mem);
 
+/**********************************************************
+ * \brief Alloc a Lor_mem_pool_shared from the heap
+ *
+ * \return a pointer to Lor_mem_pool_shared on the heap, if
+ *         successfull
+ * \return NULL    if allocation fails
+ **********************************************************/
+extern Lor_mem_pool_shared *Lor_mem_pool_shared_create(void);
+
+/**********************************************************
+ * \brief Initialize a shared memory pool.  No  memory  is
+ *        allocated until the first thread cache allocation.
+ *
+ * \param pool         the Lor_mem_pool_shared to be initialized
+ * \param blocksize    the size of the blocks handed to the thread
+ *                     caches. Pass 0 for the default growth size
+ *
+ * \return LOR_SUCCESS    if initialization was successfull
+ **********************************************************/
+extern int Lor_mem_pool_shared_init(Lor_mem_pool_shared *pool, size_t blocksize);
+
+/**********************************************************
+ * \brief Deallocates a Lor_mem_pool_shared of the heap
+ *
+ * \param pool    a pointer to the pointer that  points  to
+ *                the Lor_mem_pool_shared object on the heap
+ *
+ * \return LOR_SUCCESS                  if operation was successfull
+ * \return LOR_POSSIBLE_MEMLEAK_WARN    if the pool still has blocks
+ **********************************************************/
+extern int Lor_mem_pool_shared_destroy(Lor_mem_pool_shared **pool);
+
+/**********************************************************
+ * \brief Discard all the heap memory that the shared  pool
+ *        is responsible for.  Every thread cache  of  the
+ *        pool must have been destroyed before.
+ *
+ * \param pool              the shared pool whose blocks will be discarded
+ * \param invalidate_mem    a boolean value that  indicates  if  the
+ *                          memory is to be invalidated
+ *
+ * \return LOR_SUCCESS             if the operation was successfull
+ * \return LOR_FREE_NULLPTR_WARN   if the pool has no blocks
+ **********************************************************/
+extern int Lor_mem_pool_shared_discard(Lor_mem_pool_shared *pool, bool invalidate_mem);
+
+/**********************************************************
+ * \brief Check if a memory pointed at by 'mem' is part  of
+ *        any block of the shared pool, whichever thread cache
+ *        allocated it.  Safe to call concurrently with  the
+ *        thread caches allocations.
+ *
+ * \param pool    the shared pool to be checked against
+ * \param mem     the pointer to the memory to be checked
+ *
+ * \return true    if 'mem' is in a block of 'pool'
+ * \return false   otherwise
+ **********************************************************/
+extern bool Lor_mem_pool_shared_contains(Lor_mem_pool_shared *pool, void *mem);
+
+/**********************************************************
+ * \brief Create a thread cache for the shared pool.  Each
+ *        thread must use its own cache.
+ *
+ * \param pool    the shared pool the cache allocates from
+ *
+ * \return a pointer to the thread cache, if successfull
+ * \return NULL    if allocation fails
+ **********************************************************/
+extern Lor_mem_pool_tcache *Lor_mem_pool_tcache_create(Lor_mem_pool_shared *pool);
+
+/**********************************************************
+ * \brief Destroy a thread cache.  Its current block is put
+ *        back in the depot, so that  the  remaining  space
+ *        can be used by another thread cache.  The  memory
+ *        allocated through the cache remains valid until the
+ *        shared pool is discarded.
+ *
+ * \param cache    a pointer to the pointer to the thread cache
+ *
+ * \return LOR_SUCCESS             if operation was successfull
+ * \return LOR_FREE_NULLPTR_WARN   if *cache is NULL
+ **********************************************************/
+extern int Lor_mem_pool_tcache_destroy(Lor_mem_pool_tcache **cache);
+
+/**********************************************************
+ * \brief Allocates a block of memory through a thread cache.
+ *        Only the depot exchange, when the current block of
+ *        the cache is exhausted, touches shared state.
+ *
+ * \param cache    the thread cache of the calling thread
+ * \param len      the size of the block to be allocated
+ *
+ * \return the new block allocated from the shared pool
+ * \return NULL if the allocation fails
+ **********************************************************/
+extern void *Lor_mem_pool_tcache_alloc(Lor_mem_pool_tcache *cache, size_t len);
+
+/**********************************************************
+ * \brief Alloc a Lor_mem_pool_file from the heap
+ *
+ * \return a pointer to Lor_mem_pool_file on the heap, if
+ *         successfull
+ * \return NULL, if failed
+ **********************************************************/
+extern Lor_mem_pool_file *Lor_mem_pool_file_create(void);
+
+/**********************************************************
+ * \brief Map the file at 'path' as the backing store of the
+ *        pool.  A new file is extended to 'capacity' bytes;
+ *        its blocks are not written until  allocated,  so  a
+ *        large capacity costs no disk space on file  systems
+ *        with sparse files.  An existing file is extended  to
+ *        'capacity' if it is smaller, and its header is checked.
+ *        The capacity is fixed while the pool is open.
+ *
+ *        With a NULL 'path', the pool is a  shared  anonymous
+ *        mapping, inherited by the children of the process.
+ *
+ *        The file is laid out in host byte order.
+ *
+ * \param pool        the Lor_mem_pool_file to be opened
+ * \param path        the path of the file, or NULL
+ * \param capacity    the size of the mapping, ignored for read-only pools
+ * \param flags       bitwise or of LOR_MEM_POOL_FILE_* options
+ *
+ * \return LOR_SUCCESS              if the pool was opened
+ * \return LOR_ZERO_SIZE_ALLOC_ERR  if 'capacity' cannot hold the file header
+ * \return LOR_FILE_IO_ERR          if the file could not be opened, resized or mapped
+ * \return LOR_BAD_FILE_FORMAT_ERR  if the file is not a Lor_mem_pool_file
+ **********************************************************/
+extern int Lor_mem_pool_file_open(Lor_mem_pool_file *pool, const char *path, size_t capacity,
+                                  unsigned flags);
+
+/**********************************************************
+ * \brief Unmap the pool.  A writable file is synchronized and
+ *        truncated to the bytes used, so that it can be mapped
+ *        read-only afterwards.
+ *
+ * \param pool    the Lor_mem_pool_file to be closed
+ *
+ * \return LOR_SUCCESS            if the pool was closed
+ * \return LOR_FREE_NULLPTR_WARN  if the pool is not open
+ * \return LOR_FILE_IO_ERR        if the file could not be synchronized
+ **********************************************************/
+extern int Lor_mem_pool_file_close(Lor_mem_pool_file *pool);
+
+/**********************************************************
+ * \brief Deallocates a Lor_mem_pool_file of the heap
+ *
+ * \param pool    a pointer to the pointer to the pool
+ *
+ * \return LOR_SUCCESS                if operation was successfull
+ * \return LOR_POSSIBLE_MEMLEAK_WARN  if the pool is still open
+ **********************************************************/
+extern int Lor_mem_pool_file_destroy(Lor_mem_pool_file **pool);
+
+/**********************************************************
+ * \brief Allocates a block of memory from the file.   The
+ *        block is aligned to sizeof(uintmax_t).
+ *
+ * \param pool    the pool from which allocate the block
+ * \param len     the size of the block
+ *
+ * \return the offset of the new block
+ * \return 0 if the pool is read-only or full
+ **********************************************************/
+extern Lor_mem_pool_off Lor_mem_pool_file_alloc(Lor_mem_pool_file *pool, size_t len);
+
+/**********************************************************
+ * \brief Address of the block at 'off' in this mapping of the
+ *        pool.  It is valid until the pool is closed.
+ *
+ * \return the address of the block, NULL for the null offset
+ **********************************************************/
+extern void *Lor_mem_pool_file_ptr(const Lor_mem_pool_file *pool, Lor_mem_pool_off off);
+
+/**********************************************************
+ * \brief Offset of the memory pointed at by 'mem', which must
+ *        be in the mapping of the pool.
+ *
+ * \return the offset of 'mem', 0 for NULL
+ **********************************************************/
+extern Lor_mem_pool_off Lor_mem_pool_file_off(const Lor_mem_pool_file *pool, const void *mem);
+
+/**********************************************************
+ * \brief Check if the pool was opened with
+ *        LOR_MEM_POOL_FILE_READONLY.
+ **********************************************************/
+extern bool Lor_mem_pool_file_is_readonly(const Lor_mem_pool_file *pool);
+
+/**********************************************************
+ * \brief Get or set the root offset recorded in the file
+ *        header, from which a reader finds the data
+ *        structures stored in the file.
+ *
+ * \return LOR_SUCCESS        if the root was set
+ * \return LOR_READ_ONLY_ERR  if the pool is read-only
+ **********************************************************/
+extern Lor_mem_pool_off Lor_mem_pool_file_get_root(const Lor_mem_pool_file *pool);
+extern int Lor_mem_pool_file_set_root(Lor_mem_pool_file *pool, Lor_mem_pool_off root);
+
+/**********************************************************
+ * \brief Number of bytes of the pool in use, the header of
+ *        the file included.  The blocks allocated from the
+ *        pool all end at or before this offset.
+ **********************************************************/
+extern size_t Lor_mem_pool_file_used(const Lor_mem_pool_file *pool);
+
+/**********************************************************
+ * \brief Alloc a Lor_mem_pool_strtab from the heap
+ *
+ * \return a pointer to Lor_mem_pool_strtab on the heap, if
+ *         successfull
+ * \return NULL, if failed
+ **********************************************************/
+extern Lor_mem_pool_strtab *Lor_mem_pool_strtab_create(void);
+
+/**********************************************************
+ * \brief Initialize an empty string table whose strings are
+ *        allocated from 'pool'.  The hash set itself is kept
+ *        on the heap, so it can grow without wasting pool
+ *        memory.
+ *
+ * \param tab     the Lor_mem_pool_strtab to be initialized
+ * \param pool    an initialized memory pool
+ *
+ * \return LOR_SUCCESS
+ **********************************************************/
+extern int Lor_mem_pool_strtab_init(Lor_mem_pool_strtab *tab, Lor_mem_pool *pool);
+
+/**********************************************************
+ * \brief Release the hash set of the table.  The interned
+ *        strings remain valid until their pool is discarded.
+ *
+ * \param tab     the table to be emptied
+ *
+ * \return LOR_SUCCESS            if operation was successfull
+ * \return LOR_FREE_NULLPTR_WARN  if the table is already empty
+ **********************************************************/
+extern int Lor_mem_pool_strtab_clear(Lor_mem_pool_strtab *tab);
+
+/**********************************************************
+ * \brief Deallocates a Lor_mem_pool_strtab of the heap
+ *
+ * \param tab     a pointer to the pointer to the table
+ *
+ * \return LOR_SUCCESS                if operation was successfull
+ * \return LOR_POSSIBLE_MEMLEAK_WARN  if the table was not cleared
+ **********************************************************/
+extern int Lor_mem_pool_strtab_destroy(Lor_mem_pool_strtab **tab);
+
+/**********************************************************
+ * \brief Return the canonical copy of 'str', copying it to
+ *        the pool on its first occurrence.  Two strings  are
+ *        equal iff their canonical pointers are equal.
+ *
+ * \param tab     the string table
+ * \param str     the string to be interned
+ *
+ * \return the canonical pointer of 'str'
+ * \return NULL if the allocation fails
+ **********************************************************/
+extern const char *Lor_mem_pool_strtab_intern(Lor_mem_pool_strtab *tab, const char *str);
+
+/**********************************************************
+ * \brief Same as Lor_mem_pool_strtab_intern, for the string
+ *        made of at most the 'len' first characters of 'str'.
+ **********************************************************/
+extern const char *Lor_mem_pool_strtab_internn(Lor_mem_pool_strtab *tab, const char *str, size_t len);
+
+/**********************************************************
+ * \brief Return the canonical copy of 'str' without interning
+ *        it.
+ *
+ * \return the canonical pointer of 'str'
+ * \return NULL if 'str' was never interned
+ **********************************************************/
+extern const char *Lor_mem_pool_strtab_lookup(const Lor_mem_pool_strtab *tab, const char *str);
+
+/**********************************************************
+ * \brief Number of strings interned in the table
+ **********************************************************/
+extern size_t Lor_mem_pool_strtab_count(const Lor_mem_pool_strtab *tab);
+
 #endif
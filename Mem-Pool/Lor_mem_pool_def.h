@@ -12,6 +12,8 @@
 #include <setjmp.h>
 #include <limits.h>
 #include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
 
 #ifndef FLEX_ARRAY
 /* Check if the compiler is known to support flexible array members */
@@ -34,17 +36,112 @@ typedef struct mem_pool_block {
     struct mem_pool_block *nextblock;
     char *nextfree;
     char *end;
+    char *dirty;                  /* For mmap'ed blocks, the memory in [nextfree, end) */
+                                  /* above 'dirty' was never handed out and is zero.  */
+    size_t mapsize;               /* Size of the mapping, 0 if the block was malloc'ed */
+    size_t seq;                   /* Allocation order of the block in its pool */
+    size_t nlive;                 /* Allocations from the block not released to the */
+                                  /* slab, see LOR_MEM_POOL_TRACK_LIVE              */
     uintmax_t space[FLEX_ARRAY];  /* more */
 } mem_pool_block;
 
-#define BLOCK_GROWTH_SIZE 1024*1024 - sizeof(mem_pool_block);
+/* Address range of a block space, kept in the sorted block index of the
+ * pool. */
+typedef struct mem_pool_range {
+    uintptr_t start;
+    uintptr_t end;
+} mem_pool_range;
+
+#define BLOCK_GROWTH_SIZE (1024*1024 - sizeof(mem_pool_block))
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
+/* Objects released to the slab are kept in singly linked free lists, one
+ * per size class.  Each class is a multiple of sizeof(uintmax_t), so the
+ * link always fits inside the released object itself. */
+#define SLAB_CLASSES (LOR_MEM_POOL_SLAB_MAX_SIZE / sizeof(uintmax_t))
+#define SLAB_CLASS(len) (((len) - 1) / sizeof(uintmax_t))
+
+typedef struct mem_pool_slab_obj {
+    struct mem_pool_slab_obj *next;
+} mem_pool_slab_obj;
 
 struct _Lor_mem_pool {
     mem_pool_block *mpblock;
     size_t poolalloc;  /* Total amount of memory allocated by the pool. */
     size_t blockalloc; /* Amount of available memory to grow the  pool  */
-};                     /* by. This size does not include the  overhead  */
+                       /* by. This size does not include the  overhead  */
                        /* for the mpblock.                              */
+    unsigned flags;    /* LOR_MEM_POOL_* backing options */
+    size_t retainsize; /* bytes of empty blocks kept by Lor_mem_pool_trim */
+    mem_pool_block *lastblock; /* tail of the mpblock list */
+    mem_pool_range *index;     /* block ranges sorted by address */
+    size_t nblocks;            /* number of blocks in the index  */
+    size_t indexalloc;         /* capacity of the index          */
+    size_t blockseq;           /* sequence number of the next block */
+    mem_pool_block *partial[LOR_MEM_POOL_PARTIAL_SLOTS]; /* blocks other than the */
+                                                         /* head with free space  */
+    mem_pool_slab_obj *freelist[SLAB_CLASSES]; /* released slab objects */
+    mem_pool_slab_obj *freetail[SLAB_CLASSES]; /* last object of each non-empty */
+                                               /* free list                     */
+    mem_pool_slab_obj *freemark[SLAB_CLASSES]; /* first object set aside by */
+                                               /* the last savepoint        */
+};
+
+/* Number of depot slots through which thread caches exchange blocks that
+ * still have free space. */
+#ifndef LOR_MEM_POOL_DEPOT_SLOTS
+#define LOR_MEM_POOL_DEPOT_SLOTS 64
+#endif
+
+struct _Lor_mem_pool_shared {
+    _Atomic(mem_pool_block *) mpblock;  /* Every block of the pool, linked */
+                                        /* through nextblock. Push only.   */
+    _Atomic(mem_pool_block *) depot[LOR_MEM_POOL_DEPOT_SLOTS];
+    atomic_size_t poolalloc;            /* Total amount of memory allocated by the pool. */
+    atomic_size_t ncaches;              /* Number of live thread caches */
+    size_t blockalloc;                  /* Size of the blocks handed to the caches */
+};
+
+struct _Lor_mem_pool_tcache {
+    Lor_mem_pool_shared *pool;
+    mem_pool_block *current;  /* block the owning thread bumps from */
+    size_t depotslot;         /* first depot slot probed by this cache */
+};
+
+/* Open addressing slot of a Lor_mem_pool_strtab, empty if str is NULL */
+typedef struct mem_pool_strtab_slot {
+    const char *str;
+    size_t len;
+    uint64_t hash;
+} mem_pool_strtab_slot;
+
+struct _Lor_mem_pool_strtab {
+    Lor_mem_pool *pool;            /* holds the interned strings */
+    mem_pool_strtab_slot *slots;   /* capacity is a power of two */
+    size_t capacity;
+    size_t nstrings;
+};
+
+/* Header at offset 0 of a Lor_mem_pool_file.  The allocations start at
+ * MEM_POOL_FILE_HEADER_SIZE. */
+#define MEM_POOL_FILE_MAGIC "LORPOOL"
+#define MEM_POOL_FILE_VERSION 1
+#define MEM_POOL_FILE_HEADER_SIZE 64
+
+typedef struct mem_pool_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headersize;
+    uint64_t used;      /* bytes allocated, header included */
+    uint64_t root;      /* see Lor_mem_pool_file_set_root */
+} mem_pool_file_header;
+
+struct _Lor_mem_pool_file {
+    char *base;         /* start of the mapping, NULL if the pool is not open */
+    size_t mapsize;
+    int fd;             /* -1 for anonymous mappings */
+    bool readonly;
+};
 
 /*********************************************
  * Overflow check
@@ -61,6 +158,10 @@ struct _Lor_mem_pool {
 #define UNSIGNED_MULT_OVERFLOWS(a, b)      \
     ((b) > MAX_UNSIGNED_VALUE_OF_TYPE(a) / (a))
 
+#define USIZE_OVERFLOW_MSG(a, b, func)                                                                             \
+    fprintf(stderr, "[%s:%s:%lu]: [OVERFLOW]: size_t overflow encountered at: %"PRIuMAX" + %"PRIuMAX"\n", \
+                __FILE__, func, __LINE__+0UL, (uintmax_t) (a), (uintmax_t) (b));
+
 static inline size_t __st_add(jmp_buf env, size_t a, size_t b)
 {
     if (UNSIGNED_ADD_OVERFLOWS(a, b)) {
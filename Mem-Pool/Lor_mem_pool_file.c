@@ -0,0 +1,246 @@
+/* C file:
+ *       Lor_mem_pool_file.c
+ *
+ * File backed memory pool of the Lorena library.
+ *
+ * The whole capacity of the pool is mapped at once, so the mapping never
+ * moves while the pool is open and the addresses returned by
+ * Lor_mem_pool_file_ptr stay valid.  Allocations are bumped from the
+ * 'used' mark of the file header; there is no free.
+ */
+#include "Lor_mem_pool_def.h"
+#include <Lor_assert.h>
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline mem_pool_file_header *__file_header(const Lor_mem_pool_file *pool)
+{
+    return (mem_pool_file_header *) pool->base;
+}
+
+static int __file_fail(Lor_mem_pool_file *pool, const char *msg, const char *func)
+{
+    LOR_PERROR(msg, func);
+    if (pool->fd >= 0) {
+        close(pool->fd);
+    }
+    pool->fd = -1;
+    return LOR_FILE_IO_ERR;
+}
+
+Lor_mem_pool_file *Lor_mem_pool_file_create(void)
+{
+    Lor_mem_pool_file *pool = malloc(sizeof *pool);
+    if (!pool) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    *pool = (Lor_mem_pool_file){ .base = NULL, .fd = -1 };
+    return pool;
+}
+
+int Lor_mem_pool_file_open(Lor_mem_pool_file *pool, const char *path, size_t capacity,
+                           unsigned flags)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+    Lor_assert(path || !(flags & LOR_MEM_POOL_FILE_READONLY), __func__,
+               "an anonymous pool cannot be read-only");
+
+    *pool = (Lor_mem_pool_file){ .base = NULL,
+                                 .fd = -1,
+                                 .readonly = flags & LOR_MEM_POOL_FILE_READONLY,
+                           };
+    if (!pool->readonly && capacity < MEM_POOL_FILE_HEADER_SIZE) {
+        return LOR_ZERO_SIZE_ALLOC_ERR;
+    }
+
+    bool fresh = true;
+    if (!path) {
+        pool->mapsize = capacity;
+        pool->base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    else {
+        int oflags = (pool->readonly) ? O_RDONLY : O_RDWR;
+        if (!pool->readonly && (flags & LOR_MEM_POOL_FILE_CREATE)) {
+            oflags |= O_CREAT | O_TRUNC;
+        }
+        pool->fd = open(path, oflags, 0644);
+        if (pool->fd < 0) {
+            return __file_fail(pool, "open failed", __func__);
+        }
+
+        struct stat st;
+        if (fstat(pool->fd, &st)) {
+            return __file_fail(pool, "fstat failed", __func__);
+        }
+        fresh = (st.st_size == 0);
+        if (fresh && pool->readonly) {
+            close(pool->fd);
+            pool->fd = -1;
+            return LOR_BAD_FILE_FORMAT_ERR;
+        }
+
+        pool->mapsize = (size_t) st.st_size;
+        if (!pool->readonly && pool->mapsize < capacity) {
+            if (ftruncate(pool->fd, (off_t) capacity)) {
+                return __file_fail(pool, "ftruncate failed", __func__);
+            }
+            pool->mapsize = capacity;
+        }
+        int prot = (pool->readonly) ? PROT_READ : PROT_READ | PROT_WRITE;
+        pool->base = mmap(NULL, pool->mapsize, prot, MAP_SHARED, pool->fd, 0);
+    }
+    if (pool->base == MAP_FAILED) {
+        pool->base = NULL;
+        return __file_fail(pool, "mmap failed", __func__);
+    }
+
+    mem_pool_file_header *header = __file_header(pool);
+    if (fresh) {
+        memcpy(header->magic, MEM_POOL_FILE_MAGIC, sizeof(MEM_POOL_FILE_MAGIC));
+        header->version = MEM_POOL_FILE_VERSION;
+        header->headersize = MEM_POOL_FILE_HEADER_SIZE;
+        header->used = MEM_POOL_FILE_HEADER_SIZE;
+        header->root = 0;
+    }
+    else if (pool->mapsize < MEM_POOL_FILE_HEADER_SIZE ||
+             memcmp(header->magic, MEM_POOL_FILE_MAGIC, sizeof(MEM_POOL_FILE_MAGIC)) ||
+             header->version != MEM_POOL_FILE_VERSION ||
+             header->headersize != MEM_POOL_FILE_HEADER_SIZE ||
+             header->used < MEM_POOL_FILE_HEADER_SIZE || header->used > pool->mapsize ||
+             header->root >= header->used) {
+        munmap(pool->base, pool->mapsize);
+        pool->base = NULL;
+        close(pool->fd);
+        pool->fd = -1;
+        return LOR_BAD_FILE_FORMAT_ERR;
+    }
+
+    return LOR_SUCCESS;
+}
+
+int Lor_mem_pool_file_close(Lor_mem_pool_file *pool)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    if (!pool->base) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+
+    int ret = LOR_SUCCESS;
+    size_t used = (size_t) __file_header(pool)->used;
+    if (pool->fd >= 0 && !pool->readonly) {
+        if (msync(pool->base, used, MS_SYNC)) {
+            LOR_PERROR("msync failed", __func__);
+            ret = LOR_FILE_IO_ERR;
+        }
+    }
+    munmap(pool->base, pool->mapsize);
+    if (pool->fd >= 0) {
+        if (!pool->readonly && ftruncate(pool->fd, (off_t) used)) {
+            LOR_PERROR("ftruncate failed", __func__);
+            ret = LOR_FILE_IO_ERR;
+        }
+        close(pool->fd);
+    }
+    *pool = (Lor_mem_pool_file){ .base = NULL, .fd = -1 };
+
+    return ret;
+}
+
+int Lor_mem_pool_file_destroy(Lor_mem_pool_file **pool)
+{
+    Lor_assert(*pool, __func__, "address of pointer 'pool' must be non-NULL");
+
+    if ((*pool)->base) {
+        return LOR_POSSIBLE_MEMLEAK_WARN;
+    }
+    free(*pool);
+    *pool = NULL;
+
+    return LOR_SUCCESS;
+}
+
+Lor_mem_pool_off Lor_mem_pool_file_alloc(Lor_mem_pool_file *pool, size_t len)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    if (pool->readonly || !len) {
+        return 0;
+    }
+
+    /* Check for size_t overflow and round up to a uintmax_t alignment */
+    size_t alignment = sizeof(uintmax_t) - (len & (sizeof(uintmax_t) - 1));
+    if (UNSIGNED_ADD_OVERFLOWS(len, alignment)) {
+        USIZE_OVERFLOW_MSG(len, alignment, __func__);
+        return 0;
+    }
+    else if (len & (sizeof(uintmax_t) - 1)) {
+        len += alignment;
+    }
+
+    mem_pool_file_header *header = __file_header(pool);
+    if (len > pool->mapsize - header->used) {
+        return 0;
+    }
+    Lor_mem_pool_off off = header->used;
+    header->used += len;
+    return off;
+}
+
+void *Lor_mem_pool_file_ptr(const Lor_mem_pool_file *pool, Lor_mem_pool_off off)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    return (off) ? pool->base + off : NULL;
+}
+
+Lor_mem_pool_off Lor_mem_pool_file_off(const Lor_mem_pool_file *pool, const void *mem)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+    Lor_assert(!mem || ((const char *) mem >= pool->base && (const char *) mem < pool->base + pool->mapsize),
+               __func__, "argument 'mem' must be in the mapping of 'pool'");
+
+    return (mem) ? (Lor_mem_pool_off) ((const char *) mem - pool->base) : 0;
+}
+
+bool Lor_mem_pool_file_is_readonly(const Lor_mem_pool_file *pool)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    return pool->readonly;
+}
+
+Lor_mem_pool_off Lor_mem_pool_file_get_root(const Lor_mem_pool_file *pool)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    return __file_header(pool)->root;
+}
+
+int Lor_mem_pool_file_set_root(Lor_mem_pool_file *pool, Lor_mem_pool_off root)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    if (pool->readonly) {
+        return LOR_READ_ONLY_ERR;
+    }
+    __file_header(pool)->root = root;
+    return LOR_SUCCESS;
+}
+
+size_t Lor_mem_pool_file_used(const Lor_mem_pool_file *pool)
+{
+    Lor_assert(pool && pool->base, __func__, "argument 'pool' must be an open pool");
+
+    return (size_t) __file_header(pool)->used;
+}
+
+/* End of File */
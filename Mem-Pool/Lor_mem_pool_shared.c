@@ -0,0 +1,252 @@
+/* C file:
+ *       Lor_mem_pool_shared.c
+ *
+ * Thread caching layer of the Lorena library memory pool.
+ *
+ * Every block of a shared pool is pushed once on a lock-free list, which
+ * is never popped until the pool is discarded, so it can be walked  by
+ * Lor_mem_pool_shared_contains while other threads are allocating.  The
+ * blocks that still have free space when a thread cache is destroyed are
+ * left in the depot slots, from which the other caches take them with an
+ * atomic exchange (no compare-and-swap on a popped pointer, so no  ABA).
+ */
+#include "Lor_mem_pool_def.h"
+#include <Lor_assert.h>
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+static size_t __st_add(jmp_buf, size_t, size_t);
+
+/**********************************************************
+ * Allocate a new block with 'blockalloc' bytes  of  space
+ * and push it on the list of blocks of the shared pool.
+ **********************************************************/
+static mem_pool_block *__shared_alloc_block(Lor_mem_pool_shared *pool, size_t blockalloc)
+{
+    /* Handling size_t overflow */
+    jmp_buf env;
+    int val = setjmp(env);
+    if (val == LOR_USIZE_OVERFLOW_ERR) {
+        USIZE_OVERFLOW_MSG(sizeof(mem_pool_block), blockalloc, __func__);
+        return NULL;
+    }
+    size_t szsum = __st_add(env, sizeof(mem_pool_block), blockalloc);
+
+    mem_pool_block *p = malloc(szsum);
+    if (!p) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+
+    p->mapsize = 0;
+    p->nlive = 0;
+    p->nextfree = (char *) p->space;
+    p->end = p->nextfree + blockalloc;
+    p->dirty = p->end;
+
+    mem_pool_block *head = atomic_load_explicit(&pool->mpblock, memory_order_relaxed);
+    do {
+        p->nextblock = head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->mpblock, &head, p,
+                                                    memory_order_release, memory_order_relaxed));
+
+    atomic_fetch_add_explicit(&pool->poolalloc, szsum, memory_order_relaxed);
+    return p;
+}
+
+/**********************************************************
+ * Leave 'block' in a free depot slot.  Returns false if all
+ * the slots are taken, in which case the remaining space of
+ * the block is given up.
+ **********************************************************/
+static bool __depot_put(Lor_mem_pool_shared *pool, size_t firstslot, mem_pool_block *block)
+{
+    for (size_t i = 0; i < LOR_MEM_POOL_DEPOT_SLOTS; i++) {
+        _Atomic(mem_pool_block *) *slot = &pool->depot[(firstslot + i) % LOR_MEM_POOL_DEPOT_SLOTS];
+        mem_pool_block *expected = NULL;
+        if (atomic_load_explicit(slot, memory_order_relaxed) == NULL &&
+            atomic_compare_exchange_strong_explicit(slot, &expected, block,
+                                                    memory_order_release, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**********************************************************
+ * Take from the depot a block with at least 'len' bytes  of
+ * free space.  Blocks that are too full are given up.
+ **********************************************************/
+static mem_pool_block *__depot_get(Lor_mem_pool_shared *pool, size_t firstslot, size_t len)
+{
+    for (size_t i = 0; i < LOR_MEM_POOL_DEPOT_SLOTS; i++) {
+        _Atomic(mem_pool_block *) *slot = &pool->depot[(firstslot + i) % LOR_MEM_POOL_DEPOT_SLOTS];
+        if (atomic_load_explicit(slot, memory_order_relaxed) == NULL) {
+            continue;
+        }
+        mem_pool_block *p = atomic_exchange_explicit(slot, NULL, memory_order_acquire);
+        if (p && (size_t) (p->end - p->nextfree) >= len) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+Lor_mem_pool_shared *Lor_mem_pool_shared_create(void)
+{
+    Lor_mem_pool_shared *pool = malloc(sizeof *pool);
+    if (!pool) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    return pool;
+}
+
+int Lor_mem_pool_shared_init(Lor_mem_pool_shared *pool, size_t blocksize)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    atomic_init(&pool->mpblock, NULL);
+    for (size_t i = 0; i < LOR_MEM_POOL_DEPOT_SLOTS; i++) {
+        atomic_init(&pool->depot[i], NULL);
+    }
+    atomic_init(&pool->poolalloc, 0);
+    atomic_init(&pool->ncaches, 0);
+    pool->blockalloc = (blocksize) ? blocksize : BLOCK_GROWTH_SIZE;
+
+    return LOR_SUCCESS;
+}
+
+int Lor_mem_pool_shared_destroy(Lor_mem_pool_shared **pool)
+{
+    Lor_assert(*pool, __func__, "address of pointer 'pool' must be non-NULL");
+
+    if (atomic_load(&(*pool)->mpblock)) {
+        return LOR_POSSIBLE_MEMLEAK_WARN;
+    }
+    free(*pool);
+
+    return LOR_SUCCESS;
+}
+
+int Lor_mem_pool_shared_discard(Lor_mem_pool_shared *pool, bool invalidate_mem)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+    Lor_assert(!atomic_load(&pool->ncaches), __func__, "every thread cache of 'pool' must be destroyed");
+
+    mem_pool_block *block = atomic_exchange(&pool->mpblock, NULL);
+    if (!block) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+
+    while (block) {
+        mem_pool_block *blocktofree = block;
+        block = block->nextblock;
+        if (invalidate_mem) {
+            memset(blocktofree->space, 0xDD, ((char *) blocktofree->end) - ((char *) blocktofree->space));
+        }
+        free(blocktofree);
+    }
+    for (size_t i = 0; i < LOR_MEM_POOL_DEPOT_SLOTS; i++) {
+        atomic_store(&pool->depot[i], NULL);
+    }
+    atomic_store(&pool->poolalloc, 0);
+
+    return LOR_SUCCESS;
+}
+
+bool Lor_mem_pool_shared_contains(Lor_mem_pool_shared *pool, void *mem)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    mem_pool_block *p = atomic_load_explicit(&pool->mpblock, memory_order_acquire);
+    for (; p; p = p->nextblock) {
+        if ((((void *) p->space) <= mem) && (mem < ((void *) p->end))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Lor_mem_pool_tcache *Lor_mem_pool_tcache_create(Lor_mem_pool_shared *pool)
+{
+    Lor_assert(pool, __func__, "argument 'pool' must be non-NULL");
+
+    Lor_mem_pool_tcache *cache = malloc(sizeof *cache);
+    if (!cache) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+
+    size_t n = atomic_fetch_add(&pool->ncaches, 1);
+    *cache = (Lor_mem_pool_tcache){ .pool = pool,
+                                    .current = NULL,
+                                    .depotslot = n % LOR_MEM_POOL_DEPOT_SLOTS,
+                              };
+    return cache;
+}
+
+int Lor_mem_pool_tcache_destroy(Lor_mem_pool_tcache **cache)
+{
+    if (!(*cache)) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+
+    Lor_mem_pool_shared *pool = (*cache)->pool;
+    mem_pool_block *p = (*cache)->current;
+    if (p && p->nextfree < p->end) {
+        __depot_put(pool, (*cache)->depotslot, p);
+    }
+    atomic_fetch_sub(&pool->ncaches, 1);
+    free(*cache);
+    *cache = NULL;
+
+    return LOR_SUCCESS;
+}
+
+void *Lor_mem_pool_tcache_alloc(Lor_mem_pool_tcache *cache, size_t len)
+{
+    Lor_assert(cache, __func__, "argument 'cache' must be non-NULL");
+
+    /* Check for size_t overflow and round up to a uintmax_t alignment */
+    size_t alignment = sizeof(uintmax_t) - (len & (sizeof(uintmax_t) - 1));
+    if (UNSIGNED_ADD_OVERFLOWS(len, alignment)) {
+        USIZE_OVERFLOW_MSG(len, alignment, __func__);
+        return NULL;
+    }
+    else if (len & (sizeof(uintmax_t) - 1)) {
+        len += alignment;
+    }
+
+    mem_pool_block *p = cache->current;
+    if (!p || (size_t) (p->end - p->nextfree) < len) {
+        Lor_mem_pool_shared *pool = cache->pool;
+        if (len >= (pool->blockalloc / 2)) {
+            /* Big allocations get a block of their own, the current block
+             * is kept */
+            mem_pool_block *tmp = __shared_alloc_block(pool, len);
+            if (!tmp) {
+                return NULL;
+            }
+            tmp->nextfree = tmp->end;
+            return tmp->space;
+        }
+        p = __depot_get(pool, cache->depotslot, len);
+        if (!p) {
+            p = __shared_alloc_block(pool, pool->blockalloc);
+            if (!p) {
+                return NULL;
+            }
+        }
+        cache->current = p;
+    }
+
+    void *retblock = p->nextfree;
+    p->nextfree += len;
+    return retblock;
+}
+
+/* End of File */
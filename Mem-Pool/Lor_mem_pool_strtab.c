@@ -0,0 +1,170 @@
+/* C file:
+ *       Lor_mem_pool_strtab.c
+ *
+ * String interning on top of the Lorena library memory pool.
+ *
+ * The table is a hash set with linear probing, kept at most half full.
+ * Each slot caches the hash and the length of its string, so a probe only
+ * compares the characters of strings that are very likely equal.
+ */
+#include "Lor_mem_pool_def.h"
+#include <Lor_assert.h>
+#include <Lor_error_log.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define STRTAB_MIN_CAPACITY 64
+
+/* 64 bit FNV-1a */
+static uint64_t __strtab_hash(const char *str, size_t len)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) str[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+/* Slot holding the string, or the empty slot where it would go */
+static mem_pool_strtab_slot *__strtab_probe(const Lor_mem_pool_strtab *tab, const char *str,
+                                            size_t len, uint64_t hash)
+{
+    size_t mask = tab->capacity - 1;
+    for (size_t i = (size_t) hash & mask; ; i = (i + 1) & mask) {
+        mem_pool_strtab_slot *slot = &tab->slots[i];
+        if (!slot->str || (slot->hash == hash && slot->len == len && !memcmp(slot->str, str, len))) {
+            return slot;
+        }
+    }
+}
+
+static bool __strtab_grow(Lor_mem_pool_strtab *tab)
+{
+    size_t capacity = (tab->capacity) ? 2 * tab->capacity : STRTAB_MIN_CAPACITY;
+    if (UNSIGNED_MULT_OVERFLOWS(capacity, sizeof(*tab->slots))) {
+        USIZE_OVERFLOW_MSG(capacity, sizeof(*tab->slots), __func__);
+        return false;
+    }
+    mem_pool_strtab_slot *slots = calloc(capacity, sizeof(*slots));
+    if (!slots) {
+        LOR_PERROR("calloc failed", __func__);
+        return false;
+    }
+
+    mem_pool_strtab_slot *oldslots = tab->slots;
+    size_t oldcapacity = tab->capacity;
+    tab->slots = slots;
+    tab->capacity = capacity;
+    for (size_t i = 0; i < oldcapacity; i++) {
+        if (oldslots[i].str) {
+            *__strtab_probe(tab, oldslots[i].str, oldslots[i].len, oldslots[i].hash) = oldslots[i];
+        }
+    }
+    free(oldslots);
+    return true;
+}
+
+Lor_mem_pool_strtab *Lor_mem_pool_strtab_create(void)
+{
+    Lor_mem_pool_strtab *tab = malloc(sizeof *tab);
+    if (!tab) {
+        LOR_PERROR("malloc failed", __func__);
+        return NULL;
+    }
+    *tab = (Lor_mem_pool_strtab){ .slots = NULL };
+    return tab;
+}
+
+int Lor_mem_pool_strtab_init(Lor_mem_pool_strtab *tab, Lor_mem_pool *pool)
+{
+    Lor_assert(tab && pool, __func__, "arguments 'tab' and 'pool' must be non-NULL");
+
+    *tab = (Lor_mem_pool_strtab){ .pool = pool,
+                                  .slots = NULL,
+                                  .capacity = 0,
+                                  .nstrings = 0,
+                            };
+    return LOR_SUCCESS;
+}
+
+int Lor_mem_pool_strtab_clear(Lor_mem_pool_strtab *tab)
+{
+    Lor_assert(tab, __func__, "argument 'tab' must be non-NULL");
+
+    if (!tab->slots) {
+        return LOR_FREE_NULLPTR_WARN;
+    }
+    free(tab->slots);
+    tab->slots = NULL;
+    tab->capacity = tab->nstrings = 0;
+
+    return LOR_SUCCESS;
+}
+
+int Lor_mem_pool_strtab_destroy(Lor_mem_pool_strtab **tab)
+{
+    Lor_assert(*tab, __func__, "address of pointer 'tab' must be non-NULL");
+
+    if ((*tab)->slots) {
+        return LOR_POSSIBLE_MEMLEAK_WARN;
+    }
+    free(*tab);
+    *tab = NULL;
+
+    return LOR_SUCCESS;
+}
+
+const char *Lor_mem_pool_strtab_internn(Lor_mem_pool_strtab *tab, const char *str, size_t len)
+{
+    Lor_assert(tab && str, __func__, "arguments 'tab' and 'str' must be non-NULL");
+
+    const char *nul = memchr(str, '\0', len);
+    if (nul) {
+        len = nul - str;
+    }
+    if (2 * (tab->nstrings + 1) > tab->capacity && !__strtab_grow(tab)) {
+        return NULL;
+    }
+
+    uint64_t hash = __strtab_hash(str, len);
+    mem_pool_strtab_slot *slot = __strtab_probe(tab, str, len, hash);
+    if (!slot->str) {
+        char *copy = Lor_mem_pool_strndup(tab->pool, str, len);
+        if (!copy) {
+            return NULL;
+        }
+        *slot = (mem_pool_strtab_slot){ .str = copy, .len = len, .hash = hash };
+        tab->nstrings++;
+    }
+    return slot->str;
+}
+
+const char *Lor_mem_pool_strtab_intern(Lor_mem_pool_strtab *tab, const char *str)
+{
+    Lor_assert(str, __func__, "argument 'str' must be non-NULL");
+
+    return Lor_mem_pool_strtab_internn(tab, str, strlen(str));
+}
+
+const char *Lor_mem_pool_strtab_lookup(const Lor_mem_pool_strtab *tab, const char *str)
+{
+    Lor_assert(tab && str, __func__, "arguments 'tab' and 'str' must be non-NULL");
+
+    if (!tab->nstrings) {
+        return NULL;
+    }
+    size_t len = strlen(str);
+    return __strtab_probe(tab, str, len, __strtab_hash(str, len))->str;
+}
+
+size_t Lor_mem_pool_strtab_count(const Lor_mem_pool_strtab *tab)
+{
+    Lor_assert(tab, __func__, "argument 'tab' must be non-NULL");
+
+    return tab->nstrings;
+}
+
+/* End of File */
@@ -13,6 +13,10 @@
 #include <cmocka.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 typedef struct {
     int d;
@@ -24,6 +28,18 @@ static void TEST_MEM_POOL_ALLOC(void **state);
 static void TEST_MEM_POOL_CONTAINS(void **state);
 static void TEST_MEM_POOL_STRDUP(void **state);
 static void TEST_MEM_POOL_COMBINE(void **state);
+static void TEST_MEM_POOL_SLAB(void **state);
+static void TEST_MEM_POOL_SHARED(void **state);
+static void TEST_MEM_POOL_MMAP(void **state);
+static void TEST_MEM_POOL_CONTAINS_INDEX(void **state);
+static void TEST_MEM_POOL_REWIND(void **state);
+static void TEST_MEM_POOL_COMBINE_REWIND(void **state);
+static void TEST_MEM_POOL_PARTIAL_REUSE(void **state);
+static void TEST_MEM_POOL_ALIGNED_ALLOC(void **state);
+static void TEST_MEM_POOL_TRIM(void **state);
+static void TEST_MEM_POOL_TRIM_REWIND(void **state);
+static void TEST_MEM_POOL_FILE(void **state);
+static void TEST_MEM_POOL_STRTAB(void **state);
 
 static int setup(void **state);
 static int tear_down(void **state);
@@ -119,6 +135,16 @@ static void TEST_MEM_POOL_COMBINE(void **state)
     assert_non_null(pool2);
     assert_int_equal(Lor_mem_pool_init(pool2, 1024), LOR_SUCCESS);
 
+    /* Released slab objects of both pools are kept by 'dst' */
+    void *objs[6];
+    for (size_t i = 0; i < 6; i++) {
+        objs[i] = Lor_mem_pool_slab_alloc((i < 3) ? pool1 : pool2, 24);
+        assert_non_null(objs[i]);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        Lor_mem_pool_slab_free((i < 3) ? pool1 : pool2, objs[i], 24);
+    }
+
     size_t szsum = pool1->poolalloc + pool2->poolalloc;
     void *mem = (void *) pool2->mpblock->space;
     assert_int_equal(Lor_mem_pool_combine(pool1, pool2), LOR_SUCCESS);
@@ -126,11 +152,669 @@ static void TEST_MEM_POOL_COMBINE(void **state)
 
     assert_int_equal(szsum, pool1->poolalloc);
     assert_true(Lor_mem_pool_contains(pool1, mem));
+    for (size_t i = 6; i-- > 0;) {
+        assert_ptr_equal(Lor_mem_pool_slab_alloc(pool1, 24), objs[i]);
+    }
+    Lor_mem_pool_slab_free(pool1, objs[0], 24);
+    assert_ptr_equal(Lor_mem_pool_slab_alloc(pool1, 24), objs[0]);
 
     assert_int_equal(Lor_mem_pool_discard(pool1, false), LOR_SUCCESS);
     assert_int_equal(Lor_mem_pool_destroy(&pool1), LOR_SUCCESS);
 }
 
+static void TEST_MEM_POOL_SLAB(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+
+    void *objs[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        objs[i] = Lor_mem_pool_slab_alloc(pool, 30);
+        assert_non_null(objs[i]);
+        memset(objs[i], 0xAB, 30);
+    }
+    size_t poolalloc = pool->poolalloc;
+
+    /* Churn: released objects must be recycled, the pool must not grow */
+    for (size_t round = 0; round < 10; round++) {
+        for (size_t i = 0; i < 1000; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 30);
+        }
+        for (size_t i = 0; i < 1000; i++) {
+            objs[i] = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_non_null(objs[i]);
+            assert_true(Lor_mem_pool_contains(pool, objs[i]));
+        }
+    }
+    assert_int_equal(pool->poolalloc, poolalloc);
+
+    /* A different size class is not served from the 32 bytes list */
+    Lor_mem_pool_slab_free(pool, objs[0], 32);
+    assert_ptr_not_equal(Lor_mem_pool_slab_alloc(pool, 64), objs[0]);
+    assert_ptr_equal(Lor_mem_pool_slab_alloc(pool, 25), objs[0]);
+
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+#define NTHREADS 8
+#define NALLOCS  20000
+
+typedef struct {
+    Lor_mem_pool_shared *pool;
+    size_t id;
+    size_t *objs[NALLOCS];
+} ThreadArg;
+
+static void *shared_pool_worker(void *arg)
+{
+    ThreadArg *targ = arg;
+    Lor_mem_pool_tcache *cache = Lor_mem_pool_tcache_create(targ->pool);
+    if (!cache) {
+        return NULL;
+    }
+    for (size_t i = 0; i < NALLOCS; i++) {
+        /* mix small and block sized allocations */
+        size_t len = (i % 1000 == 999) ? 4096 : 3 * sizeof(size_t);
+        targ->objs[i] = Lor_mem_pool_tcache_alloc(cache, len);
+        if (!targ->objs[i]) {
+            break;
+        }
+        targ->objs[i][0] = targ->id;
+        targ->objs[i][2] = i;
+    }
+    Lor_mem_pool_tcache_destroy(&cache);
+    return NULL;
+}
+
+static void TEST_MEM_POOL_SHARED(void **state)
+{
+    Lor_mem_pool_shared *pool = Lor_mem_pool_shared_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_shared_init(pool, 8192), LOR_SUCCESS);
+
+    static ThreadArg args[NTHREADS];
+    pthread_t threads[NTHREADS];
+    for (size_t round = 0; round < 2; round++) {
+        for (size_t t = 0; t < NTHREADS; t++) {
+            args[t].pool = pool;
+            args[t].id = t;
+            assert_int_equal(pthread_create(&threads[t], NULL, shared_pool_worker, &args[t]), 0);
+        }
+        for (size_t t = 0; t < NTHREADS; t++) {
+            assert_int_equal(pthread_join(threads[t], NULL), 0);
+        }
+        /* No allocation was handed to two threads */
+        for (size_t t = 0; t < NTHREADS; t++) {
+            for (size_t i = 0; i < NALLOCS; i++) {
+                assert_non_null(args[t].objs[i]);
+                assert_int_equal(args[t].objs[i][0], t);
+                assert_int_equal(args[t].objs[i][2], i);
+                assert_true(Lor_mem_pool_shared_contains(pool, args[t].objs[i]));
+            }
+        }
+    }
+
+    void *mem = malloc(64);
+    assert_non_null(mem);
+    assert_false(Lor_mem_pool_shared_contains(pool, mem));
+    free(mem);
+
+    assert_int_equal(Lor_mem_pool_shared_destroy(&pool), LOR_POSSIBLE_MEMLEAK_WARN);
+    assert_int_equal(Lor_mem_pool_shared_discard(pool, true), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_shared_discard(pool, false), LOR_FREE_NULLPTR_WARN);
+    assert_int_equal(Lor_mem_pool_shared_destroy(&pool), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_MMAP(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+
+    const Lor_mem_pool_options opts = {
+        .growthsize = 64*1024,
+        .flags = LOR_MEM_POOL_HUGEPAGES | LOR_MEM_POOL_POPULATE,
+    };
+    assert_int_equal(Lor_mem_pool_init_with_options(pool, 4096, &opts), LOR_SUCCESS);
+    assert_true(pool->flags & LOR_MEM_POOL_MMAP);
+    assert_int_equal(pool->blockalloc, 64*1024);
+    assert_true(pool->mpblock->mapsize >= 4096 + sizeof(mem_pool_block));
+
+    for (size_t i = 0; i < 1000; i++) {
+        UserType *ut = Lor_mem_pool_calloc(pool, 1, sizeof *ut);
+        assert_non_null(ut);
+        assert_int_equal(ut->d, 0);
+        assert_string_equal(ut->s, "");
+        ut->d = INT_MAX;
+        strcpy(ut->s, "TEST STRING");
+        assert_true(Lor_mem_pool_contains(pool, ut));
+    }
+
+    /* Allocations bigger than half the growth size get their own block */
+    char *big = Lor_mem_pool_alloc(pool, 1024*1024);
+    assert_non_null(big);
+    assert_true(Lor_mem_pool_contains(pool, big));
+    assert_true(Lor_mem_pool_contains(pool, big + 1024*1024 - 1));
+    memset(big, 0xCC, 1024*1024);
+
+    assert_int_equal(Lor_mem_pool_discard(pool, true), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_CONTAINS_INDEX(void **state)
+{
+    Lor_mem_pool *pools[3];
+    const Lor_mem_pool_options opts = { .growthsize = 256 };
+    char *objs[3][500];
+    for (size_t p = 0; p < 3; p++) {
+        pools[p] = Lor_mem_pool_create();
+        assert_non_null(pools[p]);
+        assert_int_equal(Lor_mem_pool_init_with_options(pools[p], 256, &opts), LOR_SUCCESS);
+        for (size_t i = 0; i < 500; i++) {
+            objs[p][i] = Lor_mem_pool_alloc(pools[p], 100);
+            assert_non_null(objs[p][i]);
+        }
+        assert_true(pools[p]->nblocks > 100);
+    }
+
+    for (size_t p = 0; p < 3; p++) {
+        for (size_t i = 0; i < 500; i++) {
+            for (size_t q = 0; q < 3; q++) {
+                assert_true(Lor_mem_pool_contains(pools[q], objs[p][i]) == (p == q));
+            }
+        }
+        for (mem_pool_block *b = pools[p]->mpblock; b; b = b->nextblock) {
+            assert_true(Lor_mem_pool_contains(pools[p], b->space));
+            assert_true(Lor_mem_pool_contains(pools[p], b->end - 1));
+            assert_false(Lor_mem_pool_contains(pools[p], b));
+        }
+    }
+
+    size_t nblocks = pools[0]->nblocks + pools[1]->nblocks;
+    assert_int_equal(Lor_mem_pool_combine(pools[0], pools[1]), LOR_SUCCESS);
+    assert_int_equal(pools[0]->nblocks, nblocks);
+    assert_int_equal(Lor_mem_pool_combine(pools[0], pools[1]), LOR_SRC_EMPTY_WARN);
+    assert_int_equal(Lor_mem_pool_destroy(&pools[1]), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_combine(pools[0], pools[2]), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pools[2]), LOR_SUCCESS);
+
+    size_t n = 0;
+    for (mem_pool_block *b = pools[0]->mpblock; b; b = b->nextblock) {
+        n++;
+        if (!b->nextblock) {
+            assert_ptr_equal(b, pools[0]->lastblock);
+        }
+    }
+    assert_int_equal(n, pools[0]->nblocks);
+    for (size_t p = 0; p < 3; p++) {
+        for (size_t i = 0; i < 500; i++) {
+            assert_true(Lor_mem_pool_contains(pools[0], objs[p][i]));
+        }
+    }
+
+    assert_int_equal(Lor_mem_pool_discard(pools[0], false), LOR_SUCCESS);
+    assert_false(Lor_mem_pool_contains(pools[0], objs[0][0]));
+    assert_int_equal(Lor_mem_pool_destroy(&pools[0]), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_REWIND(void **state)
+{
+    for (size_t backing = 0; backing < 2; backing++) {
+        Lor_mem_pool *pool = Lor_mem_pool_create();
+        assert_non_null(pool);
+        const Lor_mem_pool_options opts = {
+            .growthsize = 1024,
+            .flags = (backing) ? LOR_MEM_POOL_MMAP : 0,
+        };
+        assert_int_equal(Lor_mem_pool_init_with_options(pool, 512, &opts), LOR_SUCCESS);
+        assert_non_null(Lor_mem_pool_alloc(pool, 100));
+
+        Lor_mem_pool_savepoint outer, inner;
+        Lor_mem_pool_mark(pool, &outer);
+        size_t poolalloc = pool->poolalloc;
+        size_t nblocks = pool->nblocks;
+
+        char *first = Lor_mem_pool_alloc(pool, 64);
+        assert_non_null(first);
+        memset(first, 0xEE, 64);
+        for (size_t i = 0; i < 100; i++) {
+            assert_non_null(Lor_mem_pool_alloc(pool, 48));
+        }
+        Lor_mem_pool_mark(pool, &inner);
+        size_t innerpoolalloc = pool->poolalloc;
+        char *afterinner = Lor_mem_pool_alloc(pool, 48);
+        assert_non_null(Lor_mem_pool_alloc(pool, 4096));  /* big block */
+        for (size_t i = 0; i < 100; i++) {
+            assert_non_null(Lor_mem_pool_slab_alloc(pool, 48));
+        }
+
+        assert_int_equal(Lor_mem_pool_rewind(pool, &inner), LOR_SUCCESS);
+        assert_int_equal(pool->poolalloc, innerpoolalloc);
+        assert_ptr_equal(Lor_mem_pool_alloc(pool, 48), afterinner);
+
+        assert_int_equal(Lor_mem_pool_rewind(pool, &outer), LOR_SUCCESS);
+        assert_int_equal(pool->poolalloc, poolalloc);
+        assert_int_equal(pool->nblocks, nblocks);
+
+        /* The rolled back memory is handed out again, and cleared by calloc */
+        char *again = Lor_mem_pool_calloc(pool, 1, 64);
+        assert_ptr_equal(again, first);
+        for (size_t i = 0; i < 64; i++) {
+            assert_int_equal(again[i], 0);
+        }
+
+        assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+        assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+    }
+}
+
+static void TEST_MEM_POOL_COMBINE_REWIND(void **state)
+{
+    Lor_mem_pool *dst = Lor_mem_pool_create();
+    assert_non_null(dst);
+    assert_int_equal(Lor_mem_pool_init(dst, 256), LOR_SUCCESS);
+
+    Lor_mem_pool *src = Lor_mem_pool_create();
+    assert_non_null(src);
+    const Lor_mem_pool_options opts = { .growthsize = 1024 };
+    assert_int_equal(Lor_mem_pool_init_with_options(src, 1024, &opts), LOR_SUCCESS);
+    /* 'src' numbers more blocks than 'dst' */
+    char *mem[20];
+    for (size_t i = 0; i < 20; i++) {
+        mem[i] = Lor_mem_pool_alloc(src, (i % 5 == 4) ? 4096 : 400);
+        assert_non_null(mem[i]);
+        memset(mem[i], (int) i, 400);
+    }
+
+    assert_int_equal(Lor_mem_pool_combine(dst, src), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&src), LOR_SUCCESS);
+    size_t poolalloc = dst->poolalloc;
+    size_t nblocks = dst->nblocks;
+
+    /* Rewinding undoes only what was allocated after the mark */
+    for (size_t round = 0; round < 2; round++) {
+        Lor_mem_pool_savepoint sp;
+        Lor_mem_pool_mark(dst, &sp);
+        if (round) {
+            for (size_t i = 0; i < 10; i++) {
+                assert_non_null(Lor_mem_pool_alloc(dst, (i % 5) ? 400 : 4096));
+            }
+        }
+        assert_int_equal(Lor_mem_pool_rewind(dst, &sp), LOR_SUCCESS);
+        assert_int_equal(dst->poolalloc, poolalloc);
+        assert_int_equal(dst->nblocks, nblocks);
+    }
+    for (size_t i = 0; i < 20; i++) {
+        assert_true(Lor_mem_pool_contains(dst, mem[i]));
+        for (size_t j = 0; j < 400; j++) {
+            assert_int_equal(mem[i][j], (char) i);
+        }
+    }
+
+    assert_int_equal(Lor_mem_pool_discard(dst, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&dst), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_PARTIAL_REUSE(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    const Lor_mem_pool_options opts = { .growthsize = 1024 };
+    assert_int_equal(Lor_mem_pool_init_with_options(pool, 1024, &opts), LOR_SUCCESS);
+
+    assert_non_null(Lor_mem_pool_alloc(pool, 400));
+    char *second = Lor_mem_pool_alloc(pool, 400);
+    assert_non_null(second);
+    /* Does not fit in the first block, which is kept with 224 bytes left */
+    assert_non_null(Lor_mem_pool_alloc(pool, 504));
+    assert_non_null(Lor_mem_pool_alloc(pool, 504));
+    /* Neither fits in the head block, served from the first block */
+    assert_ptr_equal(Lor_mem_pool_alloc(pool, 200), second + 400);
+    assert_int_equal(pool->nblocks, 2);
+
+    Lor_mem_pool_savepoint sp;
+    Lor_mem_pool_mark(pool, &sp);
+    Lor_mem_pool_stats stats;
+    Lor_mem_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.nblocks, 2);
+    assert_int_equal(stats.used, 2008);
+    assert_int_equal(stats.available, 40);
+    assert_int_equal(stats.wasted, 0);
+
+    /* Fill more blocks than there are partial slots: the space left in the
+     * blocks that are not kept is accounted as wasted */
+    for (size_t i = 0; i < 4 * LOR_MEM_POOL_PARTIAL_SLOTS; i++) {
+        assert_non_null(Lor_mem_pool_alloc(pool, 496));
+        assert_non_null(Lor_mem_pool_alloc(pool, 496));
+    }
+    Lor_mem_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.nblocks, pool->nblocks);
+    assert_int_equal(stats.poolalloc, pool->poolalloc);
+    assert_true(stats.wasted > 0);
+    assert_int_equal(stats.used + stats.available + stats.wasted,
+                     stats.poolalloc - stats.nblocks * sizeof(mem_pool_block));
+
+    /* Rewinding restores the partially used blocks */
+    assert_int_equal(Lor_mem_pool_rewind(pool, &sp), LOR_SUCCESS);
+    Lor_mem_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.nblocks, 2);
+    assert_int_equal(stats.used, 2008);
+    assert_int_equal(stats.available, 40);
+    assert_ptr_equal(Lor_mem_pool_alloc(pool, 24), second + 600);
+
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    Lor_mem_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.nblocks, 0);
+    assert_int_equal(stats.used + stats.available + stats.wasted, 0);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_ALIGNED_ALLOC(void **state)
+{
+    for (size_t backing = 0; backing < 2; backing++) {
+        Lor_mem_pool *pool = Lor_mem_pool_create();
+        assert_non_null(pool);
+        const Lor_mem_pool_options opts = {
+            .growthsize = 2048,
+            .flags = (backing) ? LOR_MEM_POOL_MMAP : 0,
+        };
+        assert_int_equal(Lor_mem_pool_init_with_options(pool, 2048, &opts), LOR_SUCCESS);
+
+        for (size_t align = 1; align <= LOR_MEM_POOL_MAX_ALIGNMENT; align <<= 1) {
+            for (size_t i = 0; i < 20; i++) {
+                assert_non_null(Lor_mem_pool_alloc(pool, 8));
+                size_t len = 1 + (i * 37) % 1500;
+                char *p = Lor_mem_pool_aligned_alloc(pool, len, align);
+                assert_non_null(p);
+                assert_int_equal((uintptr_t) p % align, 0);
+                assert_true(Lor_mem_pool_contains(pool, p));
+                assert_true(Lor_mem_pool_contains(pool, p + len - 1));
+                memset(p, 0xAB, len);
+            }
+        }
+
+        /* Released slab objects are reused only when suitably aligned */
+        char *objs[64];
+        for (size_t i = 0; i < 64; i++) {
+            objs[i] = Lor_mem_pool_slab_alloc(pool, 40);
+            assert_non_null(objs[i]);
+        }
+        for (size_t i = 0; i < 64; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 40);
+        }
+        for (size_t i = 0; i < 64; i++) {
+            char *p = Lor_mem_pool_slab_aligned_alloc(pool, 40, 64);
+            assert_non_null(p);
+            assert_int_equal((uintptr_t) p % 64, 0);
+        }
+
+        assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+        assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+    }
+}
+
+static void TEST_MEM_POOL_TRIM(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 1024), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_trim(pool), LOR_NOT_TRACKING_LIVE_ERR);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+
+    for (size_t backing = 0; backing < 2; backing++) {
+        const Lor_mem_pool_options opts = {
+            .growthsize = 4096,
+            .flags = LOR_MEM_POOL_TRACK_LIVE | ((backing) ? LOR_MEM_POOL_MMAP : 0),
+            .retainsize = 2 * (4096 + sizeof(mem_pool_block)),
+        };
+        assert_int_equal(Lor_mem_pool_init_with_options(pool, 4096, &opts), LOR_SUCCESS);
+        char *pinned = Lor_mem_pool_strdup(pool, "pinned");
+        assert_non_null(pinned);
+
+        /* Peak */
+        static void *objs[4000];
+        for (size_t i = 0; i < 4000; i++) {
+            objs[i] = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_non_null(objs[i]);
+        }
+        size_t peak = pool->poolalloc;
+        size_t nblocks = pool->nblocks;
+        assert_true(nblocks > 10);
+
+        /* Shrink by 90% */
+        for (size_t i = 0; i < 3600; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 32);
+        }
+        assert_int_equal(Lor_mem_pool_trim(pool), LOR_SUCCESS);
+        assert_true(pool->poolalloc < peak / 2);
+        assert_true(pool->nblocks < nblocks / 2);
+        assert_true(Lor_mem_pool_contains(pool, pinned));
+        assert_string_equal(pinned, "pinned");
+        for (size_t i = 3600; i < 4000; i++) {
+            assert_true(Lor_mem_pool_contains(pool, objs[i]));
+        }
+        Lor_mem_pool_stats stats;
+        Lor_mem_pool_get_stats(pool, &stats);
+        assert_int_equal(stats.poolalloc, pool->poolalloc);
+        assert_int_equal(stats.nblocks, pool->nblocks);
+
+        /* The pool keeps working, and a second trim has nothing to do */
+        for (size_t i = 0; i < 3600; i++) {
+            objs[i] = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_non_null(objs[i]);
+            memset(objs[i], 0x5A, 32);
+        }
+        for (size_t i = 0; i < 4000; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 32);
+        }
+        assert_int_equal(Lor_mem_pool_trim(pool), LOR_SUCCESS);
+        size_t trimmed = pool->poolalloc;
+        assert_int_equal(Lor_mem_pool_trim(pool), LOR_SUCCESS);
+        assert_int_equal(pool->poolalloc, trimmed);
+        assert_true(Lor_mem_pool_contains(pool, pinned));
+
+        assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    }
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
+
+static bool is_one_of(void *p, void **objs, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (p == objs[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void TEST_MEM_POOL_TRIM_REWIND(void **state)
+{
+    for (size_t backing = 0; backing < 2; backing++) {
+        Lor_mem_pool *pool = Lor_mem_pool_create();
+        assert_non_null(pool);
+        const Lor_mem_pool_options opts = {
+            .growthsize = 1024,
+            .flags = LOR_MEM_POOL_TRACK_LIVE | ((backing) ? LOR_MEM_POOL_MMAP : 0),
+        };
+        assert_int_equal(Lor_mem_pool_init_with_options(pool, 1024, &opts), LOR_SUCCESS);
+
+        /* Several blocks, the head one holding the only object that is kept */
+        void *objs[200];
+        for (size_t i = 0; i < 200; i++) {
+            objs[i] = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_non_null(objs[i]);
+        }
+        char *pinned = Lor_mem_pool_slab_alloc(pool, 32);
+        assert_non_null(pinned);
+        strcpy(pinned, "pinned");
+        size_t poolalloc = pool->poolalloc;
+        size_t nblocks = pool->nblocks;
+        assert_true(nblocks > 1);
+        for (size_t i = 0; i < 50; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 32);
+        }
+
+        Lor_mem_pool_savepoint sp;
+        Lor_mem_pool_mark(pool, &sp);
+        /* The objects released before the mark are set aside */
+        void *temp[200];
+        for (size_t i = 0; i < 200; i++) {
+            temp[i] = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_non_null(temp[i]);
+            assert_false(is_one_of(temp[i], objs, 50));
+        }
+        for (size_t i = 0; i < 200; i += 2) {
+            Lor_mem_pool_slab_free(pool, temp[i], 32);
+        }
+        for (size_t i = 50; i < 200; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 32);
+        }
+        assert_int_equal(Lor_mem_pool_rewind(pool, &sp), LOR_SUCCESS);
+
+        /* Only the pinned object is live, and every object released before
+         * the rewind is handed out again */
+        assert_int_equal(pool->poolalloc, poolalloc);
+        assert_int_equal(pool->nblocks, nblocks);
+        size_t nlive = 0;
+        for (mem_pool_block *p = pool->mpblock; p; p = p->nextblock) {
+            nlive += p->nlive;
+        }
+        assert_int_equal(nlive, 1);
+        for (size_t i = 0; i < 200; i++) {
+            void *p = Lor_mem_pool_slab_alloc(pool, 32);
+            assert_true(is_one_of(p, objs, 200));
+            memset(p, 0x5A, 32);
+        }
+        for (size_t i = 0; i < 200; i++) {
+            Lor_mem_pool_slab_free(pool, objs[i], 32);
+        }
+
+        /* So trimming releases the blocks the rewind emptied */
+        assert_int_equal(Lor_mem_pool_trim(pool), LOR_SUCCESS);
+        assert_int_equal(pool->nblocks, 1);
+        assert_true(pool->poolalloc < poolalloc);
+        assert_true(Lor_mem_pool_contains(pool, pinned));
+        assert_string_equal(pinned, "pinned");
+
+        assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+        assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+    }
+}
+
+static void TEST_MEM_POOL_FILE(void **state)
+{
+    char path[] = "/tmp/MP-utesting-XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+    close(fd);
+
+    Lor_mem_pool_file *pool = Lor_mem_pool_file_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 16, LOR_MEM_POOL_FILE_CREATE), LOR_ZERO_SIZE_ALLOC_ERR);
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 1 << 20, LOR_MEM_POOL_FILE_CREATE), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_get_root(pool), 0);
+
+    Lor_mem_pool_off offs[100];
+    for (size_t i = 0; i < 100; i++) {
+        offs[i] = Lor_mem_pool_file_alloc(pool, sizeof(size_t) + i);
+        assert_true(offs[i] != 0);
+        assert_int_equal(offs[i] % sizeof(uintmax_t), 0);
+        size_t *p = Lor_mem_pool_file_ptr(pool, offs[i]);
+        *p = i * i;
+        assert_int_equal(Lor_mem_pool_file_off(pool, p), offs[i]);
+    }
+    assert_int_equal(Lor_mem_pool_file_alloc(pool, 1 << 20), 0);  /* full */
+    assert_int_equal(Lor_mem_pool_file_set_root(pool, offs[42]), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_destroy(&pool), LOR_POSSIBLE_MEMLEAK_WARN);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_FREE_NULLPTR_WARN);
+
+    /* The file is truncated to the bytes used, and mapped again read-only */
+    struct stat st;
+    assert_int_equal(stat(path, &st), 0);
+    assert_true(st.st_size < 1 << 20);
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 0, LOR_MEM_POOL_FILE_READONLY), LOR_SUCCESS);
+    assert_true(Lor_mem_pool_file_is_readonly(pool));
+    assert_int_equal(Lor_mem_pool_file_get_root(pool), offs[42]);
+    for (size_t i = 0; i < 100; i++) {
+        assert_int_equal(*(size_t *) Lor_mem_pool_file_ptr(pool, offs[i]), i * i);
+    }
+    assert_int_equal(Lor_mem_pool_file_alloc(pool, 8), 0);
+    assert_int_equal(Lor_mem_pool_file_set_root(pool, 0), LOR_READ_ONLY_ERR);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+
+    /* Reopened for writing, the allocations go on after the used bytes */
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 1 << 16, 0), LOR_SUCCESS);
+    Lor_mem_pool_off off = Lor_mem_pool_file_alloc(pool, 8);
+    assert_true(off > offs[99]);
+    assert_int_equal(*(size_t *) Lor_mem_pool_file_ptr(pool, offs[7]), 49);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+
+    /* Not a pool file */
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert_true(fd >= 0);
+    assert_int_equal(write(fd, "not a pool file, not a pool file, not a pool file, not a pool file", 66), 66);
+    close(fd);
+    assert_int_equal(Lor_mem_pool_file_open(pool, path, 0, LOR_MEM_POOL_FILE_READONLY), LOR_BAD_FILE_FORMAT_ERR);
+    unlink(path);
+
+    /* Shared anonymous mapping */
+    assert_int_equal(Lor_mem_pool_file_open(pool, NULL, 4096, 0), LOR_SUCCESS);
+    off = Lor_mem_pool_file_alloc(pool, 4000);
+    assert_true(off != 0);
+    memset(Lor_mem_pool_file_ptr(pool, off), 0x11, 4000);
+    assert_int_equal(Lor_mem_pool_file_alloc(pool, 4000), 0);
+    assert_int_equal(Lor_mem_pool_file_close(pool), LOR_SUCCESS);
+
+    assert_int_equal(Lor_mem_pool_file_destroy(&pool), LOR_SUCCESS);
+}
+
+static void TEST_MEM_POOL_STRTAB(void **state)
+{
+    Lor_mem_pool *pool = Lor_mem_pool_create();
+    assert_non_null(pool);
+    assert_int_equal(Lor_mem_pool_init(pool, 4096), LOR_SUCCESS);
+    Lor_mem_pool_strtab *tab = Lor_mem_pool_strtab_create();
+    assert_non_null(tab);
+    assert_int_equal(Lor_mem_pool_strtab_init(tab, pool), LOR_SUCCESS);
+    assert_null(Lor_mem_pool_strtab_lookup(tab, "key"));
+
+    static const char *interned[5000];
+    char buf[32];
+    for (size_t i = 0; i < 5000; i++) {
+        snprintf(buf, sizeof buf, "key-%zu", i);
+        interned[i] = Lor_mem_pool_strtab_intern(tab, buf);
+        assert_non_null(interned[i]);
+        assert_ptr_not_equal(interned[i], buf);
+        assert_string_equal(interned[i], buf);
+        assert_true(Lor_mem_pool_contains(pool, (void *) interned[i]));
+    }
+    assert_int_equal(Lor_mem_pool_strtab_count(tab), 5000);
+
+    /* Equal strings share the canonical copy */
+    size_t poolalloc = pool->poolalloc;
+    for (size_t i = 0; i < 5000; i++) {
+        snprintf(buf, sizeof buf, "key-%zu", i);
+        assert_ptr_equal(Lor_mem_pool_strtab_intern(tab, buf), interned[i]);
+        assert_ptr_equal(Lor_mem_pool_strtab_lookup(tab, buf), interned[i]);
+    }
+    assert_int_equal(pool->poolalloc, poolalloc);
+    assert_int_equal(Lor_mem_pool_strtab_count(tab), 5000);
+    assert_ptr_equal(Lor_mem_pool_strtab_internn(tab, "key-12345", 5), interned[1]);
+    assert_ptr_equal(Lor_mem_pool_strtab_internn(tab, "key-7", 64), interned[7]);
+    assert_null(Lor_mem_pool_strtab_lookup(tab, "key-5000"));
+    assert_string_equal(Lor_mem_pool_strtab_intern(tab, ""), "");
+
+    assert_int_equal(Lor_mem_pool_strtab_destroy(&tab), LOR_POSSIBLE_MEMLEAK_WARN);
+    assert_int_equal(Lor_mem_pool_strtab_clear(tab), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_strtab_clear(tab), LOR_FREE_NULLPTR_WARN);
+    assert_string_equal(interned[4999], "key-4999");
+    assert_int_equal(Lor_mem_pool_strtab_destroy(&tab), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_discard(pool, false), LOR_SUCCESS);
+    assert_int_equal(Lor_mem_pool_destroy(&pool), LOR_SUCCESS);
+}
 
 static int setup(void **state)
 {
@@ -150,6 +834,18 @@ int main(int argc, char *argv[])
         cmocka_unit_test(TEST_MEM_POOL_CONTAINS),
         cmocka_unit_test(TEST_MEM_POOL_STRDUP),
         cmocka_unit_test(TEST_MEM_POOL_COMBINE),
+        cmocka_unit_test(TEST_MEM_POOL_SLAB),
+        cmocka_unit_test(TEST_MEM_POOL_SHARED),
+        cmocka_unit_test(TEST_MEM_POOL_MMAP),
+        cmocka_unit_test(TEST_MEM_POOL_CONTAINS_INDEX),
+        cmocka_unit_test(TEST_MEM_POOL_REWIND),
+        cmocka_unit_test(TEST_MEM_POOL_COMBINE_REWIND),
+        cmocka_unit_test(TEST_MEM_POOL_PARTIAL_REUSE),
+        cmocka_unit_test(TEST_MEM_POOL_ALIGNED_ALLOC),
+        cmocka_unit_test(TEST_MEM_POOL_TRIM),
+        cmocka_unit_test(TEST_MEM_POOL_TRIM_REWIND),
+        cmocka_unit_test(TEST_MEM_POOL_FILE),
+        cmocka_unit_test(TEST_MEM_POOL_STRTAB),
     };
 
     return cmocka_run_group_tests(tests, setup, tear_down);
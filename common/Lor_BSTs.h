@@ -9,6 +9,11 @@
 
 #include <Lor_mem_pool.h>
 #include <Lor_AVLbst.h>
+#include <Lor_AVLnbst.h>
+#include <Lor_AVLpbst.h>
+#include <Lor_AVLcbst.h>
+#include <Lor_AVLibst.h>
+#include <Lor_AVLgen.h>
 
 enum {
     LOR_SUCCESS=0,
@@ -25,6 +30,17 @@ enum {
     LOR_FREE_NULLPTR_WARN,
     LOR_POSSIBLE_MEMLEAK_WARN,
     LOR_SRC_EMPTY_WARN,
+    LOR_NOT_POOL_BACKED_ERR,
+    LOR_INVALID_ALIGNMENT_ERR,
+    LOR_NOT_TRACKING_LIVE_ERR,
+    LOR_FILE_IO_ERR,
+    LOR_BAD_FILE_FORMAT_ERR,
+    LOR_READ_ONLY_ERR,
+    LOR_TREE_NOT_EMPTY_ERR,
+    LOR_UNSORTED_KEYS_ERR,
+    LOR_INCOMPATIBLE_TREES_ERR,
+    LOR_MAX_ITEMS_ERR,
+    LOR_NO_SUBTREE_SIZES_ERR,
 };
 
 #endif